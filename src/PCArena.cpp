@@ -0,0 +1,146 @@
+#include "PCArena.h"
+
+uint8_t *PCArena::_block = NULL;
+size_t PCArena::_capacity = 0;
+size_t PCArena::_used = 0;
+size_t PCArena::_highWaterMark = 0;
+size_t PCArena::_overflowBytes = 0;
+int PCArena::_numberOfAllocations = 0;
+boolean PCArena::_isInPSRAM = false;
+void **PCArena::_overflowBlocks = NULL;
+
+RTC_DATA_ATTR static size_t peakOfAllWakes = 0;
+
+boolean PCArena::begin(size_t internalSize, size_t psramSize)
+{
+    if (_block != NULL)
+        return true;
+    if (psramFound())
+    {
+        _block = (uint8_t *)heap_caps_malloc(psramSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        _capacity = psramSize;
+        _isInPSRAM = (_block != NULL);
+    }
+    if (_block == NULL)
+    {
+        _block = (uint8_t *)heap_caps_malloc(internalSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        _capacity = internalSize;
+    }
+    if (_block == NULL)
+    {
+        log_printf("Arena: failed to allocate %u bytes\n", (unsigned int)internalSize);
+        _capacity = 0;
+        return false;
+    }
+    _used = 0;
+    log_printf("Arena: %u bytes in %s\n", (unsigned int)_capacity, _isInPSRAM ? "PSRAM" : "internal RAM");
+    return true;
+}
+
+void *PCArena::allocate(size_t size, size_t alignment)
+{
+    _numberOfAllocations++;
+    if (_block != NULL)
+    {
+        size_t start = (_used + alignment - 1) & ~(alignment - 1);
+        if (start + size <= _capacity)
+        {
+            _used = start + size;
+            if (_used > _highWaterMark)
+            {
+                _highWaterMark = _used;
+            }
+            return _block + start;
+        }
+    }
+
+    // Overflow blocks are chained through their first word
+    size_t header = (sizeof(void *) + alignment - 1) & ~(alignment - 1);
+    void **overflow = (void **)malloc(header + size);
+    if (overflow == NULL)
+    {
+        log_printf("Arena: out of memory for %u bytes\n", (unsigned int)size);
+        return NULL;
+    }
+    *overflow = _overflowBlocks;
+    _overflowBlocks = overflow;
+    _overflowBytes += size;
+    return (uint8_t *)overflow + header;
+}
+
+const char *PCArena::copyString(const char *source, size_t length)
+{
+    char *copy = (char *)allocate(length + 1, 1);
+    if (copy == NULL)
+        return "";
+    memcpy(copy, source, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+void PCArena::release()
+{
+    if (_highWaterMark > peakOfAllWakes)
+    {
+        peakOfAllWakes = _highWaterMark;
+    }
+    if (_overflowBytes > 0)
+    {
+        log_printf("Arena: %u bytes overflowed to the heap\n", (unsigned int)_overflowBytes);
+    }
+    while (_overflowBlocks != NULL)
+    {
+        void **next = (void **)*_overflowBlocks;
+        free(_overflowBlocks);
+        _overflowBlocks = next;
+    }
+    _overflowBytes = 0;
+    _used = 0;
+}
+
+void PCArena::end()
+{
+    release();
+    if (_block != NULL)
+    {
+        heap_caps_free(_block);
+        _block = NULL;
+    }
+    _capacity = 0;
+    _isInPSRAM = false;
+}
+
+boolean PCArena::isInPSRAM()
+{
+    return _isInPSRAM;
+}
+
+size_t PCArena::capacity()
+{
+    return _capacity;
+}
+
+size_t PCArena::bytesUsed()
+{
+    return _used;
+}
+
+size_t PCArena::highWaterMark()
+{
+    return _highWaterMark;
+}
+
+size_t PCArena::highWaterMarkOfAllWakes()
+{
+    return max(peakOfAllWakes, _highWaterMark);
+}
+
+size_t PCArena::overflowBytes()
+{
+    return _overflowBytes;
+}
+
+int PCArena::numberOfAllocations()
+{
+    return _numberOfAllocations;
+}
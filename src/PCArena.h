@@ -0,0 +1,70 @@
+#ifndef PCARENA_H_INCLUDE
+#define PCARENA_H_INCLUDE
+
+#include <Arduino.h>
+#include <stddef.h>
+
+#define ARENA_INTERNAL_SIZE (48 * 1024)
+#define ARENA_PSRAM_SIZE (512 * 1024)
+#define ARENA_ALIGNMENT 4
+
+// Per-wake bump allocator for parse-time data.
+// One block is taken from PSRAM when present, so parsing does not fragment
+// the heap that TLS and the sprites need. Without PSRAM the block comes from
+// internal RAM after the network phase, the TLS buffers need that RAM first.
+// Everything is released at once with release(). Before begin() and when
+// the block is full, allocations fall back to the heap and are freed with
+// the arena.
+class PCArena
+{
+public:
+    static boolean begin(size_t internalSize = ARENA_INTERNAL_SIZE, size_t psramSize = ARENA_PSRAM_SIZE);
+    static void *allocate(size_t size, size_t alignment = ARENA_ALIGNMENT);
+    static const char *copyString(const char *source, size_t length);
+    static void release();
+    static void end();
+
+    static boolean isInPSRAM();
+    static size_t capacity();
+    static size_t bytesUsed();
+    static size_t highWaterMark();
+    static size_t highWaterMarkOfAllWakes();
+    static size_t overflowBytes();
+    static int numberOfAllocations();
+
+private:
+    static uint8_t *_block;
+    static size_t _capacity;
+    static size_t _used;
+    static size_t _highWaterMark;
+    static size_t _overflowBytes;
+    static int _numberOfAllocations;
+    static boolean _isInPSRAM;
+    static void **_overflowBlocks;
+};
+
+// std::allocator interface over PCArena for containers that live for one
+// wake. deallocate() is a no-op; memory comes back with PCArena::release().
+template <typename T>
+class PCArenaAllocator
+{
+public:
+    typedef T value_type;
+
+    PCArenaAllocator() {}
+    template <typename U>
+    PCArenaAllocator(const PCArenaAllocator<U> &) {}
+
+    T *allocate(size_t count)
+    {
+        return (T *)PCArena::allocate(count * sizeof(T), alignof(T) > ARENA_ALIGNMENT ? alignof(T) : ARENA_ALIGNMENT);
+    }
+    void deallocate(T *, size_t) {}
+};
+
+template <typename T, typename U>
+bool operator==(const PCArenaAllocator<T> &, const PCArenaAllocator<U> &) { return true; }
+template <typename T, typename U>
+bool operator!=(const PCArenaAllocator<T> &, const PCArenaAllocator<U> &) { return false; }
+
+#endif
@@ -0,0 +1,364 @@
+#include <climits>
+#include "PCBodyReader.h"
+
+#define MAX_RAW_LINE_LENGTH 256
+
+// A chunk-size line is hex digits, optionally followed by ";extension".
+// Anything else means the framing is lost.
+static boolean parseChunkSize(const String &line, long &size)
+{
+    const char *text = line.c_str();
+    if (!isxdigit((unsigned char)text[0]))
+        return false;
+    char *end;
+    size = strtol(text, &end, 16);
+    // strtol takes a "0x" prefix, which is not chunk framing
+    if (end != text + strspn(text, "0123456789abcdefABCDEF"))
+        return false;
+    while (*end == ' ' || *end == '\t')
+        end++;
+    return size >= 0 && size < LONG_MAX && (*end == '\0' || *end == ';');
+}
+
+PCBodyReader::PCBodyReader(Client *client, long contentLength, boolean chunked, size_t bufferSize)
+{
+    _client = client;
+    _stream = client;
+    _chunked = chunked;
+    _remaining = chunked ? -1 : contentLength;
+    _chunkRemaining = 0;
+    _complete = false;
+    _error = false;
+    _bytesRead = 0;
+    _bytesSkipped = 0;
+    _limit = 0;
+    _deadline = 0;
+    _bufferSize = bufferSize;
+    _buffer = new uint8_t[bufferSize];
+    _start = 0;
+    _end = 0;
+}
+
+PCBodyReader::PCBodyReader(Stream *stream, long contentLength, size_t bufferSize)
+{
+    _client = NULL;
+    _stream = stream;
+    _chunked = false;
+    _remaining = contentLength;
+    _chunkRemaining = 0;
+    _complete = false;
+    _error = false;
+    _bytesRead = 0;
+    _bytesSkipped = 0;
+    _limit = 0;
+    _deadline = 0;
+    _bufferSize = bufferSize;
+    _buffer = new uint8_t[bufferSize];
+    _start = 0;
+    _end = 0;
+}
+
+PCBodyReader::~PCBodyReader()
+{
+    delete[] _buffer;
+}
+
+int PCBodyReader::read(uint8_t *buffer, size_t length)
+{
+    if (_start >= _end && !fill())
+    {
+        return _error ? -1 : 0;
+    }
+    size_t count = min(length, _end - _start);
+    memcpy(buffer, _buffer + _start, count);
+    _start += count;
+    return count;
+}
+
+boolean PCBodyReader::readLine(String &line)
+{
+    line = "";
+    boolean terminated = false;
+    while (!terminated)
+    {
+        if (_start >= _end && !fill())
+        {
+            if (line.length() == 0)
+                return false;
+            break;
+        }
+        const uint8_t *begin = _buffer + _start;
+        const uint8_t *newline = (const uint8_t *)memchr(begin, '\n', _end - _start);
+        size_t length = newline ? newline - begin : _end - _start;
+        line.concat((const char *)begin, length);
+        _start += length;
+        if (newline)
+        {
+            _start++;
+            terminated = true;
+        }
+    }
+    if (line.endsWith("\r"))
+    {
+        line.remove(line.length() - 1);
+    }
+    return true;
+}
+
+// Reads at most size - 1 bytes of the next line into head, so a property
+// name can be checked without reading the whole line. complete is false
+// when the rest of the line is left for readLine() or skipLine().
+// Returns the number of bytes stored, or -1 at the end of the body.
+int PCBodyReader::readLineHead(char *head, size_t size, boolean &complete)
+{
+    size_t stored = 0;
+    complete = false;
+    while (stored < size - 1)
+    {
+        if (_start >= _end && !fill())
+        {
+            if (stored == 0)
+                return -1;
+            complete = true;
+            break;
+        }
+        char c = _buffer[_start++];
+        if (c == '\n')
+        {
+            complete = true;
+            break;
+        }
+        head[stored++] = c;
+    }
+    if (complete && stored > 0 && head[stored - 1] == '\r')
+    {
+        stored--;
+    }
+    head[stored] = '\0';
+    return stored;
+}
+
+// Skips the rest of the line with a byte search over the buffer
+boolean PCBodyReader::skipLine()
+{
+    while (true)
+    {
+        if (_start >= _end && !fill())
+            return false;
+        const uint8_t *begin = _buffer + _start;
+        const uint8_t *newline = (const uint8_t *)memchr(begin, '\n', _end - _start);
+        if (newline)
+        {
+            _bytesSkipped += newline - begin + 1;
+            _start += newline - begin + 1;
+            return true;
+        }
+        _bytesSkipped += _end - _start;
+        _start = _end;
+    }
+}
+
+boolean PCBodyReader::drain()
+{
+    _start = _end;
+    while (fill())
+    {
+        _start = _end;
+    }
+    return _complete;
+}
+
+// Stops reading with an error, for a body that turned out to be invalid
+void PCBodyReader::abort()
+{
+    _start = _end;
+    _error = true;
+}
+
+// Reading stops with an error once maxBytes have arrived, 0 for no limit
+void PCBodyReader::setLimit(size_t maxBytes)
+{
+    _limit = maxBytes;
+}
+
+// Reading stops with an error at millis() deadlineMillis, 0 for no deadline.
+// A server sending a few bytes at a time never reaches BODY_TIMEOUT_MS.
+void PCBodyReader::setDeadline(unsigned long deadlineMillis)
+{
+    _deadline = deadlineMillis;
+}
+
+boolean PCBodyReader::isComplete()
+{
+    return _complete;
+}
+
+boolean PCBodyReader::hasError()
+{
+    return _error;
+}
+
+size_t PCBodyReader::bytesRead()
+{
+    return _bytesRead;
+}
+
+size_t PCBodyReader::bytesSkipped()
+{
+    return _bytesSkipped;
+}
+
+boolean PCBodyReader::fill()
+{
+    _start = 0;
+    _end = 0;
+    if (_complete || _error)
+        return false;
+    if (isPastDeadline())
+    {
+        _error = true;
+        return false;
+    }
+
+    size_t wanted = _bufferSize;
+    if (_chunked)
+    {
+        if (_chunkRemaining == 0)
+        {
+            String sizeLine;
+            if (!readRawLine(sizeLine) || !parseChunkSize(sizeLine, _chunkRemaining))
+            {
+                _error = true;
+                return false;
+            }
+            if (_chunkRemaining == 0)
+            {
+                // Last chunk: skip trailers up to the terminating empty line
+                String trailer;
+                do
+                {
+                    if (!readRawLine(trailer))
+                    {
+                        _error = true;
+                        return false;
+                    }
+                } while (trailer.length() > 0);
+                _complete = true;
+                return false;
+            }
+        }
+        wanted = min(wanted, (size_t)_chunkRemaining);
+    }
+    else if (_remaining >= 0)
+    {
+        if (_remaining == 0)
+        {
+            _complete = true;
+            return false;
+        }
+        wanted = min(wanted, (size_t)_remaining);
+    }
+
+    if (_limit > 0)
+    {
+        if (_bytesRead >= _limit)
+        {
+            _error = true;
+            return false;
+        }
+        wanted = min(wanted, _limit - _bytesRead);
+    }
+
+    size_t received = readRaw(_buffer, wanted);
+    if (received == 0)
+    {
+        if (!_chunked && _remaining < 0 && !isPastDeadline())
+        { // body delimited by connection close
+            _complete = true;
+        }
+        else
+        {
+            _error = true;
+        }
+        return false;
+    }
+    _end = received;
+    _bytesRead += received;
+
+    if (_chunked)
+    {
+        _chunkRemaining -= received;
+        if (_chunkRemaining == 0)
+        { // CRLF after chunk data, the data read so far is still returned
+            String crlf;
+            if (!readRawLine(crlf) || crlf.length() > 0)
+                _error = true;
+        }
+    }
+    else if (_remaining > 0)
+    {
+        _remaining -= received;
+    }
+    return true;
+}
+
+size_t PCBodyReader::readRaw(uint8_t *buffer, size_t length)
+{
+    if (_client == NULL)
+    {
+        return _stream->readBytes((char *)buffer, length);
+    }
+
+    size_t total = 0;
+    unsigned long lastMillis = millis();
+    while (total < length)
+    {
+        int available = _client->available();
+        if (available > 0)
+        {
+            int received = _client->read(buffer + total, min((size_t)available, length - total));
+            if (received > 0)
+            {
+                total += received;
+                lastMillis = millis();
+                continue;
+            }
+        }
+        else if (!_client->connected())
+        {
+            break;
+        }
+        if (total > 0 || millis() - lastMillis > BODY_TIMEOUT_MS || isPastDeadline())
+        {
+            break;
+        }
+        delay(1);
+    }
+    return total;
+}
+
+// False when the connection ends or the line is longer than any framing line
+boolean PCBodyReader::readRawLine(String &line)
+{
+    line = "";
+    uint8_t c;
+    while (line.length() < MAX_RAW_LINE_LENGTH)
+    {
+        if (readRaw(&c, 1) != 1)
+        {
+            return false;
+        }
+        if (c == '\n')
+        {
+            line.trim();
+            return true;
+        }
+        line += (char)c;
+    }
+    return false;
+}
+
+boolean PCBodyReader::isPastDeadline()
+{
+    return _deadline != 0 && (long)(millis() - _deadline) >= 0;
+}
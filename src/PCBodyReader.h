@@ -0,0 +1,57 @@
+#ifndef PCBODYREADER_H_INCLUDE
+#define PCBODYREADER_H_INCLUDE
+
+#include <Arduino.h>
+#include <Client.h>
+
+#define BODY_BUFFER_SIZE 1460
+#define BODY_TIMEOUT_MS 10000
+
+// Reads an HTTP response body with exact framing.
+// Content-Length and chunked bodies are consumed up to their last byte and
+// never beyond, so the connection can carry the next request.
+class PCBodyReader
+{
+public:
+    PCBodyReader(Client *client, long contentLength, boolean chunked, size_t bufferSize = BODY_BUFFER_SIZE);
+    PCBodyReader(Stream *stream, long contentLength, size_t bufferSize = BODY_BUFFER_SIZE);
+    ~PCBodyReader();
+    int read(uint8_t *buffer, size_t length);
+    boolean readLine(String &line);
+    int readLineHead(char *head, size_t size, boolean &complete);
+    boolean skipLine();
+    boolean drain();
+    void abort();
+    void setLimit(size_t maxBytes);
+    void setDeadline(unsigned long deadlineMillis);
+    boolean isComplete();
+    boolean hasError();
+    size_t bytesRead();
+    size_t bytesSkipped();
+
+private:
+    PCBodyReader(const PCBodyReader &);
+    PCBodyReader &operator=(const PCBodyReader &);
+    boolean fill();
+    size_t readRaw(uint8_t *buffer, size_t length);
+    boolean readRawLine(String &line);
+    boolean isPastDeadline();
+
+    Client *_client;
+    Stream *_stream;
+    boolean _chunked;
+    long _remaining;
+    long _chunkRemaining;
+    boolean _complete;
+    boolean _error;
+    size_t _bytesRead;
+    size_t _bytesSkipped;
+    size_t _limit;
+    unsigned long _deadline;
+    uint8_t *_buffer;
+    size_t _bufferSize;
+    size_t _start;
+    size_t _end;
+};
+
+#endif
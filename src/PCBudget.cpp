@@ -0,0 +1,79 @@
+#include "PCBudget.h"
+#include "PCLog.h"
+#include <limits.h>
+
+unsigned long PCBudget::_wakeDeadline = BUDGET_NO_DEADLINE;
+unsigned long PCBudget::_deadline = BUDGET_NO_DEADLINE;
+unsigned long PCBudget::_phaseStart = 0;
+uint8_t PCBudget::_phase = BUDGET_PHASE_WIFI;
+int PCBudget::_index = 0;
+int PCBudget::_numberOfOverruns = 0;
+
+static const char *phaseNames[] = {"WiFi", "feed", "holidays"};
+
+// 0 for no wake deadline
+void PCBudget::begin(uint32_t wakeSeconds)
+{
+    _wakeDeadline = BUDGET_NO_DEADLINE;
+    if (wakeSeconds > 0)
+    {
+        unsigned long wakeMillis = wakeSeconds * 1000UL;
+        // A deadline inside the reserve leaves the network phases a moment each
+        _wakeDeadline = wakeMillis > BUDGET_RENDER_RESERVE_MS ? wakeMillis - BUDGET_RENDER_RESERVE_MS : 1;
+    }
+    _deadline = BUDGET_NO_DEADLINE;
+    _numberOfOverruns = 0;
+}
+
+// The phase ends at the given seconds from now, 0 for no limit of its own,
+// or at the wake deadline if that comes first
+void PCBudget::startPhase(uint8_t phase, int index, uint32_t seconds)
+{
+    _phase = phase;
+    _index = index;
+    _phaseStart = millis();
+    _deadline = (seconds > 0) ? _phaseStart + seconds * 1000UL : BUDGET_NO_DEADLINE;
+    if (_wakeDeadline != BUDGET_NO_DEADLINE && (_deadline == BUDGET_NO_DEADLINE || (long)(_deadline - _wakeDeadline) > 0))
+    {
+        _deadline = _wakeDeadline;
+    }
+}
+
+// Returns true when the phase ran out of its budget
+boolean PCBudget::endPhase(size_t bytes)
+{
+    boolean overrun = isExpired();
+    if (overrun)
+    {
+        unsigned long elapsed = millis() - _phaseStart;
+        _numberOfOverruns++;
+        log_printf("Budget of %s %d ran out after %lu ms, %u bytes\n", phaseNames[_phase], _index, elapsed, (unsigned int)bytes);
+        PCLog::record(LOG_INFO, LOG_BUDGET, _phase, _index, elapsed, bytes);
+    }
+    _deadline = BUDGET_NO_DEADLINE;
+    return overrun;
+}
+
+// millis() at the end of the current phase, BUDGET_NO_DEADLINE for none
+unsigned long PCBudget::deadline()
+{
+    return _deadline;
+}
+
+unsigned long PCBudget::remainingMillis()
+{
+    if (_deadline == BUDGET_NO_DEADLINE)
+        return ULONG_MAX;
+    long remaining = (long)(_deadline - millis());
+    return remaining > 0 ? remaining : 0;
+}
+
+boolean PCBudget::isExpired()
+{
+    return remainingMillis() == 0;
+}
+
+int PCBudget::numberOfOverruns()
+{
+    return _numberOfOverruns;
+}
@@ -0,0 +1,38 @@
+#ifndef PCBUDGET_H_INCLUDE
+#define PCBUDGET_H_INCLUDE
+
+#include <Arduino.h>
+
+#define BUDGET_PHASE_WIFI 0
+#define BUDGET_PHASE_FEED 1
+#define BUDGET_PHASE_HOLIDAYS 2
+#define BUDGET_RENDER_RESERVE_MS 25000 // drawing and the panel refresh after the network phases
+#define BUDGET_NO_DEADLINE 0
+
+// Time budget of a wake.
+// The wake deadline counts from boot and ends the network phases early
+// enough to draw and refresh the panel. Each phase (WiFi, one feed, holidays)
+// gets its own budget within what is left, and its deadline is enforced by
+// the socket timeouts and the body reader. A phase still running at its
+// deadline is recorded as an overrun with the bytes it had read.
+class PCBudget
+{
+public:
+    static void begin(uint32_t wakeSeconds);
+    static void startPhase(uint8_t phase, int index, uint32_t seconds);
+    static boolean endPhase(size_t bytes);
+    static unsigned long deadline();
+    static unsigned long remainingMillis();
+    static boolean isExpired();
+    static int numberOfOverruns();
+
+private:
+    static unsigned long _wakeDeadline;
+    static unsigned long _deadline;
+    static unsigned long _phaseStart;
+    static uint8_t _phase;
+    static int _index;
+    static int _numberOfOverruns;
+};
+
+#endif
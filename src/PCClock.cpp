@@ -0,0 +1,208 @@
+#include "PCClock.h"
+#include "PCLog.h"
+#include "esp_sntp.h"
+#include "esp_timer.h"
+
+#define MICROS_IN_SECOND 1000000LL
+#define HTTP_DATE_OFFSET 500000 // Date headers are truncated to the second
+
+RTC_DATA_ATTR static boolean hasSync = false;
+RTC_DATA_ATTR static int64_t syncMicros = 0; // the system clock was set to server time here
+RTC_DATA_ATTR static boolean hasCalibrationPoint = false;
+RTC_DATA_ATTR static int64_t calibrationServerMicros = 0;
+RTC_DATA_ATTR static int64_t calibrationSystemMicros = 0;
+RTC_DATA_ATTR static int64_t stepsSinceCalibration = 0; // clock steps made after the calibration point
+RTC_DATA_ATTR static int32_t correctionPPM = 0;
+RTC_DATA_ATTR static int32_t savedPPM = 0;
+RTC_DATA_ATTR static int32_t numberOfSamples = 0;
+RTC_DATA_ATTR static int64_t expectedWakeMicros = 0;
+RTC_DATA_ATTR static int32_t wakeErrorMillis = 0;
+
+static int64_t referenceMicros = 0; // the moment PCEvent::currentTimeinfo shows
+static boolean syncedThisWake = false;
+static boolean syncedBySNTP = false;
+static String sntpServer;
+
+// SNTP answers on the lwIP task, the clock is changed on the main task
+static portMUX_TYPE pendingLock = portMUX_INITIALIZER_UNLOCKED;
+static volatile boolean hasPendingSNTP = false;
+static int64_t pendingServerMicros = 0;
+static int64_t pendingSystemMicros = 0;
+
+static int64_t systemMicros()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * MICROS_IN_SECOND + tv.tv_usec;
+}
+
+// System time with the drift since the last sync taken out
+static int64_t estimatedMicros()
+{
+    int64_t system = systemMicros();
+    if (!hasSync || correctionPPM == 0)
+        return system;
+    return syncMicros + (int64_t)((system - syncMicros) / (1.0 + correctionPPM / 1000000.0));
+}
+
+static void synchronize(int64_t serverMicros, boolean fromSNTP)
+{
+    int64_t system = systemMicros();
+    int64_t estimate = estimatedMicros();
+
+    // Where the last sleep really ended
+    if (!syncedThisWake && expectedWakeMicros != 0)
+    {
+        int64_t wakeMicros = serverMicros - esp_timer_get_time();
+        wakeErrorMillis = (int32_t)((wakeMicros - expectedWakeMicros) / 1000);
+        expectedWakeMicros = 0;
+    }
+
+    // Compare the time both clocks counted since the calibration point
+    if (hasCalibrationPoint)
+    {
+        int64_t elapsedServer = serverMicros - calibrationServerMicros;
+        int64_t elapsedSystem = system - stepsSinceCalibration - calibrationSystemMicros;
+        if (elapsedServer >= MIN_CALIBRATION_SECONDS * MICROS_IN_SECOND)
+        {
+            int64_t sample = (elapsedSystem - elapsedServer) * 1000000LL / elapsedServer;
+            if (sample > -MAX_DRIFT_PPM && sample < MAX_DRIFT_PPM)
+            {
+                if (numberOfSamples == 0)
+                    correctionPPM = (int32_t)sample;
+                else
+                    correctionPPM += ((int32_t)sample - correctionPPM) / CLOCK_SAMPLE_WEIGHT;
+                numberOfSamples++;
+            }
+            else
+            {
+                log_printf("Clock sample %lld ppm ignored\n", sample);
+            }
+            hasCalibrationPoint = false;
+        }
+    }
+    if (!hasCalibrationPoint)
+    {
+        calibrationServerMicros = serverMicros;
+        calibrationSystemMicros = system;
+        stepsSinceCalibration = 0;
+        hasCalibrationPoint = true;
+    }
+
+    int64_t step = serverMicros - system;
+    struct timeval now = {.tv_sec = (time_t)(serverMicros / MICROS_IN_SECOND), .tv_usec = (suseconds_t)(serverMicros % MICROS_IN_SECOND)};
+    settimeofday(&now, NULL);
+    stepsSinceCalibration += step;
+    referenceMicros += serverMicros - estimate;
+    syncMicros = serverMicros;
+    hasSync = true;
+    syncedThisWake = true;
+    syncedBySNTP = syncedBySNTP || fromSNTP;
+    log_printf("Clock set by %s: step %lld ms, drift %d ppm, wake error %d ms\n", fromSNTP ? "SNTP" : "HTTP", step / 1000, correctionPPM, wakeErrorMillis);
+    PCLog::record(LOG_INFO, LOG_CLOCK, (int32_t)(step / 1000), correctionPPM, wakeErrorMillis, fromSNTP);
+}
+
+static void applyPendingSNTP()
+{
+    if (!hasPendingSNTP)
+        return;
+    portENTER_CRITICAL(&pendingLock);
+    int64_t serverMicros = pendingServerMicros;
+    int64_t receivedMicros = pendingSystemMicros;
+    hasPendingSNTP = false;
+    portEXIT_CRITICAL(&pendingLock);
+    synchronize(serverMicros + (systemMicros() - receivedMicros), true);
+}
+
+// Replaces the weak default in lwIP, which sets the clock directly
+extern "C" void sntp_sync_time(struct timeval *tv)
+{
+    int64_t system = systemMicros();
+    portENTER_CRITICAL(&pendingLock);
+    pendingServerMicros = (int64_t)tv->tv_sec * MICROS_IN_SECOND + tv->tv_usec;
+    pendingSystemMicros = system;
+    hasPendingSNTP = true;
+    portEXIT_CRITICAL(&pendingLock);
+    sntp_set_sync_status(SNTP_SYNC_STATUS_COMPLETED);
+}
+
+void PCClock::begin(Preferences &pref, boolean timerWake)
+{
+    // Other resets start the system clock over
+    if (!timerWake)
+    {
+        hasSync = false;
+        hasCalibrationPoint = false;
+        expectedWakeMicros = 0;
+        wakeErrorMillis = 0;
+    }
+    if (numberOfSamples == 0)
+    {
+        int32_t ppm = pref.getInt(CLOCK_PPM_KEY, 0);
+        if (ppm > -MAX_DRIFT_PPM && ppm < MAX_DRIFT_PPM)
+        {
+            correctionPPM = ppm;
+            savedPPM = ppm;
+            numberOfSamples = (ppm != 0) ? 1 : 0;
+        }
+    }
+    syncedThisWake = false;
+    syncedBySNTP = false;
+    referenceMicros = estimatedMicros() / MICROS_IN_SECOND * MICROS_IN_SECOND;
+}
+
+void PCClock::save(Preferences &pref)
+{
+    if (abs(correctionPPM - savedPPM) >= CLOCK_PPM_SAVE_STEP)
+    {
+        pref.putInt(CLOCK_PPM_KEY, correctionPPM);
+        savedPPM = correctionPPM;
+    }
+}
+
+// Runs in parallel with the feed requests, the first answer wins over HTTP dates
+void PCClock::startSNTP(String server)
+{
+    if (server.isEmpty())
+        return;
+    sntpServer = server; // lwIP keeps the pointer
+    configTime(0, 0, sntpServer.c_str());
+}
+
+// The Date header of the first feed sets the moment the schedule counts from
+void PCClock::setHTTPDate(time_t seconds)
+{
+    applyPendingSNTP();
+    if (!syncedBySNTP)
+        synchronize((int64_t)seconds * MICROS_IN_SECOND + HTTP_DATE_OFFSET, false);
+    referenceMicros = (int64_t)seconds * MICROS_IN_SECOND;
+}
+
+time_t PCClock::now()
+{
+    applyPendingSNTP();
+    return (time_t)(estimatedMicros() / MICROS_IN_SECOND);
+}
+
+// Timer duration that ends the given seconds after the current time info.
+// Time spent awake since then is taken off and the drift is added.
+uint64_t PCClock::sleepMicros(int seconds)
+{
+    applyPendingSNTP();
+    int64_t now = estimatedMicros();
+    int64_t target = referenceMicros + (int64_t)seconds * MICROS_IN_SECOND;
+    if (target - now < MIN_SLEEP_SECONDS * MICROS_IN_SECOND)
+        target = now + MIN_SLEEP_SECONDS * MICROS_IN_SECOND;
+    expectedWakeMicros = hasSync ? target : 0;
+    return (uint64_t)((target - now) * (1.0 + correctionPPM / 1000000.0));
+}
+
+int32_t PCClock::driftPPM()
+{
+    return correctionPPM;
+}
+
+int32_t PCClock::lastWakeErrorMillis()
+{
+    return wakeErrorMillis;
+}
@@ -0,0 +1,37 @@
+#ifndef PCCLOCK_H_INCLUDE
+#define PCCLOCK_H_INCLUDE
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <sys/time.h>
+
+#define CLOCK_PPM_KEY "ClockPPM"
+#define CLOCK_PPM_SAVE_STEP 10      // NVS is written only when the factor moves this much
+#define MIN_CALIBRATION_SECONDS 3600 // HTTP dates have 1 s resolution
+#define MAX_DRIFT_PPM 50000          // larger samples mean the clock was reset, not drift
+#define CLOCK_SAMPLE_WEIGHT 4        // a new sample moves the factor by 1/4 of the difference
+#define MIN_SLEEP_SECONDS 10
+
+// System clock kept against server time across deep sleep.
+// Deep sleep and the system clock both count on the RTC slow clock, which
+// runs fast or slow by a different amount on each unit. At each sync the time
+// the system clock counted since a calibration point is compared with the
+// time the server counted, and the ratio is kept in RTC memory and NVS as
+// parts per million. Sleep durations and the time of offline wakes are
+// corrected by it.
+// The HTTP Date header of the first feed is the default time source. SNTP
+// replaces it for the wake once it answers.
+class PCClock
+{
+public:
+    static void begin(Preferences &pref, boolean timerWake);
+    static void save(Preferences &pref);
+    static void startSNTP(String server);
+    static void setHTTPDate(time_t seconds);
+    static time_t now();
+    static uint64_t sleepMicros(int seconds);
+    static int32_t driftPPM();
+    static int32_t lastWakeErrorMillis();
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <map>
+#include <string>
+
+#include "PCCompact.h"
+#include "PCArena.h"
+#include "PCEvent.h"
+
+#define SECONDS_IN_DAY 86400
+
+static uint32_t fnv1a(uint32_t hash, const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= data[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+PCCompactReader::PCCompactReader(PCBodyReader &reader) : _reader(reader)
+{
+    memset(&_header, 0, sizeof(_header));
+    _titles = NULL;
+    _dayIndex = NULL;
+    _eventsRead = 0;
+}
+
+// Reads everything before the events
+boolean PCCompactReader::begin()
+{
+    if (!readFully(&_header, sizeof(_header)))
+        return false;
+    if (_header.magic != COMPACT_MAGIC || _header.version != COMPACT_VERSION || _header.eventSize != sizeof(PCCompactEvent) ||
+        _header.numberOfDays > COMPACT_MAX_DAYS || _header.titleBytes > COMPACT_MAX_TITLE_BYTES)
+    {
+        log_printf("Not a compact payload of version %d\n", COMPACT_VERSION);
+        return false;
+    }
+    _titles = (char *)PCArena::allocate(_header.titleBytes + 1, 1);
+    _dayIndex = (uint32_t *)PCArena::allocate((_header.numberOfDays + 1) * sizeof(uint32_t));
+    if (_titles == NULL || _dayIndex == NULL)
+        return false;
+    if (!readFully(_titles, _header.titleBytes) || !readFully(_dayIndex, (_header.numberOfDays + 1) * sizeof(uint32_t)))
+        return false;
+    // A title table cut short still ends in a string
+    _titles[_header.titleBytes] = '\0';
+    return true;
+}
+
+boolean PCCompactReader::next(PCCompactEvent &event)
+{
+    if (_eventsRead >= _header.numberOfEvents || !readFully(&event, sizeof(event)))
+        return false;
+    _eventsRead++;
+    if (event.title >= _header.titleBytes)
+        event.title = _header.titleBytes;
+    return true;
+}
+
+const char *PCCompactReader::titleAt(uint32_t offset)
+{
+    return _titles + min(offset, _header.titleBytes);
+}
+
+// Events after this count start at or after localTime, so they can be left unread
+uint32_t PCCompactReader::eventsStartingBefore(time_t localTime)
+{
+    if (_dayIndex == NULL || localTime < (time_t)_header.firstDay)
+        return 0;
+    uint32_t day = (localTime - _header.firstDay + SECONDS_IN_DAY - 1) / SECONDS_IN_DAY;
+    if (day > _header.numberOfDays)
+        return _header.numberOfEvents;
+    return min(_dayIndex[day], _header.numberOfEvents);
+}
+
+const PCCompactHeader &PCCompactReader::header()
+{
+    return _header;
+}
+
+const uint32_t *PCCompactReader::dayIndex()
+{
+    return _dayIndex;
+}
+
+boolean PCCompactReader::isCompactURL(String urlString)
+{
+    return urlString.endsWith(COMPACT_URL_SUFFIX);
+}
+
+boolean PCCompactReader::readFully(void *buffer, size_t length)
+{
+    uint8_t *position = (uint8_t *)buffer;
+    while (length > 0)
+    {
+        int received = _reader.read(position, length);
+        if (received <= 0)
+            return false;
+        position += received;
+        length -= received;
+    }
+    return true;
+}
+
+static void append(std::vector<uint8_t> &payload, const void *data, size_t length)
+{
+    payload.insert(payload.end(), (const uint8_t *)data, (const uint8_t *)data + length);
+}
+
+// Events and holidays overlapping the window of PCEvent, sorted by start
+// and title, each title stored once
+std::vector<uint8_t> PCCompactWriter::build()
+{
+    time_t windowStart = PCEvent::windowStart();
+    time_t windowEnd = PCEvent::windowEnd();
+    std::vector<PCEvent> events = PCEvent::eventsInRange(windowStart, windowEnd);
+    std::vector<PCEvent> holidays = PCEvent::holidaysInRange(windowStart, windowEnd);
+    events.insert(events.end(), holidays.begin(), holidays.end());
+
+    std::vector<std::pair<PCCompactEvent, std::string>> titled;
+    for (auto &event : events)
+    {
+        time_t start = event.getStartTime();
+        time_t duration = max(event.getEndTime() - start, (time_t)0);
+        if (start + max(duration, (time_t)1) <= windowStart || start >= windowEnd)
+            continue;
+        PCCompactEvent compactEvent = {};
+        compactEvent.start = start;
+        compactEvent.duration = duration;
+        compactEvent.uidHash = event.getUIDHash();
+        compactEvent.recurrenceID = event.getRecurrenceID();
+        compactEvent.flags = (event.isDayEvent() ? COMPACT_DAY_EVENT : 0) | (event.isHolidayEvent ? COMPACT_HOLIDAY : 0);
+        titled.push_back(std::make_pair(compactEvent, std::string(event.getTitle().c_str())));
+    }
+    std::stable_sort(titled.begin(), titled.end(), [](const std::pair<PCCompactEvent, std::string> &left, const std::pair<PCCompactEvent, std::string> &right) {
+        return left.first.start != right.first.start ? left.first.start < right.first.start : left.second < right.second;
+    });
+
+    std::vector<uint8_t> titles;
+    std::map<std::string, uint32_t> titleOffsets;
+    std::vector<PCCompactEvent> compactEvents;
+    for (auto &event : titled)
+    {
+        auto found = titleOffsets.find(event.second);
+        if (found == titleOffsets.end())
+        {
+            found = titleOffsets.insert(std::make_pair(event.second, (uint32_t)titles.size())).first;
+            append(titles, event.second.c_str(), event.second.size() + 1);
+        }
+        event.first.title = found->second;
+        compactEvents.push_back(event.first);
+    }
+
+    PCCompactHeader header = {};
+    header.magic = COMPACT_MAGIC;
+    header.version = COMPACT_VERSION;
+    header.eventSize = sizeof(PCCompactEvent);
+    header.timezoneMinutes = round(PCEvent::defaultTimezone * 60);
+    header.month = PCEvent::currentYear * 100 + PCEvent::currentMonth;
+    header.firstDay = windowStart;
+    header.numberOfDays = (windowEnd - windowStart) / SECONDS_IN_DAY;
+    header.numberOfEvents = compactEvents.size();
+    header.titleBytes = titles.size();
+
+    std::vector<uint8_t> body = titles;
+    size_t position = 0;
+    for (int day = 0; day <= header.numberOfDays; day++)
+    {
+        while (position < compactEvents.size() && compactEvents[position].start < windowStart + day * SECONDS_IN_DAY)
+            position++;
+        uint32_t count = position;
+        append(body, &count, sizeof(count));
+    }
+    append(body, compactEvents.data(), compactEvents.size() * sizeof(PCCompactEvent));
+    header.contentHash = fnv1a(2166136261UL, body.data(), body.size());
+
+    std::vector<uint8_t> payload;
+    append(payload, &header, sizeof(header));
+    append(payload, body.data(), body.size());
+    return payload;
+}
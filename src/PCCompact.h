@@ -0,0 +1,88 @@
+#ifndef PCCOMPACT_H_INCLUDE
+#define PCCOMPACT_H_INCLUDE
+
+#include <Arduino.h>
+#include <time.h>
+#include <vector>
+
+#include "PCBodyReader.h"
+
+#define COMPACT_MAGIC 0x4C414350 // "PCAL"
+#define COMPACT_VERSION 1
+#define COMPACT_URL_SUFFIX ".pcal"
+#define COMPACT_MAX_DAYS 70
+#define COMPACT_MAX_TITLE_BYTES (64 * 1024)
+
+// Event flags
+#define COMPACT_DAY_EVENT 0x01
+#define COMPACT_HOLIDAY 0x02
+
+// All fields little endian, written by PCCompactWriter.
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t eventSize;
+    int32_t timezoneMinutes; // times are local to this offset
+    uint32_t month;          // 202410, the month the payload was built for
+    uint32_t firstDay;       // local seconds of the first day in the index
+    uint16_t numberOfDays;
+    uint16_t reserved;
+    uint32_t numberOfEvents;
+    uint32_t titleBytes;
+    uint32_t contentHash; // FNV-1a of everything after the header
+} PCCompactHeader;
+
+typedef struct
+{
+    uint32_t start;        // local seconds, midnight for day events
+    uint32_t duration;     // seconds
+    uint32_t title;        // offset in the title table
+    uint32_t uidHash;      // FNV-1a of UID, 0 for none
+    uint32_t recurrenceID; // original start of a recurrence instance, 0 for single events
+    uint8_t flags;
+    uint8_t reserved[3];
+} PCCompactEvent;
+
+// Reader of the compact month payload built by tools/pcal.
+// The host has already expanded recurrences, applied overrides and
+// converted times, so events are read as they are. A payload is:
+//  header, title table (NUL terminated, shared by events with the same title),
+//  day index (numberOfDays + 1 counts of events starting before each day),
+//  events sorted by start.
+// Titles and the day index are kept in the arena until PCArena::release().
+class PCCompactReader
+{
+public:
+    PCCompactReader(PCBodyReader &reader);
+    boolean begin();
+    boolean next(PCCompactEvent &event);
+    const char *titleAt(uint32_t offset);
+    uint32_t eventsStartingBefore(time_t localTime);
+    const PCCompactHeader &header();
+    const uint32_t *dayIndex();
+
+    static boolean isCompactURL(String urlString);
+
+private:
+    PCCompactReader(const PCCompactReader &);
+    PCCompactReader &operator=(const PCCompactReader &);
+    boolean readFully(void *buffer, size_t length);
+
+    PCBodyReader &_reader;
+    PCCompactHeader _header;
+    char *_titles;
+    uint32_t *_dayIndex;
+    uint32_t _eventsRead;
+};
+
+// Writer of the payload for the host compiler in tools/pcal. The events are
+// the ones PCEvent built from parsed feeds for the month of setTimeinfo(),
+// so recurrences are expanded by the same PCRecurrence as on the device.
+class PCCompactWriter
+{
+public:
+    static std::vector<uint8_t> build();
+};
+
+#endif
@@ -0,0 +1,432 @@
+#include "PCConnection.h"
+#include "PCBudget.h"
+
+#define DNS_CACHE_SIZE 4
+#define DEFAULT_DNS_TTL 3600
+#define CONNECTION_POOL_SIZE 2
+#define RESPONSE_TIMEOUT_MS 10000
+#define HANDSHAKE_TIMEOUT_MS 30000
+
+// Resolved host addresses kept across deep sleep.
+// lwIP does not expose record TTLs, so entries expire after a configured TTL
+// measured on the RTC clock, which keeps running in deep sleep.
+typedef struct
+{
+    uint32_t hostHash;
+    uint32_t address;
+    time_t expires;
+} PCDNSCacheEntry;
+
+RTC_DATA_ATTR static PCDNSCacheEntry dnsCache[DNS_CACHE_SIZE];
+
+// Idle keep-alive connections
+typedef struct
+{
+    uint32_t hostHash;
+    uint16_t port;
+    WiFiClient *client;
+    boolean inUse;
+} PCPooledConnection;
+
+static PCPooledConnection connectionPool[CONNECTION_POOL_SIZE];
+
+uint32_t PCConnection::_dnsTTL = DEFAULT_DNS_TTL;
+boolean PCConnection::_lastOpenWasReused = false;
+int PCConnection::_numberOfReusedConnections = 0;
+unsigned long PCConnection::_lastDNSMillis = 0;
+unsigned long PCConnection::_lastHandshakeMillis = 0;
+unsigned long PCConnection::_totalHandshakeMillis = 0;
+int PCConnection::_numberOfHandshakes = 0;
+boolean PCConnection::_lastHandshakeWasResumed = false;
+int PCConnection::_numberOfResumedHandshakes = 0;
+unsigned long PCConnection::_totalResumedHandshakeMillis = 0;
+int PCConnection::_numberOfDNSCacheHits = 0;
+
+static uint32_t hashOfHost(String host)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261UL;
+    for (int i = 0; i < host.length(); i++)
+    {
+        hash ^= (uint8_t)tolower(host.charAt(i));
+        hash *= 16777619UL;
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+boolean parseURL(String urlString, String &host, uint16_t &port, String &path, boolean &secure)
+{
+    int schemeEnd = urlString.indexOf("://");
+    if (schemeEnd < 0)
+        return false;
+    String scheme = urlString.substring(0, schemeEnd);
+    secure = (scheme == "https");
+    port = secure ? 443 : 80;
+
+    int hostStart = schemeEnd + 3;
+    int pathStart = urlString.indexOf('/', hostStart);
+    if (pathStart < 0)
+    {
+        host = urlString.substring(hostStart);
+        path = "/";
+    }
+    else
+    {
+        host = urlString.substring(hostStart, pathStart);
+        path = urlString.substring(pathStart);
+    }
+    int atLocation = host.indexOf('@');
+    if (atLocation >= 0)
+    {
+        host = host.substring(atLocation + 1);
+    }
+    int portLocation = host.indexOf(':');
+    if (portLocation >= 0)
+    {
+        port = host.substring(portLocation + 1).toInt();
+        host = host.substring(0, portLocation);
+    }
+    return !host.isEmpty();
+}
+
+void PCConnection::setDNSTTL(uint32_t seconds)
+{
+    _dnsTTL = seconds;
+}
+
+boolean PCConnection::resolve(String host, IPAddress &address)
+{
+    unsigned long startMillis = millis();
+    uint32_t hostHash = hashOfHost(host);
+    time_t now = time(NULL);
+
+    PCDNSCacheEntry *freeEntry = &dnsCache[0];
+    for (int i = 0; i < DNS_CACHE_SIZE; i++)
+    {
+        PCDNSCacheEntry *entry = &dnsCache[i];
+        if (entry->hostHash == hostHash && entry->expires > now)
+        {
+            address = IPAddress(entry->address);
+            _numberOfDNSCacheHits++;
+            _lastDNSMillis = 0;
+            return true;
+        }
+        if (entry->hostHash == hostHash || entry->expires < freeEntry->expires)
+        {
+            freeEntry = entry;
+        }
+    }
+
+    if (WiFi.hostByName(host.c_str(), address) != 1)
+    {
+        _lastDNSMillis = millis() - startMillis;
+        return false;
+    }
+    freeEntry->hostHash = hostHash;
+    freeEntry->address = address;
+    freeEntry->expires = now + _dnsTTL;
+    _lastDNSMillis = millis() - startMillis;
+    return true;
+}
+
+void PCConnection::invalidateAddress(String host)
+{
+    uint32_t hostHash = hashOfHost(host);
+    for (int i = 0; i < DNS_CACHE_SIZE; i++)
+    {
+        if (dnsCache[i].hostHash == hostHash)
+        {
+            dnsCache[i].hostHash = 0;
+            dnsCache[i].expires = 0;
+        }
+    }
+}
+
+WiFiClient *PCConnection::open(String urlString, const char *rootCA)
+{
+    String host;
+    String path;
+    uint16_t port;
+    boolean secure;
+    _lastOpenWasReused = false;
+    if (!parseURL(urlString, host, port, path, secure))
+    {
+        log_printf("Invalid URL: %s\n", urlString.c_str());
+        return NULL;
+    }
+    if (PCBudget::isExpired())
+    {
+        log_printf("No budget left for %s\n", host.c_str());
+        return NULL;
+    }
+
+    // Reuse an idle connection to the same origin
+    uint32_t hostHash = hashOfHost(host);
+    for (int i = 0; i < CONNECTION_POOL_SIZE; i++)
+    {
+        PCPooledConnection *pooled = &connectionPool[i];
+        if (pooled->client == NULL || pooled->inUse || pooled->hostHash != hostHash || pooled->port != port)
+            continue;
+        if (pooled->client->connected())
+        {
+            pooled->inUse = true;
+            _lastOpenWasReused = true;
+            _numberOfReusedConnections++;
+            log_printf("Reusing connection to %s\n", host.c_str());
+            return pooled->client;
+        }
+        pooled->client->stop();
+        delete pooled->client;
+        pooled->client = NULL;
+    }
+
+    WiFiClient *client = connect(host, port, secure, rootCA);
+    if (client == NULL)
+        return NULL;
+
+    // Register in the pool, evicting an idle connection when full
+    PCPooledConnection *slot = NULL;
+    for (int i = 0; i < CONNECTION_POOL_SIZE && slot == NULL; i++)
+    {
+        if (connectionPool[i].client == NULL)
+            slot = &connectionPool[i];
+    }
+    for (int i = 0; i < CONNECTION_POOL_SIZE && slot == NULL; i++)
+    {
+        if (!connectionPool[i].inUse)
+        {
+            slot = &connectionPool[i];
+            slot->client->stop();
+            delete slot->client;
+        }
+    }
+    if (slot != NULL)
+    {
+        slot->hostHash = hostHash;
+        slot->port = port;
+        slot->client = client;
+        slot->inUse = true;
+    }
+    return client;
+}
+
+void PCConnection::release(WiFiClient *client, boolean reusable)
+{
+    if (client == NULL)
+        return;
+    for (int i = 0; i < CONNECTION_POOL_SIZE; i++)
+    {
+        PCPooledConnection *pooled = &connectionPool[i];
+        if (pooled->client == client)
+        {
+            pooled->inUse = false;
+            if (reusable && client->connected())
+                return;
+            pooled->client = NULL;
+            break;
+        }
+    }
+    client->stop();
+    delete client;
+}
+
+void PCConnection::closeAll()
+{
+    for (int i = 0; i < CONNECTION_POOL_SIZE; i++)
+    {
+        PCPooledConnection *pooled = &connectionPool[i];
+        if (pooled->client != NULL)
+        {
+            pooled->client->stop();
+            delete pooled->client;
+            pooled->client = NULL;
+        }
+        pooled->inUse = false;
+    }
+}
+
+boolean PCConnection::lastOpenWasReused()
+{
+    return _lastOpenWasReused;
+}
+
+boolean PCConnection::get(WiFiClient *client, String urlString, PCHTTPResponse &response)
+{
+    String host;
+    String path;
+    uint16_t port;
+    boolean secure;
+    if (!parseURL(urlString, host, port, path, secure))
+        return false;
+
+    String request = "GET " + path + " HTTP/1.1\r\n";
+    request += "Host: " + host;
+    if (port != (secure ? 443 : 80))
+    {
+        request += ":" + String(port);
+    }
+    request += "\r\nUser-Agent: PaperCal\r\nConnection: keep-alive\r\n\r\n";
+    if (client->print(request) != request.length())
+        return false;
+
+    // Wait for the status line
+    unsigned long startMillis = millis();
+    unsigned long timeoutMillis = min(PCBudget::remainingMillis(), (unsigned long)RESPONSE_TIMEOUT_MS);
+    while (client->available() == 0)
+    {
+        if (!client->connected() || millis() - startMillis > timeoutMillis)
+            return false;
+        delay(1);
+    }
+    String statusLine = client->readStringUntil('\n');
+    if (!statusLine.startsWith("HTTP/1."))
+        return false;
+    response.statusCode = statusLine.substring(9, 12).toInt();
+    response.keepAlive = statusLine.startsWith("HTTP/1.1");
+    response.contentLength = -1;
+    response.chunked = false;
+    response.date = "";
+
+    while (true)
+    {
+        String line = client->readStringUntil('\n');
+        line.trim();
+        if (line.length() == 0)
+            break;
+        int separatorLocation = line.indexOf(":");
+        if (separatorLocation < 0)
+            continue;
+        String key = line.substring(0, separatorLocation);
+        String value = line.substring(separatorLocation + 1);
+        key.toLowerCase();
+        value.trim();
+        if (key == "date")
+        {
+            response.date = value;
+        }
+        else if (key == "content-length")
+        {
+            response.contentLength = value.toInt();
+        }
+        else if (key == "transfer-encoding")
+        {
+            value.toLowerCase();
+            response.chunked = (value.indexOf("chunked") >= 0);
+        }
+        else if (key == "connection")
+        {
+            value.toLowerCase();
+            if (value.indexOf("close") >= 0)
+                response.keepAlive = false;
+            else if (value.indexOf("keep-alive") >= 0)
+                response.keepAlive = true;
+        }
+    }
+    return true;
+}
+
+WiFiClient *PCConnection::connect(String host, uint16_t port, boolean secure, const char *rootCA)
+{
+    if (secure && (rootCA == NULL || strlen(rootCA) == 0))
+    {
+        // Without a root certificate the server cannot be verified, so there is no connection
+        log_printf("No root certificate for %s\n", host.c_str());
+        return NULL;
+    }
+    IPAddress address;
+    int cacheHits = _numberOfDNSCacheHits;
+    if (!resolve(host, address))
+    {
+        log_printf("DNS lookup failed: %s\n", host.c_str());
+        return NULL;
+    }
+
+    WiFiClient *client;
+    PCTLSClient *secureClient = NULL;
+    if (secure)
+    {
+        secureClient = new PCTLSClient();
+        // The handshake ends with the budget of the feed, in whole seconds
+        secureClient->setHandshakeTimeout(max(min(PCBudget::remainingMillis(), (unsigned long)HANDSHAKE_TIMEOUT_MS) / 1000, 1UL));
+        client = secureClient;
+    }
+    else
+    {
+        client = new WiFiClient();
+    }
+    unsigned long startMillis = millis();
+    // Connect by address, but keep the host name for SNI and verification
+    int connected = secure ? secureClient->connect(address, port, host.c_str(), rootCA) : client->connect(address, port);
+    if (!connected && _numberOfDNSCacheHits > cacheHits)
+    {
+        // Cached address may be stale
+        invalidateAddress(host);
+        if (resolve(host, address))
+        {
+            connected = secure ? secureClient->connect(address, port, host.c_str(), rootCA) : client->connect(address, port);
+        }
+    }
+    _lastHandshakeMillis = millis() - startMillis;
+    if (!connected)
+    {
+        log_printf("%s connection failed: %s (%lu ms)\n", secure ? "TLS" : "HTTP", host.c_str(), _lastHandshakeMillis);
+        delete client;
+        return NULL;
+    }
+    _totalHandshakeMillis += _lastHandshakeMillis;
+    _numberOfHandshakes++;
+    _lastHandshakeWasResumed = secure && secureClient->resumed();
+    if (_lastHandshakeWasResumed)
+    {
+        _totalResumedHandshakeMillis += _lastHandshakeMillis;
+        _numberOfResumedHandshakes++;
+    }
+    log_printf("Connected to %s: dns %lu ms, handshake %lu ms%s\n", host.c_str(), _lastDNSMillis, _lastHandshakeMillis,
+               _lastHandshakeWasResumed ? " (resumed)" : "");
+    return client;
+}
+
+unsigned long PCConnection::lastDNSMillis()
+{
+    return _lastDNSMillis;
+}
+
+unsigned long PCConnection::lastHandshakeMillis()
+{
+    return _lastHandshakeMillis;
+}
+
+unsigned long PCConnection::totalHandshakeMillis()
+{
+    return _totalHandshakeMillis;
+}
+
+int PCConnection::numberOfHandshakes()
+{
+    return _numberOfHandshakes;
+}
+
+boolean PCConnection::lastHandshakeWasResumed()
+{
+    return _lastHandshakeWasResumed;
+}
+
+int PCConnection::numberOfResumedHandshakes()
+{
+    return _numberOfResumedHandshakes;
+}
+
+unsigned long PCConnection::totalResumedHandshakeMillis()
+{
+    return _totalResumedHandshakeMillis;
+}
+
+int PCConnection::numberOfDNSCacheHits()
+{
+    return _numberOfDNSCacheHits;
+}
+
+int PCConnection::numberOfReusedConnections()
+{
+    return _numberOfReusedConnections;
+}
@@ -0,0 +1,70 @@
+#ifndef PCCONNECTION_H_INCLUDE
+#define PCCONNECTION_H_INCLUDE
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+
+#include "PCTLSClient.h"
+
+#define HTTP_STATUS_OK 200
+
+boolean parseURL(String urlString, String &host, uint16_t &port, String &path, boolean &secure);
+
+typedef struct
+{
+    int statusCode;
+    String date;
+    long contentLength;
+    boolean chunked;
+    boolean keepAlive;
+} PCHTTPResponse;
+
+// TLS connections to feed servers, and plain HTTP ones for "http://" URLs
+// such as a pcal.py server on the LAN.
+// Resolved addresses are cached in RTC memory so timer wakes can skip DNS,
+// and DNS and handshake times are measured for every connection.
+// TLS sessions are resumed with PCTLSClient, and resumed and full handshakes
+// are timed apart.
+// Released connections stay open per host, so feeds on the same origin are
+// fetched one after another over a single keep-alive connection.
+// Handshakes and responses wait no longer than the PCBudget phase allows.
+class PCConnection
+{
+public:
+    static void setDNSTTL(uint32_t seconds);
+    static boolean resolve(String host, IPAddress &address);
+    static void invalidateAddress(String host);
+    static WiFiClient *open(String urlString, const char *rootCA);
+    static void release(WiFiClient *client, boolean reusable);
+    static void closeAll();
+    static boolean lastOpenWasReused();
+    static boolean get(WiFiClient *client, String urlString, PCHTTPResponse &response);
+
+    static unsigned long lastDNSMillis();
+    static unsigned long lastHandshakeMillis();
+    static unsigned long totalHandshakeMillis();
+    static int numberOfHandshakes();
+    static boolean lastHandshakeWasResumed();
+    static int numberOfResumedHandshakes();
+    static unsigned long totalResumedHandshakeMillis();
+    static int numberOfDNSCacheHits();
+    static int numberOfReusedConnections();
+
+private:
+    static WiFiClient *connect(String host, uint16_t port, boolean secure, const char *rootCA);
+
+    static uint32_t _dnsTTL;
+    static boolean _lastOpenWasReused;
+    static int _numberOfReusedConnections;
+    static unsigned long _lastDNSMillis;
+    static unsigned long _lastHandshakeMillis;
+    static unsigned long _totalHandshakeMillis;
+    static int _numberOfHandshakes;
+    static boolean _lastHandshakeWasResumed;
+    static int _numberOfResumedHandshakes;
+    static unsigned long _totalResumedHandshakeMillis;
+    static int _numberOfDNSCacheHits;
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include "PCDayRetention.h"
+#include "PCArena.h"
+
+#define SECONDS_IN_DAY 86400
+#define TIMED_EVENT_PRIORITY 100000
+
+PCDayRetention::PCDayRetention()
+{
+    clear();
+}
+
+boolean PCDayRetention::begin(time_t windowStart, time_t windowEnd, int eventsPerDay)
+{
+    clear();
+    if (eventsPerDay <= 0 || eventsPerDay > 255 || windowEnd <= windowStart)
+        return false;
+    int numberOfDays = (windowEnd - windowStart + SECONDS_IN_DAY - 1) / SECONDS_IN_DAY;
+    _heaps = (PCRetainedEvent *)PCArena::allocate(sizeof(PCRetainedEvent) * numberOfDays * eventsPerDay, alignof(PCRetainedEvent));
+    _counts = (uint8_t *)PCArena::allocate(numberOfDays, 1);
+    _overflows = (uint16_t *)PCArena::allocate(sizeof(uint16_t) * numberOfDays, alignof(uint16_t));
+    if (_heaps == NULL || _counts == NULL || _overflows == NULL)
+    {
+        clear();
+        return false;
+    }
+    memset(_counts, 0, numberOfDays);
+    memset(_overflows, 0, sizeof(uint16_t) * numberOfDays);
+    _windowStart = windowStart;
+    _numberOfDays = numberOfDays;
+    _eventsPerDay = eventsPerDay;
+    return true;
+}
+
+void PCDayRetention::clear()
+{
+    _windowStart = 0;
+    _numberOfDays = 0;
+    _eventsPerDay = 0;
+    _heaps = NULL;
+    _counts = NULL;
+    _overflows = NULL;
+}
+
+boolean PCDayRetention::isActive()
+{
+    return _heaps != NULL;
+}
+
+// Events starting before the window count for its first day
+int PCDayRetention::dayOfTime(time_t time)
+{
+    if (time < _windowStart)
+        return 0;
+    int day = (time - _windowStart) / SECONDS_IN_DAY;
+    return day < _numberOfDays ? day : RETENTION_NO_SLOT;
+}
+
+// Feeds with a higher priority first, then all-day and multi-day events,
+// then by start time
+uint32_t PCDayRetention::priorityOf(time_t start, time_t end, boolean isDateEvent, time_t dayStart, uint32_t feedPriority)
+{
+    uint32_t feedRank = (MAX_FEED_PRIORITY - min(feedPriority, (uint32_t)MAX_FEED_PRIORITY)) * FEED_PRIORITY_STEP;
+    if (isDateEvent || end - start > SECONDS_IN_DAY || start < dayStart)
+        return feedRank;
+    return feedRank + TIMED_EVENT_PRIORITY + (uint32_t)(start - dayStart);
+}
+
+// Returns false when the event is not kept. replacedIndex is the pending
+// index of the event it replaces, or RETENTION_NO_SLOT.
+boolean PCDayRetention::admit(int day, uint32_t priority, int pendingIndex, int &replacedIndex)
+{
+    replacedIndex = RETENTION_NO_SLOT;
+    if (!isActive() || day < 0 || day >= _numberOfDays)
+        return true;
+    PCRetainedEvent *heap = _heaps + day * _eventsPerDay;
+    int count = _counts[day];
+    if (count < _eventsPerDay)
+    {
+        // Sift up from the new leaf
+        int index = count;
+        while (index > 0 && heap[(index - 1) / 2].priority < priority)
+        {
+            heap[index] = heap[(index - 1) / 2];
+            index = (index - 1) / 2;
+        }
+        heap[index] = {priority, pendingIndex};
+        _counts[day] = count + 1;
+        return true;
+    }
+    if (_overflows[day] < UINT16_MAX)
+        _overflows[day]++;
+    if (priority >= heap[0].priority)
+        return false;
+    replacedIndex = heap[0].pendingIndex;
+    heap[0] = {priority, replacedIndex};
+    siftDown(heap, count, 0);
+    return true;
+}
+
+// Kept events of a day, in heap order
+int PCDayRetention::numberOfRetained(int day)
+{
+    if (!isActive() || day < 0 || day >= _numberOfDays)
+        return 0;
+    return _counts[day];
+}
+
+int PCDayRetention::retainedIndex(int day, int slot)
+{
+    return _heaps[day * _eventsPerDay + slot].pendingIndex;
+}
+
+// A kept event replaced in place moves to where its new priority belongs
+void PCDayRetention::setPriority(int day, int slot, uint32_t priority)
+{
+    PCRetainedEvent *heap = _heaps + day * _eventsPerDay;
+    PCRetainedEvent moving = {priority, heap[slot].pendingIndex};
+    int index = slot;
+    while (index > 0 && heap[(index - 1) / 2].priority < priority)
+    {
+        heap[index] = heap[(index - 1) / 2];
+        index = (index - 1) / 2;
+    }
+    heap[index] = moving;
+    siftDown(heap, _counts[day], index);
+}
+
+void PCDayRetention::siftDown(PCRetainedEvent *heap, int count, int index)
+{
+    PCRetainedEvent moving = heap[index];
+    while (index * 2 + 1 < count)
+    {
+        int child = index * 2 + 1;
+        if (child + 1 < count && heap[child + 1].priority > heap[child].priority)
+            child++;
+        if (heap[child].priority <= moving.priority)
+            break;
+        heap[index] = heap[child];
+        index = child;
+    }
+    heap[index] = moving;
+}
+
+int PCDayRetention::overflowOfDay(int day)
+{
+    if (!isActive() || day < 0 || day >= _numberOfDays)
+        return 0;
+    return _overflows[day];
+}
+
+int PCDayRetention::totalOverflow()
+{
+    int total = 0;
+    for (int day = 0; day < _numberOfDays; day++)
+    {
+        total += _overflows[day];
+    }
+    return total;
+}
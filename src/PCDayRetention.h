@@ -0,0 +1,51 @@
+#ifndef PCDAYRETENTION_H_INCLUDE
+#define PCDAYRETENTION_H_INCLUDE
+
+#include <Arduino.h>
+#include <time.h>
+
+#include "PCFeedCache.h"
+
+#define RETENTION_NO_SLOT -1
+#define FEED_PRIORITY_STEP 200000 // above any priority within one feed
+
+typedef struct
+{
+    uint32_t priority; // lower is shown first
+    int pendingIndex;
+} PCRetainedEvent;
+
+// The best K events of each day in the loading window, chosen while parsing.
+// Each day has a fixed-size max-heap with the worst kept event on top, so a
+// better event replaces it and a worse one is only counted as overflow.
+// Memory is days x K whatever the size of the feed.
+// Arrays are allocated in the arena and live until PCArena::release().
+class PCDayRetention
+{
+public:
+    PCDayRetention();
+    boolean begin(time_t windowStart, time_t windowEnd, int eventsPerDay);
+    void clear();
+    boolean isActive();
+    int dayOfTime(time_t time);
+    boolean admit(int day, uint32_t priority, int pendingIndex, int &replacedIndex);
+    int numberOfRetained(int day);
+    int retainedIndex(int day, int slot);
+    void setPriority(int day, int slot, uint32_t priority);
+    int overflowOfDay(int day);
+    int totalOverflow();
+
+    static uint32_t priorityOf(time_t start, time_t end, boolean isDateEvent, time_t dayStart, uint32_t feedPriority = 0);
+
+private:
+    void siftDown(PCRetainedEvent *heap, int count, int index);
+
+    time_t _windowStart;
+    int _numberOfDays;
+    int _eventsPerDay;
+    PCRetainedEvent *_heaps;
+    uint8_t *_counts;
+    uint16_t *_overflows;
+};
+
+#endif
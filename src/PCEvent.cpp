@@ -1,9 +1,15 @@
-
-#include <HTTPClient.h>
-#include <WiFiClient.h>
-
 #include "PCEvent.h"
+#include "PCHoliday.h"
+#include "PCClock.h"
+#include "PCEventIndex.h"
+#include "PCMergeTable.h"
+#include "PCDayRetention.h"
+#include "PCConnection.h"
+#include "PCBudget.h"
+#include "PCCompact.h"
 #include "NJScanner.h"
+#include "SD_MMC.h"
+#include <WiFi.h>
 
 float PCEvent::defaultTimezone = 0.0f;
 tm PCEvent::currentTimeinfo = {.tm_sec = 0, .tm_min = 0, .tm_hour = 0, .tm_mday = 0, .tm_mon = 0, .tm_year = 0};
@@ -16,39 +22,136 @@ int PCEvent::nextMonth = 0;
 boolean PCEvent::_isCacheValid = false;
 
 String PCEvent::_rootCA;
-std::multimap<int, PCEvent> PCEvent::_eventsInThisMonth;
-std::multimap<int, PCEvent> PCEvent::_holidaysInThisMonth;
-std::vector<PCEvent> PCEvent::_eventsInNextMonth;
+time_t PCEvent::_windowStart = 0;
+time_t PCEvent::_windowEnd = 0;
+std::vector<PCPendingEvent, PCArenaAllocator<PCPendingEvent>> PCEvent::_pendingEvents;
+int PCEvent::_numberOfFeeds = 0;
+int PCEvent::_numberOfChangedFeeds = 0;
+int PCEvent::_numberOfStaleFeeds = 0;
+size_t PCEvent::_lastFeedBytes = 0;
+int PCEvent::_numberOfDuplicates = 0;
+int PCEvent::_numberOfParsedFeeds = 0;
+int PCEvent::_eventsPerDay = 0;
+uint32_t PCEvent::_feedPriority = 0;
+uint8_t PCEvent::_feedColor = FEED_COLOR_BLACK;
+uint32_t PCEvent::_feedMaxSize = 0;
+boolean PCEvent::_lastFeedComplete = false;
+boolean (*PCEvent::_mount)() = NULL;
+boolean PCEvent::_laterFeedWins = false;
+
+#define MAX_FEED_HASHES 8
 
-PCEvent::PCEvent(String sourceString, float toTimezone)
+// Content hash of each feed at the previous wake
+typedef struct
 {
-    NJScanner scanner = NJScanner(sourceString);
-    do
+    uint32_t urlHash;
+    uint32_t contentHash;
+} PCFeedHash;
+
+RTC_DATA_ATTR static PCFeedHash feedHashes[MAX_FEED_HASHES];
+RTC_DATA_ATTR static int nextFeedHashIndex = 0;
+
+#define SECONDS_IN_DAY 86400
+#define WINDOW_DAYS_BEFORE_MONTH 7
+#define EVENT_BLOCK_RESERVE 1024
+#define LINE_HEAD_SIZE 32
+#define FILE_READ_BUFFER_SIZE 4096
+#define FILE_URL_PREFIX "file:"
+
+// Events and holidays overlapping the loading window
+static PCEventIndex eventIndex;
+static PCEventIndex holidayIndex;
+
+// Best events of each day, only these are copied to the arena
+static PCDayRetention retention;
+static int numberOfRetainedDuplicates = 0;
+
+static uint32_t fnv1a(uint32_t hash, const char *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
     {
-        String key = scanner.scanUpToString(":", true);
-        key.trim();
-        String content = scanner.scanUpToString("\r\n", true);
-        content.trim();
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
 
-        if (key == "DTSTART;VALUE=DATE")
-        {
-            _startTM = tmFromICalDateString(content, 0.0f);
-            _isDayEvent = true;
-        }
-        else if (key == "DTSTART")
-        {
-            _startTM = tmFromICalDateString(content, toTimezone);
-            _isDayEvent = false;
-        }
-        else if (key.startsWith("DTEND"))
-        {
-            _endTM = tmFromICalDateString(content, toTimezone);
-        }
-        else if (key == "SUMMARY")
+PCEvent::PCEvent(String sourceString, float toTimezone) : PCEvent(sourceString.c_str(), sourceString.length(), toTimezone)
+{
+}
+PCEvent::PCEvent(const char *source, size_t length, float toTimezone, PCRecurrence *recurrence)
+{
+    _startTM = {.tm_sec = 0, .tm_min = 0, .tm_hour = 0, .tm_mday = 0, .tm_mon = 0, .tm_year = 0};
+    _endTM = _startTM;
+    _isDayEvent = false;
+    _title = "";
+    _uidHash = 0;
+    _recurrenceID = 0;
+    isHolidayEvent = false;
+    color = FEED_COLOR_BLACK;
+    const char *end = source + length;
+    const char *line = source;
+    while (line < end)
+    {
+        const char *lineEnd = (const char *)memchr(line, '\n', end - line);
+        if (lineEnd == NULL)
+            lineEnd = end;
+        const char *next = lineEnd + 1;
+        if (lineEnd > line && lineEnd[-1] == '\r')
+            lineEnd--;
+        const char *colon = (const char *)memchr(line, ':', lineEnd - line);
+        if (colon != NULL)
         {
-            _title = content;
+            const char *content = colon + 1;
+            while (content < lineEnd && *content == ' ')
+                content++;
+            size_t keyLength = colon - line;
+            if (keyLength >= 7 && strncmp(line, "DTSTART", 7) == 0)
+            {
+                String property;
+                property.concat(line, lineEnd - line);
+                _startTM = tmFromICalProperty(property, toTimezone);
+                _isDayEvent = (memchr(content, 'T', lineEnd - content) == NULL);
+            }
+            else if (keyLength >= 5 && strncmp(line, "DTEND", 5) == 0)
+            {
+                String property;
+                property.concat(line, lineEnd - line);
+                _endTM = tmFromICalProperty(property, toTimezone);
+            }
+            else if (keyLength == 7 && strncmp(line, "SUMMARY", 7) == 0)
+            {
+                _title = PCArena::copyString(content, lineEnd - content);
+            }
+            else if (keyLength == 3 && strncmp(line, "UID", 3) == 0)
+            {
+                _uidHash = fnv1a(2166136261UL, content, lineEnd - content);
+            }
+            else if (keyLength >= 13 && strncmp(line, "RECURRENCE-ID", 13) == 0)
+            {
+                String property;
+                property.concat(line, lineEnd - line);
+                _recurrenceID = timeFromTM(tmFromICalProperty(property, toTimezone));
+            }
+            else if (recurrence != NULL && keyLength == 5 && strncmp(line, "RRULE", 5) == 0)
+            {
+                String rule;
+                rule.concat(content, lineEnd - content);
+                recurrence->parse(rule, toTimezone);
+            }
+            else if (recurrence != NULL && keyLength >= 6 && strncmp(line, "EXDATE", 6) == 0)
+            {
+                String property;
+                property.concat(line, lineEnd - line);
+                recurrence->addExceptionDates(property, toTimezone);
+            }
         }
-    } while (!scanner.isAtEnd());
+        line = next;
+    }
+    if (_endTM.tm_year == 0)
+    {
+        _endTM = _startTM;
+    }
 }
 PCEvent::PCEvent(int year, int month, int day, String title)
 {
@@ -58,8 +161,26 @@ PCEvent::PCEvent(int year, int month, int day, String title)
     timeInfo.tm_mday = day;
     timeInfo.tm_wday = dayOfWeek(timeInfo.tm_year + 1900, timeInfo.tm_mon + 1, timeInfo.tm_mday);
     _startTM = timeInfo;
-    _title = title;
+    _endTM = timeInfo;
+    _title = PCArena::copyString(title.c_str(), title.length());
+    _uidHash = 0;
+    _recurrenceID = 0;
     _isDayEvent = true;
+    isHolidayEvent = false;
+    color = FEED_COLOR_BLACK;
+}
+
+// An event of a PCAL payload, times in local seconds and the title in the arena
+PCEvent::PCEvent(time_t start, time_t end, boolean isDayEvent, const char *title, uint32_t uidHash, time_t recurrenceID)
+{
+    gmtime_r(&start, &_startTM);
+    gmtime_r(&end, &_endTM);
+    _isDayEvent = isDayEvent;
+    _title = title;
+    _uidHash = uidHash;
+    _recurrenceID = recurrenceID;
+    isHolidayEvent = false;
+    color = FEED_COLOR_BLACK;
 }
 
 time_t PCEvent::getTimeT() const
@@ -67,6 +188,39 @@ time_t PCEvent::getTimeT() const
     tm temp = _startTM;
     return mktime(&temp);
 }
+time_t PCEvent::getStartTime() const
+{
+    return timeFromTM(_startTM);
+}
+time_t PCEvent::getEndTime() const
+{
+    // DTEND is exclusive. Without it, a day event lasts one day.
+    time_t start = timeFromTM(_startTM);
+    time_t end = timeFromTM(_endTM);
+    if (end <= start)
+    {
+        end = start + (_isDayEvent ? SECONDS_IN_DAY : 1);
+    }
+    return end;
+}
+uint32_t PCEvent::getUIDHash() const
+{
+    return _uidHash;
+}
+time_t PCEvent::getRecurrenceID() const
+{
+    return _recurrenceID;
+}
+// An occurrence is identified by its start, as its RECURRENCE-ID would be
+PCEvent PCEvent::occurrenceAt(time_t start) const
+{
+    PCEvent occurrence = *this;
+    time_t end = start + (getEndTime() - getStartTime());
+    gmtime_r(&start, &occurrence._startTM);
+    gmtime_r(&end, &occurrence._endTM);
+    occurrence._recurrenceID = start;
+    return occurrence;
+}
 int PCEvent::getYear()
 {
     return _startTM.tm_year + 1900;
@@ -118,11 +272,15 @@ String PCEvent::descriptionForDay(boolean isToday)
 
 double PCEvent::duration()
 {
-    return difftime(mktime(&_endTM), mktime(&_startTM));
+    return difftime(getEndTime(), getStartTime());
+}
+boolean PCEvent::isDayEvent()
+{
+    return _isDayEvent;
 }
 String PCEvent::getTitle()
 {
-    return _title;
+    return String(_title);
 }
 
 // static member functions
@@ -137,6 +295,21 @@ void PCEvent::setRootCA(String newRootCA)
 {
     PCEvent::_rootCA = newRootCA;
 }
+void PCEvent::setDuplicatePolicy(String policy)
+{
+    // "first": the feed listed first wins, "last": the feed listed last wins
+    _laterFeedWins = (policy == "last");
+}
+void PCEvent::setEventsPerDay(int eventsPerDay)
+{
+    // 0 keeps every event
+    _eventsPerDay = eventsPerDay;
+}
+void PCEvent::setMountFunction(boolean (*mount)())
+{
+    // Called before a feed copy is written or read, SD card is mounted on demand
+    _mount = mount;
+}
 void PCEvent::setTimeinfo(tm timeinfo)
 {
     PCEvent::currentTimeinfo = timeinfo;
@@ -153,6 +326,10 @@ void PCEvent::setTimeinfo(tm timeinfo)
         nextMonthYear = PCEvent::currentYear;
         nextMonth = currentMonth + 1;
     }
+
+    // Load events from the week before this month to the end of next month
+    _windowStart = timeFromDate(currentYear, currentMonth, 1) - WINDOW_DAYS_BEFORE_MONTH * SECONDS_IN_DAY;
+    _windowEnd = timeFromDate(nextMonthYear, nextMonth, 1) + numberOfDaysInMonth(nextMonthYear, nextMonth) * SECONDS_IN_DAY;
 }
 void PCEvent::setHolidayCacheString(String cacheString)
 {
@@ -177,7 +354,7 @@ void PCEvent::setHolidayCacheString(String cacheString)
                 int day = dayString.toInt();
                 PCEvent event = PCEvent(currentYear, currentMonth, day, title);
                 event.isHolidayEvent = true;
-                PCEvent::_holidaysInThisMonth.insert(std::make_pair(day, event));
+                holidayIndex.add(event);
             }
         }
         _isCacheValid = true;
@@ -191,212 +368,815 @@ String PCEvent::holidayCacheString()
     sprintf(monthString, "%04d%02d", PCEvent::currentYear, PCEvent::currentMonth);
     result += monthString;
     result += "\n";
-    for (auto it = _holidaysInThisMonth.begin(); it != _holidaysInThisMonth.end(); ++it)
+    time_t monthStart = timeFromDate(currentYear, currentMonth, 1);
+    time_t monthEnd = monthStart + numberOfDaysInMonth(currentYear, currentMonth) * SECONDS_IN_DAY;
+    for (auto &event : holidayIndex.eventsInRange(monthStart, monthEnd))
     {
-        const auto &pair = *it;
-        int day = pair.first;
-        PCEvent event = pair.second;
-        result += day;
+        if (event.getMonth() != currentMonth)
+            continue;
+        result += event.getDay();
         result += ":";
         result += event.getTitle();
         result += "\n";
     }
     return result;
 }
+// Holidays of the loading window computed by PCHoliday, in place of the cache
+void PCEvent::addRuleHolidays()
+{
+    for (time_t dayStart = _windowStart; dayStart < _windowEnd; dayStart += SECONDS_IN_DAY)
+    {
+        tm date;
+        gmtime_r(&dayStart, &date);
+        const char *name = PCHoliday::nameOfDay(date.tm_year + 1900, date.tm_mon + 1, date.tm_mday);
+        if (name != NULL)
+        {
+            PCEvent event = PCEvent(date.tm_year + 1900, date.tm_mon + 1, date.tm_mday, String(name));
+            event.isHolidayEvent = true;
+            holidayIndex.add(event);
+        }
+    }
+    _isCacheValid = true;
+}
+
 boolean PCEvent::isCacheValid()
 {
     return _isCacheValid;
 }
 
+boolean PCEvent::isFileURL(String urlString)
+{
+    return urlString.startsWith(FILE_URL_PREFIX);
+}
+
+// Options of the feed apply while it is parsed
+boolean PCEvent::loadFeed(const PCFeed &feed)
+{
+    _feedPriority = feed.priority;
+    _feedColor = feed.color;
+    _feedMaxSize = feed.maxSize;
+    boolean loaded = isFileURL(feed.url) ? loadICalendar(feed.url, false) : loadFeedWithCopy(feed);
+    _feedPriority = 0;
+    _feedColor = FEED_COLOR_BLACK;
+    _feedMaxSize = 0;
+    return loaded;
+}
+
+// Feeds are fetched when due, and read from their SD card copy on other wakes.
+// A due feed whose fetch fails, or stops at its budget or maxSize, is read
+// from the copy too and counted as stale. Events read before the fetch
+// stopped are merged with the copy as duplicates.
+// SD card is mounted through the mount function when a copy is needed.
+boolean PCEvent::loadFeedWithCopy(const PCFeed &feed)
+{
+    time_t now = PCClock::now();
+    uint32_t month = currentYear != 0 ? currentYear * 100 + currentMonth : PCFeedCache::monthOfTime(now + (time_t)(defaultTimezone * 3600));
+    boolean due = PCFeedCache::isDue(feed, now, month);
+    boolean loaded = false;
+    if (due && WiFi.isConnected())
+    {
+        boolean writing = PCFeedCache::needsCopy(feed, now, month) && (_mount == NULL || _mount()) && PCFeedCache::beginWrite(SD_MMC, feed);
+        _lastFeedComplete = false;
+        loaded = loadICalendar(feed.url, false);
+        if (writing)
+        {
+            // The window is known once a server has told the date
+            PCFeedCache::endWrite(SD_MMC, feed, loaded && _lastFeedComplete, PCClock::now(), currentYear * 100 + currentMonth);
+        }
+        if (loaded && _lastFeedComplete)
+            return true;
+        month = currentYear != 0 ? currentYear * 100 + currentMonth : month;
+    }
+    if (!PCFeedCache::hasCopy(feed, month) || (currentYear == 0 && !setTimeinfoFromClock()))
+        return loaded;
+    if (_mount != NULL && !_mount())
+        return loaded;
+
+    String path = PCFeedCache::pathOfFeed(feed);
+    File file = SD_MMC.open(path.c_str());
+    if (!file)
+    {
+        log_printf("Feed copy not found: %s\n", path.c_str());
+        return false;
+    }
+    PCBodyReader reader(&file, file.size(), FILE_READ_BUFFER_SIZE);
+    parseSource(reader, feed.url, false);
+    file.close();
+    // The copy holds what was fetched and drawn before, so it never counts as changed
+    _numberOfFeeds++;
+    if (due)
+    {
+        log_printf("Stale copy used: %s\n", path.c_str());
+        _numberOfStaleFeeds++;
+    }
+    return true;
+}
+
 boolean PCEvent::loadICalendar(String urlString, boolean holiday)
 {
-    HTTPClient httpClient;
-    httpClient.begin(urlString, PCEvent::_rootCA.c_str());
-    // dateString = "";
+    _lastFeedBytes = 0;
+    if (isFileURL(urlString))
+    {
+        return loadICalendarFile(urlString, holiday);
+    }
 
-    const char *headerKeys[] = {"Transfer-Encoding", "date", "Date"};
-    httpClient.collectHeaders(headerKeys, 3);
+    PCHTTPResponse response;
+    WiFiClient *client = NULL;
+    for (int attempt = 0; attempt < 2 && client == NULL; attempt++)
+    {
+        client = PCConnection::open(urlString, PCEvent::_rootCA.c_str());
+        if (client == NULL)
+        {
+            return false;
+        }
+        if (!PCConnection::get(client, urlString, response))
+        {
+            // A kept-alive connection may have been closed by the server
+            boolean reused = PCConnection::lastOpenWasReused();
+            PCConnection::release(client, false);
+            client = NULL;
+            if (!reused)
+            {
+                return false;
+            }
+        }
+    }
+    if (client == NULL)
+    {
+        return false;
+    }
 
-    int result = httpClient.GET();
-    if (result == HTTP_CODE_OK)
+    PCBodyReader reader(client, response.contentLength, response.chunked);
+    if (response.statusCode != HTTP_STATUS_OK)
     {
+        // HTTP Error
+        log_printf("HTTP error %d: %s\n", response.statusCode, urlString.c_str());
+        PCConnection::release(client, reader.drain() && response.keepAlive);
+        return false;
+    }
+    if (_feedMaxSize > 0 && response.contentLength > (long)_feedMaxSize)
+    {
+        log_printf("Feed over maxSize (%ld bytes): %s\n", response.contentLength, urlString.c_str());
+        PCConnection::release(client, false);
+        return false;
+    }
+    // Bodies without a length stop at maxSize, slow bodies at the end of the budget
+    reader.setLimit(_feedMaxSize);
+    reader.setDeadline(PCBudget::deadline());
+
+    if (PCEvent::currentYear == 0 && !response.date.isEmpty())
+    {
+        tm timeinfo = tmFromHTTPDateString(response.date, defaultTimezone);
+        PCEvent::setTimeinfo(timeinfo);
+
+        // Keep the system clock for sources loaded without a server, and for the schedule
+        PCClock::setHTTPDate(timeFromTM(tmFromHTTPDateString(response.date, 0.0f)));
+    }
+
+    uint32_t contentHash = parseSource(reader, urlString, holiday);
+
+    // Consume the rest of the body so the connection can be reused
+    boolean complete = reader.drain();
+    PCConnection::release(client, complete && response.keepAlive);
+    _lastFeedComplete = complete;
+    _lastFeedBytes = reader.bytesRead();
+    _numberOfFeeds++;
+    if (!complete || !recordFeedHash(urlString, contentHash))
+    {
+        _numberOfChangedFeeds++;
+    }
+    return true;
+}
+
+// Properties read from VEVENT blocks. Everything else is skipped unread.
+static const char *keptProperties[] = {"DTSTART", "DTEND", "SUMMARY", "RRULE", "EXDATE", "UID", "RECURRENCE-ID"};
+
+static boolean isProperty(const char *line, const char *name)
+{
+    size_t length = strlen(name);
+    return strncmp(line, name, length) == 0 && (line[length] == ':' || line[length] == ';');
+}
 
-        boolean chunked = (httpClient.header("Transfer-Encoding") == "chunked");
-        long chunkSize = 0;
-        boolean isChunkSizeLine = false;
-        boolean isTrailingLine = false;
-        String lastLine = "";
-        if (PCEvent::currentYear == 0)
+static boolean isKeptProperty(const char *line)
+{
+    for (const char *name : keptProperties)
+    {
+        if (isProperty(line, name))
+            return true;
+    }
+    return false;
+}
+
+// "file:/calendar.ics" is read from SD card with large sequential reads.
+// SD card must be mounted before.
+boolean PCEvent::loadICalendarFile(String urlString, boolean holiday)
+{
+    String path = urlString.substring(strlen(FILE_URL_PREFIX));
+    if (PCEvent::currentYear == 0 && !setTimeinfoFromClock())
+    {
+        log_printf("Date unknown, file skipped: %s\n", path.c_str());
+        return false;
+    }
+
+    File file = SD_MMC.open(path.c_str());
+    if (!file)
+    {
+        log_printf("File not found: %s\n", path.c_str());
+        return false;
+    }
+    PCBodyReader reader(&file, file.size(), FILE_READ_BUFFER_SIZE);
+    uint32_t contentHash = parseSource(reader, urlString, holiday);
+    boolean complete = reader.isComplete() || reader.drain();
+    file.close();
+    _numberOfFeeds++;
+    if (!complete || !recordFeedHash(urlString, contentHash))
+    {
+        _numberOfChangedFeeds++;
+    }
+    return true;
+}
+
+// No server has told the date, use the system clock if it was set
+boolean PCEvent::setTimeinfoFromClock()
+{
+    time_t now = PCClock::now();
+    if (now < MIN_VALID_TIME)
+        return false;
+    time_t localNow = now + (time_t)(defaultTimezone * 3600);
+    tm timeinfo;
+    gmtime_r(&localNow, &timeinfo);
+    PCEvent::setTimeinfo(timeinfo);
+    return true;
+}
+
+uint32_t PCEvent::parseICalendar(PCBodyReader &reader, boolean holiday)
+{
+    unsigned long startMillis = millis();
+    // One buffer is reused for every block, and kept blocks are copied to the arena
+    String eventBlock;
+    eventBlock.reserve(EVENT_BLOCK_RESERVE);
+    boolean loadingEvent = false;
+    boolean skippingEvent = false;
+    boolean keepingProperty = false;
+    uint32_t contentHash = 2166136261UL;
+    time_t eventStart = 0;
+    time_t eventEnd = 0;
+    time_t recurrenceID = 0;
+    time_t recurrenceUntil = 0;
+    boolean isDateEvent = false;
+    boolean isRecurring = false;
+    uint32_t uidHash = 0;
+    uint32_t titleHash = 0;
+    int feed = _numberOfParsedFeeds++;
+    char head[LINE_HEAD_SIZE];
+    boolean complete;
+    String line;
+    String rest;
+
+    int headLength;
+    while ((headLength = reader.readLineHead(head, sizeof(head), complete)) >= 0)
+    {
+        // Only the start of each line is read until it is known to be needed
+        boolean continuation = (head[0] == ' ' || head[0] == '\t');
+        boolean isBegin = !continuation && strncmp(head, "BEGIN:VEVENT", 12) == 0;
+        boolean isEnd = !continuation && strncmp(head, "END:VEVENT", 10) == 0;
+        if (!continuation)
+        {
+            // A skipped event may still be an override of an instance in the window
+            keepingProperty = loadingEvent && (skippingEvent ? (isProperty(head, "UID") || isProperty(head, "RECURRENCE-ID")) : isKeptProperty(head));
+        }
+        if (!isBegin && !isEnd && !keepingProperty)
+        {
+            if (!complete)
+                reader.skipLine();
+            continue;
+        }
+        line = head;
+        if (!complete && reader.readLine(rest))
+        {
+            line += rest;
+        }
+        if (line.endsWith("\r"))
+        {
+            line.remove(line.length() - 1);
+        }
+
+        // The hash covers what is kept, so it changes only with what is shown
+        contentHash = fnv1a(contentHash, line.c_str(), line.length());
+        contentHash = fnv1a(contentHash, "\n", 1);
+
+        if (isBegin)
+        { // begin VEVENT block
+            loadingEvent = true;
+            skippingEvent = false;
+            eventBlock = "";
+            eventStart = 0;
+            eventEnd = 0;
+            recurrenceID = 0;
+            recurrenceUntil = 0;
+            isDateEvent = false;
+            isRecurring = false;
+            uidHash = 0;
+            titleHash = 0;
+        }
+        else if (!loadingEvent)
         {
-            String dateString = httpClient.header("date");
-            if (dateString.isEmpty())
+            continue;
+        }
+        else if (continuation)
+        { // unfold into the previous property
+            eventBlock.remove(eventBlock.length() - 2);
+            eventBlock += line.substring(1);
+            eventBlock += "\r\n";
+            continue;
+        }
+        else if (line.startsWith("DTSTART"))
+        { // read start date
+            eventStart = timeFromTM(tmFromICalProperty(line, PCEvent::defaultTimezone));
+            isDateEvent = (line.indexOf('T', line.indexOf(":")) < 0);
+            if (eventStart >= _windowEnd)
             {
-                dateString = httpClient.header("Date");
+                // discard event if scheduled after next month, recurrences only move later
+                skippingEvent = true;
+                keepingProperty = false;
             }
-            if (!dateString.isEmpty())
+        }
+        else if (line.startsWith("DTEND"))
+        { // read end date
+            eventEnd = timeFromTM(tmFromICalProperty(line, PCEvent::defaultTimezone));
+        }
+        else if (line.startsWith("RRULE"))
+        {
+            isRecurring = true;
+            int untilPosition = line.indexOf("UNTIL=");
+            if (untilPosition >= 0)
             {
-                tm timeinfo = tmFromHTTPDateString(dateString, defaultTimezone);
-                PCEvent::setTimeinfo(timeinfo);
+                String until = line.substring(untilPosition + 6, line.indexOf(';', untilPosition) < 0 ? line.length() : line.indexOf(';', untilPosition));
+                recurrenceUntil = timeFromTM(tmFromICalDateString(until, 0.0f)) + SECONDS_IN_DAY;
             }
         }
-
-        WiFiClient *stream = httpClient.getStreamPtr();
-        if (httpClient.connected())
+        else if (line.startsWith("RECURRENCE-ID"))
+        {
+            recurrenceID = timeFromTM(tmFromICalProperty(line, PCEvent::defaultTimezone));
+        }
+        else if (isProperty(line.c_str(), "UID"))
+        {
+            int colon = line.indexOf(':');
+            uidHash = fnv1a(2166136261UL, line.c_str() + colon + 1, line.length() - colon - 1);
+        }
+        else if (isProperty(line.c_str(), "SUMMARY"))
         {
-            String eventBlock = "";
-            boolean loadingEvent = false;
+            int colon = line.indexOf(':');
+            titleHash = fnv1a(2166136261UL, line.c_str() + colon + 1, line.length() - colon - 1);
+        }
 
-            if (stream->available() && chunked)
+        eventBlock += line;
+        eventBlock += "\r\n";
+        if (isEnd)
+        {
+            loadingEvent = false;
+            if (eventEnd <= eventStart)
             {
-                chunkSize = intFrom16BaseString(stream->readStringUntil('\n'));
-                // Serial.printf("first chunk: %ld\n", chunkSize);
+                eventEnd = eventStart + (isDateEvent ? SECONDS_IN_DAY : 1);
             }
-
-            while (stream->available())
+            boolean inWindow = !skippingEvent && (eventEnd > _windowStart);
+            // Recurrences may reach the window from an earlier start
+            inWindow = inWindow || (!skippingEvent && isRecurring && (recurrenceUntil == 0 || recurrenceUntil > _windowStart));
+            // Overrides are needed to remove the instance they replace
+            inWindow = inWindow || (recurrenceID != 0 && recurrenceID < _windowEnd && recurrenceID + SECONDS_IN_DAY > _windowStart);
+            if (inWindow)
+            {
+                PCFeedCache::write(eventBlock.c_str(), eventBlock.length());
+            }
+            // Events are built after all feeds are loaded, unless nothing changed
+            PCPendingEvent pending = {NULL, eventBlock.length(), holiday, false,
+                                      feed, uidHash, recurrenceID, titleHash, (isDateEvent && !isRecurring) ? eventStart : 0, _feedColor,
+                                      false, 0, 0, isRecurring};
+            // Single events compete for the slots of their start day.
+            // Holidays, recurring events and overrides are always kept.
+            int replacedIndex = RETENTION_NO_SLOT;
+            if (inWindow && !holiday && !isRecurring && recurrenceID == 0 && _eventsPerDay > 0)
             {
-                String line = stream->readStringUntil('\n');
-                if (chunked)
+                inWindow = retain(pending, eventStart, eventEnd, isDateEvent, replacedIndex);
+            }
+            if (inWindow)
+            {
+                if (replacedIndex == RETENTION_NO_SLOT)
                 {
-                    if (line.length() == 0 || line == "\r")
+                    pending.block = PCArena::copyString(eventBlock.c_str(), eventBlock.length());
+                    _pendingEvents.push_back(pending);
+                }
+                else
+                {
+                    // The replaced block is reused when the new one fits, titles of PCAL events are shared
+                    PCPendingEvent &replaced = _pendingEvents[replacedIndex];
+                    if (!replaced.compact && replaced.length >= eventBlock.length() && replaced.block[0] != '\0')
                     {
-                        continue;
+                        char *block = const_cast<char *>(replaced.block);
+                        memcpy(block, eventBlock.c_str(), eventBlock.length() + 1);
+                        pending.block = block;
                     }
-                    if (isChunkSizeLine)
+                    else
                     {
-                        chunkSize = intFrom16BaseString(line);
-                        // Serial.printf("new chunk: %ld\n", chunkSize);
-                        isChunkSizeLine = false;
-                        isTrailingLine = true;
-                        continue;
+                        pending.block = PCArena::copyString(eventBlock.c_str(), eventBlock.length());
                     }
-                    else if (isTrailingLine)
-                    {
-                        if (lastLine.length() > 1)
-                            lastLine = lastLine.substring(0, lastLine.length() - 1);
-                        chunkSize += lastLine.length();
+                    replaced = pending;
+                }
+            }
+        }
+    }
+    log_printf("Parsed %u bytes in %lu ms, %u skipped\n", (unsigned int)reader.bytesRead(), millis() - startMillis, (unsigned int)reader.bytesSkipped());
+    return contentHash;
+}
 
-                        line = lastLine + line;
-                        // Serial.println(line);
+// PCAL payloads of tools/pcal. Their events are kept like single events
+// of a VEVENT feed, with the title in place of the block.
+uint32_t PCEvent::parseCompact(PCBodyReader &reader, boolean holiday)
+{
+    unsigned long startMillis = millis();
+    int feed = _numberOfParsedFeeds++;
+    PCCompactReader compact(reader);
+    if (!compact.begin())
+    {
+        reader.abort();
+        return 0;
+    }
+    const PCCompactHeader &header = compact.header();
+    PCFeedCache::write((const char *)&header, sizeof(header));
+    PCFeedCache::write(compact.titleAt(0), header.titleBytes);
+    PCFeedCache::write((const char *)compact.dayIndex(), (header.numberOfDays + 1) * sizeof(uint32_t));
 
-                        isTrailingLine = false;
-                    }
-                    chunkSize -= (line.length() + 1);
-                    if (chunkSize <= 0)
-                    {
-                        lastLine = line;
-                        isChunkSizeLine = true;
-                        continue;
-                    }
-                }
+    // Day events are dates, timed events move when the device is in another timezone
+    time_t shift = (time_t)(PCEvent::defaultTimezone * 3600) - (time_t)header.timezoneMinutes * 60;
+    // The copy is the payload unchanged, its header and day index count every
+    // event, so the payload is read to the end while a copy is written
+    uint32_t limit = PCFeedCache::isWriting() ? header.numberOfEvents : compact.eventsStartingBefore(_windowEnd + max(-shift, (time_t)0));
+    PCCompactEvent event;
+    uint32_t numberOfKept = 0;
+    for (uint32_t i = 0; i < limit && compact.next(event); i++)
+    {
+        PCFeedCache::write((const char *)&event, sizeof(event));
+        boolean isDateEvent = (event.flags & COMPACT_DAY_EVENT) != 0;
+        time_t eventStart = (time_t)event.start + (isDateEvent ? 0 : shift);
+        time_t eventEnd = eventStart + max(event.duration, (uint32_t)1);
+        time_t recurrenceID = (event.recurrenceID == 0 || isDateEvent) ? (time_t)event.recurrenceID : (time_t)event.recurrenceID + shift;
+        if (eventEnd <= _windowStart || eventStart >= _windowEnd)
+            continue;
 
-                if (line.startsWith("BEGIN:VEVENT"))
-                { // begin VEVENT block
-                    loadingEvent = true;
-                }
-                else if (line.startsWith("DTSTART"))
-                { // read start date
-                    int position = line.indexOf(":");
-                    String timeString = line.substring(position + 1);
-                    timeString.trim();
-                    tm timeInfo = tmFromICalDateString(timeString, PCEvent::defaultTimezone);
-                    if (!(timeInfo.tm_year + 1900 == PCEvent::currentYear && timeInfo.tm_mon + 1 == PCEvent::currentMonth) && !(timeInfo.tm_year + 1900 == nextMonthYear && timeInfo.tm_mon + 1 == nextMonth))
-                    {
-                        // discard event if not scheduled in this month to next month
-                        loadingEvent = false;
-                        eventBlock = "";
-                    }
-                }
+        boolean isHoliday = holiday || (event.flags & COMPACT_HOLIDAY) != 0;
+        const char *title = compact.titleAt(event.title);
+        PCPendingEvent pending = {title, 0, isHoliday, false,
+                                  feed, event.uidHash, recurrenceID, fnv1a(2166136261UL, title, strlen(title)), isDateEvent ? eventStart : 0, _feedColor,
+                                  true, eventStart, eventEnd, false};
+        int replacedIndex = RETENTION_NO_SLOT;
+        if (!isHoliday && _eventsPerDay > 0 && !retain(pending, eventStart, eventEnd, isDateEvent, replacedIndex))
+            continue;
+        if (replacedIndex == RETENTION_NO_SLOT)
+            _pendingEvents.push_back(pending);
+        else
+            _pendingEvents[replacedIndex] = pending;
+        numberOfKept++;
+    }
+    if (header.month != (uint32_t)(currentYear * 100 + currentMonth))
+    {
+        log_printf("Compact payload of %u used for %d%02d\n", header.month, currentYear, currentMonth);
+    }
+    log_printf("Parsed compact payload of %u events in %lu ms, %u kept\n", header.numberOfEvents, millis() - startMillis, numberOfKept);
+    return header.contentHash;
+}
 
-                if (loadingEvent)
-                {
-                    eventBlock += line + "\n";
-                }
-                if (loadingEvent && line.startsWith("END:VEVENT"))
+// PCAL payloads are told apart from iCalendar by the URL
+uint32_t PCEvent::parseSource(PCBodyReader &reader, String urlString, boolean holiday)
+{
+    if (PCCompactReader::isCompactURL(urlString))
+        return parseCompact(reader, holiday);
+    return parseICalendar(reader, holiday);
+}
+
+typedef struct
+{
+    uint32_t uidHash;
+    time_t recurrenceID;
+} PCOverride;
+
+// Holidays from the cache are not in the pending list, so all-day events
+// are compared with them by title
+static boolean isCachedHoliday(PCEvent &event)
+{
+    String title = event.getTitle();
+    for (auto &holiday : holidayIndex.eventsInRange(event.getStartTime(), event.getStartTime() + SECONDS_IN_DAY))
+    {
+        if (holiday.getTitle() == title)
+            return true;
+    }
+    return false;
+}
+
+void PCEvent::buildEvents()
+{
+    removeDuplicates();
+    std::vector<PCOverride> overrides;
+    for (auto &pending : _pendingEvents)
+    {
+        if (!pending.duplicate && pending.recurrenceID != 0)
+        {
+            PCOverride override = {pending.uidHash, pending.recurrenceID};
+            overrides.push_back(override);
+        }
+    }
+
+    // Recurring events are expanded before anything is added, growing in the
+    // arena leaves the old arrays behind, so each index is sized once
+    int numberOfHolidays = 0;
+    int numberOfEvents = 0;
+    std::vector<PCEvent> recurringEvents;
+    std::vector<time_t> starts;
+    std::vector<int> startsEnd; // end of the occurrences of each recurring event in starts
+    for (auto &pending : _pendingEvents)
+    {
+        if (pending.duplicate)
+            continue;
+        if (!pending.recurring)
+        {
+            (pending.holiday ? numberOfHolidays : numberOfEvents)++;
+            continue;
+        }
+        PCRecurrence recurrence;
+        PCEvent event = PCEvent(pending.block, pending.length, PCEvent::defaultTimezone, &recurrence);
+        event.isHolidayEvent = pending.holiday;
+        event.color = pending.color;
+        int first = starts.size();
+        recurrence.occurrences(event.getStartTime(), event.getEndTime() - event.getStartTime(), _windowStart, _windowEnd, starts);
+        // Overridden occurrences come from their own events
+        int kept = first;
+        for (int i = first; i < (int)starts.size(); i++)
+        {
+            boolean overridden = false;
+            for (auto &override : overrides)
+            {
+                if (override.uidHash == event.getUIDHash() && override.recurrenceID == starts[i])
                 {
-                    loadingEvent = false;
-                    PCEvent event = PCEvent(eventBlock, PCEvent::defaultTimezone);
-                    event.isHolidayEvent = holiday;
-                    if (event.getMonth() == PCEvent::currentMonth)
-                    {
-                        // Will be displayed as this month
-                        if (holiday)
-                        {
-                            PCEvent::_holidaysInThisMonth.insert(std::make_pair(event.getDay(), event));
-                        }
-                        else
-                        {
-                            PCEvent::_eventsInThisMonth.insert(std::make_pair(event.getDay(), event));
-                        }
-                    }
-                    else
-                    {
-                        // Next month
-                        _eventsInNextMonth.push_back(event);
-                    }
-                    eventBlock = "";
+                    overridden = true;
+                    break;
                 }
             }
+            if (!overridden)
+                starts[kept++] = starts[i];
         }
-        httpClient.end();
-        return true;
+        starts.resize(kept);
+        (pending.holiday ? numberOfHolidays : numberOfEvents) += kept - first;
+        recurringEvents.push_back(event);
+        startsEnd.push_back(kept);
     }
-    else
+    holidayIndex.reserve(numberOfHolidays);
+    eventIndex.reserve(numberOfEvents);
+
+    for (auto &pending : _pendingEvents)
     {
-        // HTTP Error
-        httpClient.end();
+        if (pending.duplicate || pending.recurring)
+            continue;
+        // dayStart is set for the day events of a PCAL payload
+        PCEvent event = pending.compact ? PCEvent(pending.start, pending.end, pending.dayStart != 0, pending.block, pending.uidHash, pending.recurrenceID)
+                                        : PCEvent(pending.block, pending.length, PCEvent::defaultTimezone);
+        event.isHolidayEvent = pending.holiday;
+        event.color = pending.color;
+        if (_isCacheValid && !pending.holiday && pending.dayStart != 0 && isCachedHoliday(event))
+        {
+            _numberOfDuplicates++;
+            continue;
+        }
+        (pending.holiday ? holidayIndex : eventIndex).add(event);
     }
-    return false;
+    int first = 0;
+    for (int i = 0; i < (int)recurringEvents.size(); i++)
+    {
+        PCEvent &event = recurringEvents[i];
+        for (int j = first; j < startsEnd[i]; j++)
+        {
+            (event.isHolidayEvent ? holidayIndex : eventIndex).add(event.occurrenceAt(starts[j]));
+        }
+        first = startsEnd[i];
+    }
+    _pendingEvents.clear();
 }
 
-int PCEvent::numberOfEventsInThisMonth()
+// Same test as removeDuplicates(), for events that are already kept
+static boolean isCopyOf(const PCPendingEvent &pending, const PCPendingEvent &kept)
 {
-    return PCEvent::_eventsInThisMonth.size();
+    if (pending.uidHash != 0 && pending.uidHash == kept.uidHash && pending.recurrenceID == kept.recurrenceID)
+        return true;
+    return pending.dayStart != 0 && pending.titleHash != 0 && pending.dayStart == kept.dayStart && pending.titleHash == kept.titleHash && pending.feed != kept.feed;
 }
 
-int PCEvent::numberOfEventsInDayOfThisMonth(int day)
+// Admits a single event to the slots of its start day. A copy of an event
+// already kept there takes no slot of its own: it replaces the kept one in
+// its slot, or is dropped, as the duplicate policy decides.
+// replacedIndex is the pending index to overwrite, or RETENTION_NO_SLOT.
+boolean PCEvent::retain(const PCPendingEvent &pending, time_t start, time_t end, boolean isDateEvent, int &replacedIndex)
 {
-    return PCEvent::_eventsInThisMonth.count(day);
+    replacedIndex = RETENTION_NO_SLOT;
+    if (!retention.isActive())
+        retention.begin(_windowStart, _windowEnd, _eventsPerDay);
+    int day = retention.dayOfTime(start);
+    uint32_t priority = PCDayRetention::priorityOf(start, end, isDateEvent, _windowStart + max(day, 0) * SECONDS_IN_DAY, _feedPriority);
+    for (int slot = 0; slot < retention.numberOfRetained(day); slot++)
+    {
+        int index = retention.retainedIndex(day, slot);
+        PCPendingEvent &kept = _pendingEvents[index];
+        if (!isCopyOf(pending, kept))
+            continue;
+        numberOfRetainedDuplicates++;
+        if (!(_laterFeedWins ? pending.feed > kept.feed : pending.feed < kept.feed))
+            return false;
+        retention.setPriority(day, slot, priority);
+        replacedIndex = index;
+        return true;
+    }
+    return retention.admit(day, priority, _pendingEvents.size(), replacedIndex);
 }
 
-std::vector<PCEvent> PCEvent::eventsInDayOfThisMonth(int day)
+// The same event can come from several feeds. Events with the same UID and
+// RECURRENCE-ID, or all-day events with the same title on the same day from
+// different feeds, are merged. Holidays win, then the feed chosen by policy.
+void PCEvent::removeDuplicates()
 {
-    std::vector<PCEvent> eventsInDay;
-    if (PCEvent::_eventsInThisMonth.count(day) > 0)
+    PCMergeTable uidTable(_pendingEvents.size());
+    PCMergeTable dayTable(_pendingEvents.size());
+    // Copies dropped while parsing are counted too
+    _numberOfDuplicates = numberOfRetainedDuplicates;
+    for (int i = 0; i < (int)_pendingEvents.size(); i++)
     {
-        auto itr = PCEvent::_eventsInThisMonth.lower_bound(day);
-        auto last = PCEvent::_eventsInThisMonth.upper_bound(day);
-        while (itr != last)
+        PCPendingEvent &pending = _pendingEvents[i];
+        int other = -1;
+        uint64_t uidKey = 0;
+        uint64_t dayKey = 0;
+        if (pending.uidHash != 0)
+        {
+            uidKey = ((uint64_t)pending.uidHash << 32) | (uint32_t)(pending.recurrenceID ^ (pending.recurrenceID >> 16));
+            other = uidTable.findOrInsert(uidKey, i);
+        }
+        if (other < 0 && pending.dayStart != 0 && pending.titleHash != 0)
         {
-            eventsInDay.push_back(itr->second);
-            ++itr;
+            dayKey = ((uint64_t)pending.titleHash << 32) | (uint32_t)(pending.dayStart / SECONDS_IN_DAY);
+            other = dayTable.findOrInsert(dayKey, i);
+            if (other >= 0 && _pendingEvents[other].feed == pending.feed)
+            {
+                other = -1; // same feed, not a copy
+            }
+        }
+        if (other < 0)
+            continue;
+
+        PCPendingEvent &kept = _pendingEvents[other];
+        // Retention may put a later feed's event in an earlier slot, so feeds are compared
+        boolean replaces = (pending.holiday != kept.holiday) ? pending.holiday : (_laterFeedWins ? pending.feed > kept.feed : pending.feed < kept.feed);
+        if (replaces)
+        {
+            kept.duplicate = true;
+            if (uidKey != 0)
+                uidTable.replace(uidKey, i);
+            if (dayKey != 0)
+                dayTable.replace(dayKey, i);
         }
+        else
+        {
+            pending.duplicate = true;
+        }
+        _numberOfDuplicates++;
+    }
+    if (_numberOfDuplicates > 0)
+    {
+        log_printf("Duplicate events removed: %d\n", _numberOfDuplicates);
     }
-    return eventsInDay;
 }
 
-int PCEvent::numberOfHolidaysInDayOfThisMonth(int day)
+void PCEvent::releaseEvents()
 {
-    return PCEvent::_holidaysInThisMonth.count(day);
+    // Events point into the arena, so drop them before it is released
+    eventIndex.clear();
+    holidayIndex.clear();
+    retention.clear();
+    numberOfRetainedDuplicates = 0;
+    std::vector<PCPendingEvent, PCArenaAllocator<PCPendingEvent>>().swap(_pendingEvents);
 }
 
-std::vector<PCEvent> PCEvent::holidaysInDayOfThisMonth(int day)
+boolean PCEvent::feedsUnchanged()
+{
+    return _numberOfFeeds > 0 && _numberOfChangedFeeds == 0;
+}
+
+int PCEvent::numberOfChangedFeeds()
+{
+    return _numberOfChangedFeeds;
+}
+
+// Due feeds shown from their SD card copy
+int PCEvent::numberOfStaleFeeds()
+{
+    return _numberOfStaleFeeds;
+}
+
+// Body bytes of the last feed fetched
+size_t PCEvent::lastFeedBytes()
 {
-    std::vector<PCEvent> eventsInDay;
-    if (PCEvent::_holidaysInThisMonth.count(day) > 0)
+    return _lastFeedBytes;
+}
+
+int PCEvent::numberOfDuplicates()
+{
+    return _numberOfDuplicates;
+}
+
+int PCEvent::numberOfOverflowEvents(time_t dayStart)
+{
+    if (!retention.isActive() || dayStart < _windowStart)
+        return 0;
+    return retention.overflowOfDay(retention.dayOfTime(dayStart));
+}
+
+int PCEvent::numberOfOverflowEvents()
+{
+    return retention.isActive() ? retention.totalOverflow() : 0;
+}
+
+boolean PCEvent::recordFeedHash(String urlString, uint32_t contentHash)
+{
+    uint32_t urlHash = fnv1a(2166136261UL, urlString.c_str(), urlString.length());
+    for (int i = 0; i < MAX_FEED_HASHES; i++)
     {
-        auto itr = PCEvent::_holidaysInThisMonth.lower_bound(day);
-        auto last = PCEvent::_holidaysInThisMonth.upper_bound(day);
-        while (itr != last)
+        if (feedHashes[i].urlHash == urlHash)
         {
-            eventsInDay.push_back(itr->second);
-            ++itr;
+            boolean unchanged = (feedHashes[i].contentHash == contentHash);
+            feedHashes[i].contentHash = contentHash;
+            return unchanged;
         }
     }
-    return eventsInDay;
+    feedHashes[nextFeedHashIndex].urlHash = urlHash;
+    feedHashes[nextFeedHashIndex].contentHash = contentHash;
+    nextFeedHashIndex = (nextFeedHashIndex + 1) % MAX_FEED_HASHES;
+    return false;
+}
+
+int PCEvent::numberOfEventsInThisMonth()
+{
+    time_t monthStart = timeFromDate(currentYear, currentMonth, 1);
+    return eventIndex.numberOfEventsInRange(monthStart, monthStart + numberOfDaysInMonth(currentYear, currentMonth) * SECONDS_IN_DAY);
 }
+
+int PCEvent::numberOfEventsInDayOfThisMonth(int day)
+{
+    time_t dayStart = timeFromDate(currentYear, currentMonth, day);
+    return eventIndex.numberOfEventsInRange(dayStart, dayStart + SECONDS_IN_DAY);
+}
+
+std::vector<PCEvent> PCEvent::eventsInDayOfThisMonth(int day)
+{
+    time_t dayStart = timeFromDate(currentYear, currentMonth, day);
+    return eventIndex.eventsInRange(dayStart, dayStart + SECONDS_IN_DAY);
+}
+
+int PCEvent::numberOfHolidaysInDayOfThisMonth(int day)
+{
+    time_t dayStart = timeFromDate(currentYear, currentMonth, day);
+    return holidayIndex.numberOfEventsInRange(dayStart, dayStart + SECONDS_IN_DAY);
+}
+
+std::vector<PCEvent> PCEvent::holidaysInDayOfThisMonth(int day)
+{
+    time_t dayStart = timeFromDate(currentYear, currentMonth, day);
+    return holidayIndex.eventsInRange(dayStart, dayStart + SECONDS_IN_DAY);
+}
+
 std::vector<PCEvent> PCEvent::eventsInNextMonth()
 {
-    return PCEvent::_eventsInNextMonth;
+    time_t monthStart = timeFromDate(nextMonthYear, nextMonth, 1);
+    return eventIndex.eventsInRange(monthStart, monthStart + numberOfDaysInMonth(nextMonthYear, nextMonth) * SECONDS_IN_DAY);
+}
+
+std::vector<PCEvent> PCEvent::eventsInRange(time_t start, time_t end)
+{
+    return eventIndex.eventsInRange(start, end);
+}
+
+std::vector<PCEvent> PCEvent::holidaysInRange(time_t start, time_t end)
+{
+    return holidayIndex.eventsInRange(start, end);
+}
+
+int PCEvent::numberOfEventsInRange(time_t start, time_t end)
+{
+    return eventIndex.numberOfEventsInRange(start, end);
+}
+
+// The loading window set by setTimeinfo(), in local seconds
+time_t PCEvent::windowStart()
+{
+    return _windowStart;
+}
+
+time_t PCEvent::windowEnd()
+{
+    return _windowEnd;
 }
 
 // Other functions
@@ -453,6 +1233,41 @@ tm tmFromICalDateString(String iCalDateString, float toTimezone)
     return convertTimezone(timeInfo, toTimezone);
 }
 
+tm tmFromICalProperty(String property, float toTimezone)
+{
+    // DTSTART;VALUE=DATE:20240122
+    // DTSTART;TZID=Asia/Tokyo:20240122T090000
+    // DTSTART:20240122T000000Z
+    int position = property.indexOf(":");
+    String parameters = property.substring(0, position);
+    String content = property.substring(position + 1);
+    content.trim();
+    // Only UTC times are converted. Local times with TZID are taken as
+    // times in the device timezone.
+    if (parameters.indexOf("TZID=") >= 0 || !content.endsWith("Z"))
+    {
+        return tmFromICalDateString(content, 0.0f);
+    }
+    return tmFromICalDateString(content, toTimezone);
+}
+
+time_t timeFromDate(int year, int month, int day)
+{
+    // Days from 1970-01-01 in the proleptic Gregorian calendar
+    year -= (month <= 2) ? 1 : 0;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    long yearOfEra = year - era * 400;
+    long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return (time_t)(era * 146097 + dayOfEra - 719468) * SECONDS_IN_DAY;
+}
+
+time_t timeFromTM(tm timeInfo)
+{
+    // Seconds of a local time, counted as if it were UTC
+    return timeFromDate(timeInfo.tm_year + 1900, timeInfo.tm_mon + 1, timeInfo.tm_mday) + timeInfo.tm_hour * 3600 + timeInfo.tm_min * 60 + timeInfo.tm_sec;
+}
+
 tm tmFromHTTPDateString(String httpDateString, float toTimezone)
 {
     // Wed, 21 Oct 2015 07:28:00 GMT
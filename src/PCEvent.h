@@ -2,22 +2,58 @@
 #define PCEVENT_H_INCLUDE
 
 #include <Arduino.h>
-#include <map>
+#include <vector>
 #include <time.h>
 
+#include "PCBodyReader.h"
+#include "PCArena.h"
+#include "PCRecurrence.h"
+#include "PCFeedCache.h"
+
+#define MIN_VALID_TIME 1577836800 // 2020-01-01, earlier clocks were never set
+
 int dayOfWeek(int year, int month, int day);
 int numberOfDaysInMonth(int year, int month);
 tm tmFromICalDateString(String iCalDateString, float toTimezone);
 tm tmFromHTTPDateString(String httpDateString, float toTimezone);
 tm convertTimezone(tm timeInfo, float toTimezone);
+tm tmFromICalProperty(String property, float toTimezone);
+time_t timeFromDate(int year, int month, int day);
+time_t timeFromTM(tm timeInfo);
+
 
+// VEVENT block kept in the arena until events are built
+typedef struct
+{
+    const char *block;
+    size_t length;
+    boolean holiday;
+    boolean duplicate;
+    int feed;
+    uint32_t uidHash;
+    time_t recurrenceID;
+    uint32_t titleHash;
+    time_t dayStart;
+    uint8_t color;
+    boolean compact; // a PCAL event, block is its title
+    time_t start;
+    time_t end;
+    boolean recurring; // expanded in buildEvents()
+} PCPendingEvent;
 
 class PCEvent
 {
 public:
     PCEvent(String sourceString, float toTimezone);
+    PCEvent(const char *source, size_t length, float toTimezone, PCRecurrence *recurrence = NULL);
     PCEvent(int year, int month, int day, String title);
+    PCEvent(time_t start, time_t end, boolean isDayEvent, const char *title, uint32_t uidHash, time_t recurrenceID);
     time_t getTimeT() const;
+    time_t getStartTime() const;
+    time_t getEndTime() const;
+    uint32_t getUIDHash() const;
+    time_t getRecurrenceID() const;
+    PCEvent occurrenceAt(time_t start) const;
     int getYear();
     int getMonth();
     int getDay();
@@ -27,8 +63,10 @@ public:
     int getSecond();
     String descriptionForDay(boolean isToday);
     double duration();
+    boolean isDayEvent();
     String getTitle();
     boolean isHolidayEvent;
+    uint8_t color;
 
     static float defaultTimezone;
     static tm currentTimeinfo;
@@ -39,30 +77,76 @@ public:
     static int nextMonth;
     static void initialize(String rootCA, float timezone, String holidayCacheString = "");
     static void setRootCA(String newRootCA);
+    static void setDuplicatePolicy(String policy);
+    static void setEventsPerDay(int eventsPerDay);
+    static void setMountFunction(boolean (*mount)());
     static void setTimeinfo(tm timeinfo);
     static void setHolidayCacheString(String cacheString);
     static String holidayCacheString();
+    static void addRuleHolidays();
     static boolean isCacheValid();
+    static boolean isFileURL(String urlString);
+    static boolean loadFeed(const PCFeed &feed);
     static boolean loadICalendar(String urlString, boolean holiday);
+    static boolean loadICalendarFile(String urlString, boolean holiday);
+    static uint32_t parseICalendar(PCBodyReader &reader, boolean holiday);
+    static uint32_t parseCompact(PCBodyReader &reader, boolean holiday);
+    static void buildEvents();
+    static void releaseEvents();
+    static boolean feedsUnchanged();
+    static int numberOfChangedFeeds();
+    static int numberOfStaleFeeds();
+    static size_t lastFeedBytes();
+    static int numberOfDuplicates();
+    static int numberOfOverflowEvents(time_t dayStart);
+    static int numberOfOverflowEvents();
     static int numberOfEventsInThisMonth();
     static int numberOfEventsInDayOfThisMonth(int day);
     static std::vector<PCEvent> eventsInDayOfThisMonth(int day);
     static int numberOfHolidaysInDayOfThisMonth(int day);
     static std::vector<PCEvent> holidaysInDayOfThisMonth(int day);
     static std::vector<PCEvent> eventsInNextMonth();
+    static std::vector<PCEvent> eventsInRange(time_t start, time_t end);
+    static std::vector<PCEvent> holidaysInRange(time_t start, time_t end);
+    static int numberOfEventsInRange(time_t start, time_t end);
+    static time_t windowStart();
+    static time_t windowEnd();
 
 private:
     tm _startTM;
     tm _endTM;
     boolean _isDayEvent;
     float _timezone;
-    String _title;
+    const char *_title;
+    uint32_t _uidHash;
+    time_t _recurrenceID;
 
     static String _rootCA;
     static boolean _isCacheValid;
-    static std::multimap<int, PCEvent> _eventsInThisMonth;
-    static std::multimap<int, PCEvent> _holidaysInThisMonth;
-    static std::vector<PCEvent> _eventsInNextMonth;
+    static time_t _windowStart;
+    static time_t _windowEnd;
+    static std::vector<PCPendingEvent, PCArenaAllocator<PCPendingEvent>> _pendingEvents;
+    static int _numberOfFeeds;
+    static int _numberOfChangedFeeds;
+    static int _numberOfStaleFeeds;
+    static size_t _lastFeedBytes;
+    static int _numberOfDuplicates;
+    static int _numberOfParsedFeeds;
+    static boolean _laterFeedWins;
+    static int _eventsPerDay;
+    static uint32_t _feedPriority;
+    static uint8_t _feedColor;
+    static uint32_t _feedMaxSize;
+    static boolean _lastFeedComplete;
+    static boolean (*_mount)();
+
+    static boolean setTimeinfoFromClock();
+    static boolean loadFeedWithCopy(const PCFeed &feed);
+    static uint32_t parseSource(PCBodyReader &reader, String urlString, boolean holiday);
+    static boolean retain(const PCPendingEvent &pending, time_t start, time_t end, boolean isDateEvent, int &replacedIndex);
+    static void removeDuplicates();
+
+    static boolean recordFeedHash(String urlString, uint32_t contentHash);
 };
 
 bool operator<(const PCEvent&left, const PCEvent&right) ;
@@ -0,0 +1,106 @@
+#include <algorithm>
+
+#include "PCEventIndex.h"
+
+PCEventIndex::PCEventIndex()
+{
+    _isBuilt = true;
+}
+
+void PCEventIndex::clear()
+{
+    // Swap instead of clear() so no capacity in the arena is kept
+    std::vector<PCEvent, PCArenaAllocator<PCEvent>>().swap(_events);
+    std::vector<time_t, PCArenaAllocator<time_t>>().swap(_starts);
+    std::vector<time_t, PCArenaAllocator<time_t>>().swap(_ends);
+    std::vector<time_t, PCArenaAllocator<time_t>>().swap(_maxEnds);
+    _isBuilt = true;
+}
+
+void PCEventIndex::reserve(int count)
+{
+    // Growing in the arena leaves the old arrays behind, so size them once
+    _events.reserve(_events.size() + count);
+}
+
+void PCEventIndex::add(const PCEvent &event)
+{
+    _events.push_back(event);
+    _isBuilt = false;
+}
+
+int PCEventIndex::size()
+{
+    return _events.size();
+}
+
+std::vector<PCEvent> PCEventIndex::eventsInRange(time_t start, time_t end)
+{
+    build();
+    std::vector<int> indexes;
+    query(0, (int)_events.size() - 1, start, end, indexes);
+    std::vector<PCEvent> result;
+    result.reserve(indexes.size());
+    for (int index : indexes)
+    {
+        result.push_back(_events[index]);
+    }
+    return result;
+}
+
+int PCEventIndex::numberOfEventsInRange(time_t start, time_t end)
+{
+    build();
+    std::vector<int> indexes;
+    query(0, (int)_events.size() - 1, start, end, indexes);
+    return indexes.size();
+}
+
+void PCEventIndex::build()
+{
+    if (_isBuilt)
+        return;
+    std::stable_sort(_events.begin(), _events.end(), [](const PCEvent &left, const PCEvent &right)
+                     { return left.getStartTime() < right.getStartTime(); });
+    int count = _events.size();
+    _starts.resize(count);
+    _ends.resize(count);
+    _maxEnds.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        _starts[i] = _events[i].getStartTime();
+        _ends[i] = _events[i].getEndTime();
+    }
+    buildMaxEnd(0, count - 1);
+    _isBuilt = true;
+}
+
+time_t PCEventIndex::buildMaxEnd(int low, int high)
+{
+    if (low > high)
+        return 0;
+    int middle = (low + high) / 2;
+    time_t maxEnd = _ends[middle];
+    maxEnd = max(maxEnd, buildMaxEnd(low, middle - 1));
+    maxEnd = max(maxEnd, buildMaxEnd(middle + 1, high));
+    _maxEnds[middle] = maxEnd;
+    return maxEnd;
+}
+
+void PCEventIndex::query(int low, int high, time_t start, time_t end, std::vector<int> &result)
+{
+    while (low <= high)
+    {
+        int middle = (low + high) / 2;
+        if (_maxEnds[middle] <= start)
+            return; // nothing in this subtree ends after the range starts
+        query(low, middle - 1, start, end, result);
+        if (_starts[middle] >= end)
+            return; // this and all later events start after the range
+        if (_ends[middle] > start)
+        {
+            result.push_back(middle);
+        }
+        low = middle + 1;
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef PCEVENTINDEX_H_INCLUDE
+#define PCEVENTINDEX_H_INCLUDE
+
+#include <Arduino.h>
+#include <vector>
+
+#include "PCEvent.h"
+#include "PCArena.h"
+
+// Interval index over event [start, end) ranges.
+// Events are sorted by start time and each node of the implicit binary tree
+// over the sorted array keeps the largest end time of its subtree, so
+// overlap queries take O(log n + k).
+// Arrays are allocated in the arena and live until PCArena::release().
+class PCEventIndex
+{
+public:
+    PCEventIndex();
+    void clear();
+    void reserve(int count);
+    void add(const PCEvent &event);
+    int size();
+    std::vector<PCEvent> eventsInRange(time_t start, time_t end);
+    int numberOfEventsInRange(time_t start, time_t end);
+
+private:
+    void build();
+    time_t buildMaxEnd(int low, int high);
+    void query(int low, int high, time_t start, time_t end, std::vector<int> &result);
+
+    std::vector<PCEvent, PCArenaAllocator<PCEvent>> _events;
+    std::vector<time_t, PCArenaAllocator<time_t>> _starts;
+    std::vector<time_t, PCArenaAllocator<time_t>> _ends;
+    std::vector<time_t, PCArenaAllocator<time_t>> _maxEnds;
+    boolean _isBuilt;
+};
+
+#endif
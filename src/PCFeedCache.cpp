@@ -0,0 +1,193 @@
+#include "PCFeedCache.h"
+
+#define FEED_WRITE_BUFFER_SIZE 2048
+
+// Copy written at each complete fetch of a feed
+typedef struct
+{
+    uint32_t urlHash;
+    uint32_t month;
+    uint32_t fetchedAt;
+} PCFeedCopy;
+
+RTC_DATA_ATTR static PCFeedCopy feedCopies[MAX_CACHED_FEEDS];
+RTC_DATA_ATTR static int nextFeedCopyIndex = 0;
+
+static File writingFile;
+static uint8_t *writeBuffer = NULL;
+static size_t writeBufferLength = 0;
+static boolean writeFailed = false;
+
+static uint32_t fnv1a(uint32_t hash, const char *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+static uint32_t urlHashOfFeed(const PCFeed &feed)
+{
+    return fnv1a(2166136261UL, feed.url.c_str(), feed.url.length());
+}
+
+PCFeed PCFeedCache::feedFromLine(String line)
+{
+    PCFeed feed = {"", 0, 0, 0, 0, FEED_COLOR_BLACK};
+    line.trim();
+    int end = line.indexOf(' ');
+    feed.url = (end < 0) ? line : line.substring(0, end);
+    while (end >= 0)
+    {
+        int start = end + 1;
+        end = line.indexOf(' ', start);
+        String option = (end < 0) ? line.substring(start) : line.substring(start, end);
+        int equal = option.indexOf('=');
+        if (equal < 0)
+            continue;
+        String key = option.substring(0, equal);
+        String value = option.substring(equal + 1);
+        if (key == "refresh")
+            feed.refreshMinutes = value.toInt();
+        else if (key == "maxSize")
+            feed.maxSize = value.toInt();
+        else if (key == "budget")
+            feed.budgetSeconds = value.toInt();
+        else if (key == "priority")
+            feed.priority = min((uint32_t)value.toInt(), (uint32_t)MAX_FEED_PRIORITY);
+        else if (key == "color")
+            feed.color = (value == "red") ? FEED_COLOR_RED : FEED_COLOR_BLACK;
+        else
+            log_printf("Unknown feed option: %s\n", option.c_str());
+    }
+    return feed;
+}
+
+// 202410 for October 2024, the month the loading window is built for
+uint32_t PCFeedCache::monthOfTime(time_t localTime)
+{
+    tm date;
+    gmtime_r(&localTime, &date);
+    return (date.tm_year + 1900) * 100 + date.tm_mon + 1;
+}
+
+int PCFeedCache::indexOfFeed(const PCFeed &feed)
+{
+    uint32_t urlHash = urlHashOfFeed(feed);
+    for (int i = 0; i < MAX_CACHED_FEEDS; i++)
+    {
+        if (feedCopies[i].urlHash == urlHash)
+            return i;
+    }
+    return -1;
+}
+
+boolean PCFeedCache::isDue(const PCFeed &feed, time_t now, uint32_t month)
+{
+    if (feed.refreshMinutes == 0 || !hasCopy(feed, month))
+        return true;
+    PCFeedCopy &copy = feedCopies[indexOfFeed(feed)];
+    // A clock set back also makes the copy due
+    return now < (time_t)copy.fetchedAt || now - (time_t)copy.fetchedAt >= (time_t)feed.refreshMinutes * 60;
+}
+
+boolean PCFeedCache::hasCopy(const PCFeed &feed, uint32_t month)
+{
+    int index = indexOfFeed(feed);
+    return index >= 0 && feedCopies[index].month == month;
+}
+
+// Whether a fetch of the feed now writes its copy
+boolean PCFeedCache::needsCopy(const PCFeed &feed, time_t now, uint32_t month)
+{
+    if (feed.refreshMinutes > 0 || !hasCopy(feed, month))
+        return true;
+    PCFeedCopy &copy = feedCopies[indexOfFeed(feed)];
+    return now < (time_t)copy.fetchedAt || now - (time_t)copy.fetchedAt >= (time_t)FALLBACK_COPY_MINUTES * 60;
+}
+
+String PCFeedCache::pathOfFeed(const PCFeed &feed)
+{
+    char name[16];
+    sprintf(name, "/%08x.ics", urlHashOfFeed(feed));
+    return String(FEED_CACHE_DIRECTORY) + name;
+}
+
+boolean PCFeedCache::beginWrite(fs::FS &fs, const PCFeed &feed)
+{
+    writeBuffer = (uint8_t *)malloc(FEED_WRITE_BUFFER_SIZE);
+    if (writeBuffer == NULL)
+        return false;
+    fs.mkdir(FEED_CACHE_DIRECTORY);
+    writingFile = fs.open(pathOfFeed(feed) + ".tmp", FILE_WRITE, true);
+    if (!writingFile)
+    {
+        free(writeBuffer);
+        writeBuffer = NULL;
+        return false;
+    }
+    writeBufferLength = 0;
+    writeFailed = false;
+    return true;
+}
+
+// Called by the parser for each block in the window, before the per-day limit
+void PCFeedCache::write(const char *block, size_t length)
+{
+    if (writeBuffer == NULL || writeFailed)
+        return;
+    if (writeBufferLength + length > FEED_WRITE_BUFFER_SIZE)
+    {
+        writeFailed = writingFile.write(writeBuffer, writeBufferLength) != writeBufferLength;
+        writeBufferLength = 0;
+    }
+    if (length > FEED_WRITE_BUFFER_SIZE)
+    {
+        writeFailed = writeFailed || writingFile.write((const uint8_t *)block, length) != length;
+        return;
+    }
+    memcpy(writeBuffer + writeBufferLength, block, length);
+    writeBufferLength += length;
+}
+
+boolean PCFeedCache::isWriting()
+{
+    return writeBuffer != NULL && !writeFailed;
+}
+
+// The copy replaces the previous one only when the whole feed was read
+boolean PCFeedCache::endWrite(fs::FS &fs, const PCFeed &feed, boolean complete, time_t fetchedAt, uint32_t month)
+{
+    if (writeBuffer == NULL)
+        return false;
+    if (!writeFailed && writeBufferLength > 0)
+    {
+        writeFailed = writingFile.write(writeBuffer, writeBufferLength) != writeBufferLength;
+    }
+    size_t length = writingFile.size();
+    writingFile.close();
+    free(writeBuffer);
+    writeBuffer = NULL;
+
+    String path = pathOfFeed(feed);
+    if (!complete || writeFailed)
+    {
+        fs.remove(path + ".tmp");
+        return false;
+    }
+    fs.remove(path);
+    if (!fs.rename(path + ".tmp", path))
+        return false;
+
+    int index = indexOfFeed(feed);
+    if (index < 0)
+    {
+        index = nextFeedCopyIndex;
+        nextFeedCopyIndex = (nextFeedCopyIndex + 1) % MAX_CACHED_FEEDS;
+    }
+    feedCopies[index] = {urlHashOfFeed(feed), month, (uint32_t)fetchedAt};
+    log_printf("Feed copy %s: %u bytes\n", path.c_str(), (unsigned int)length);
+    return true;
+}
@@ -0,0 +1,54 @@
+#ifndef PCFEEDCACHE_H_INCLUDE
+#define PCFEEDCACHE_H_INCLUDE
+
+#include <Arduino.h>
+#include <FS.h>
+
+#define FEED_CACHE_DIRECTORY "/feeds"
+#define MAX_CACHED_FEEDS 8
+#define MAX_FEED_PRIORITY 9
+#define FEED_COLOR_BLACK 0
+#define FEED_COLOR_RED 1
+#define FALLBACK_COPY_MINUTES 360 // age of the copy of a feed fetched on every wake before it is written again
+
+// One iCalendarURL line of settings.txt.
+// Options follow the URL, separated by spaces:
+//  iCalendarURL:https://example.com/a.ics refresh=360 maxSize=200000 budget=15 priority=2 color=red
+typedef struct
+{
+    String url;
+    uint32_t refreshMinutes; // 0: fetched on every wake
+    uint32_t maxSize;        // bytes, 0: no limit
+    uint32_t budgetSeconds;  // 0: feedBudget of the settings
+    uint32_t priority;       // 0 to 9, higher is kept first when a day is full
+    uint8_t color;
+} PCFeed;
+
+// SD card copies of feeds.
+// A fetch writes the VEVENT blocks in the loading window to a file, so wakes
+// before the refresh interval ends parse a few KB from SD card instead of
+// downloading the feed. Feeds fetched on every wake keep a copy too, which is
+// used when a fetch fails or runs out of budget. Those are written again only
+// every FALLBACK_COPY_MINUTES, so most of their wakes need no SD card. The
+// copy is valid for the month it was built in, since the window moves with it.
+// When and for which month each copy was written is kept in RTC memory, so a
+// cold boot fetches every feed once.
+class PCFeedCache
+{
+public:
+    static PCFeed feedFromLine(String line);
+    static uint32_t monthOfTime(time_t localTime);
+    static boolean isDue(const PCFeed &feed, time_t now, uint32_t month);
+    static boolean hasCopy(const PCFeed &feed, uint32_t month);
+    static boolean needsCopy(const PCFeed &feed, time_t now, uint32_t month);
+    static String pathOfFeed(const PCFeed &feed);
+    static boolean beginWrite(fs::FS &fs, const PCFeed &feed);
+    static void write(const char *block, size_t length);
+    static boolean isWriting();
+    static boolean endWrite(fs::FS &fs, const PCFeed &feed, boolean complete, time_t fetchedAt, uint32_t month);
+
+private:
+    static int indexOfFeed(const PCFeed &feed);
+};
+
+#endif
@@ -0,0 +1,560 @@
+#include "PCFrameKernels.h"
+
+// Vector blocks of invert, orMerge and xorDiff. The PIE loads of the
+// ESP32-S3 take 16 byte aligned blocks, SSE2 and AVX2 any address.
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+#define VECTOR_BYTES 16
+#define VECTOR_ALIGNMENT 16
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define VECTOR_BYTES 32
+#define VECTOR_ALIGNMENT 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define VECTOR_BYTES 16
+#define VECTOR_ALIGNMENT 1
+#endif
+
+#define HASH_PRIME 0x100000001B3ULL
+
+// Word loads need both pointers on a 4 byte boundary, Xtensa faults otherwise
+static inline boolean isWordAligned(const void *first, const void *second)
+{
+    return (((uintptr_t)first | (uintptr_t)second) & 3) == 0;
+}
+
+#ifdef VECTOR_BYTES
+// Bytes before the first vector block, or length when the planes are not
+// aligned alike and no block can be loaded
+static inline size_t vectorHead(const void *first, const void *second, const void *third, size_t length)
+{
+    uintptr_t offset = (uintptr_t)first & (VECTOR_ALIGNMENT - 1);
+    if ((((uintptr_t)first ^ (uintptr_t)second) | ((uintptr_t)first ^ (uintptr_t)third)) & (VECTOR_ALIGNMENT - 1))
+        return length;
+    return min(length, (size_t)((VECTOR_ALIGNMENT - offset) & (VECTOR_ALIGNMENT - 1)));
+}
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+// ee.vld.128.ip and ee.vst.128.ip move one q register and step the
+// pointer, loopgtz runs the body blocks times without a branch
+static inline void invertBlocks(uint8_t *destination, const uint8_t *source, size_t blocks)
+{
+    asm volatile("loopgtz %[blocks], .LinvertEnd%=\n"
+                 "ee.vld.128.ip q0, %[source], 16\n"
+                 "ee.notq q0, q0\n"
+                 "ee.vst.128.ip q0, %[destination], 16\n"
+                 ".LinvertEnd%=:\n"
+                 : [destination] "+r"(destination), [source] "+r"(source)
+                 : [blocks] "r"(blocks)
+                 : "memory");
+}
+
+static inline void orBlocks(uint8_t *destination, const uint8_t *source, size_t blocks)
+{
+    const uint8_t *load = destination;
+    asm volatile("loopgtz %[blocks], .LorEnd%=\n"
+                 "ee.vld.128.ip q0, %[load], 16\n"
+                 "ee.vld.128.ip q1, %[source], 16\n"
+                 "ee.orq q0, q0, q1\n"
+                 "ee.vst.128.ip q0, %[destination], 16\n"
+                 ".LorEnd%=:\n"
+                 : [destination] "+r"(destination), [load] "+r"(load), [source] "+r"(source)
+                 : [blocks] "r"(blocks)
+                 : "memory");
+}
+
+// Nonzero when any block differs. q2 collects the OR of the differences.
+static inline uint32_t xorBlocks(uint8_t *destination, const uint8_t *previous, const uint8_t *current, size_t blocks)
+{
+    uint32_t difference[4] __attribute__((aligned(16)));
+    uint32_t *collected = difference;
+    if (destination != NULL)
+    {
+        asm volatile("ee.zero.q q2\n"
+                     "loopgtz %[blocks], .LxorEnd%=\n"
+                     "ee.vld.128.ip q0, %[previous], 16\n"
+                     "ee.vld.128.ip q1, %[current], 16\n"
+                     "ee.xorq q0, q0, q1\n"
+                     "ee.orq q2, q2, q0\n"
+                     "ee.vst.128.ip q0, %[destination], 16\n"
+                     ".LxorEnd%=:\n"
+                     "ee.vst.128.ip q2, %[collected], 0\n"
+                     : [destination] "+r"(destination), [previous] "+r"(previous), [current] "+r"(current), [collected] "+r"(collected)
+                     : [blocks] "r"(blocks)
+                     : "memory");
+    }
+    else
+    {
+        asm volatile("ee.zero.q q2\n"
+                     "loopgtz %[blocks], .LdiffEnd%=\n"
+                     "ee.vld.128.ip q0, %[previous], 16\n"
+                     "ee.vld.128.ip q1, %[current], 16\n"
+                     "ee.xorq q0, q0, q1\n"
+                     "ee.orq q2, q2, q0\n"
+                     ".LdiffEnd%=:\n"
+                     "ee.vst.128.ip q2, %[collected], 0\n"
+                     : [previous] "+r"(previous), [current] "+r"(current), [collected] "+r"(collected)
+                     : [blocks] "r"(blocks)
+                     : "memory");
+    }
+    return difference[0] | difference[1] | difference[2] | difference[3];
+}
+#elif defined(__AVX2__)
+static inline void invertBlocks(uint8_t *destination, const uint8_t *source, size_t blocks)
+{
+    const __m256i ones = _mm256_set1_epi32(-1);
+    for (size_t b = 0; b < blocks; b++)
+    {
+        __m256i bits = _mm256_loadu_si256((const __m256i *)source + b);
+        _mm256_storeu_si256((__m256i *)destination + b, _mm256_xor_si256(bits, ones));
+    }
+}
+
+static inline void orBlocks(uint8_t *destination, const uint8_t *source, size_t blocks)
+{
+    for (size_t b = 0; b < blocks; b++)
+    {
+        __m256i bits = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)destination + b), _mm256_loadu_si256((const __m256i *)source + b));
+        _mm256_storeu_si256((__m256i *)destination + b, bits);
+    }
+}
+
+static inline uint32_t xorBlocks(uint8_t *destination, const uint8_t *previous, const uint8_t *current, size_t blocks)
+{
+    __m256i difference = _mm256_setzero_si256();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        __m256i bits = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)previous + b), _mm256_loadu_si256((const __m256i *)current + b));
+        if (destination != NULL)
+            _mm256_storeu_si256((__m256i *)destination + b, bits);
+        difference = _mm256_or_si256(difference, bits);
+    }
+    return !_mm256_testz_si256(difference, difference);
+}
+#else
+static inline void invertBlocks(uint8_t *destination, const uint8_t *source, size_t blocks)
+{
+    const __m128i ones = _mm_set1_epi32(-1);
+    for (size_t b = 0; b < blocks; b++)
+    {
+        __m128i bits = _mm_loadu_si128((const __m128i *)source + b);
+        _mm_storeu_si128((__m128i *)destination + b, _mm_xor_si128(bits, ones));
+    }
+}
+
+static inline void orBlocks(uint8_t *destination, const uint8_t *source, size_t blocks)
+{
+    for (size_t b = 0; b < blocks; b++)
+    {
+        __m128i bits = _mm_or_si128(_mm_loadu_si128((const __m128i *)destination + b), _mm_loadu_si128((const __m128i *)source + b));
+        _mm_storeu_si128((__m128i *)destination + b, bits);
+    }
+}
+
+static inline uint32_t xorBlocks(uint8_t *destination, const uint8_t *previous, const uint8_t *current, size_t blocks)
+{
+    __m128i difference = _mm_setzero_si128();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        __m128i bits = _mm_xor_si128(_mm_loadu_si128((const __m128i *)previous + b), _mm_loadu_si128((const __m128i *)current + b));
+        if (destination != NULL)
+            _mm_storeu_si128((__m128i *)destination + b, bits);
+        difference = _mm_or_si128(difference, bits);
+    }
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(difference, _mm_setzero_si128())) != 0xFFFF;
+}
+#endif
+#endif
+
+// XOR of one row of words, nonzero when the row differs
+static inline uint32_t xorWords(uint8_t *destination, const uint8_t *previous, const uint8_t *current, size_t words)
+{
+    const uint32_t *previousWords = (const uint32_t *)previous;
+    const uint32_t *currentWords = (const uint32_t *)current;
+    uint32_t difference = 0;
+    if (destination != NULL)
+    {
+        uint32_t *destinationWords = (uint32_t *)destination;
+        for (size_t w = 0; w < words; w++)
+        {
+            destinationWords[w] = previousWords[w] ^ currentWords[w];
+            difference |= destinationWords[w];
+        }
+    }
+    else
+    {
+        for (size_t w = 0; w < words; w++)
+        {
+            difference |= previousWords[w] ^ currentWords[w];
+        }
+    }
+    return difference;
+}
+
+static inline uint64_t mixBlock(uint64_t hash, uint64_t block)
+{
+    hash = (hash ^ block) * HASH_PRIME;
+    return hash ^ (hash >> 32);
+}
+
+static inline uint64_t finishHash(uint64_t hash, const uint8_t *tail, size_t tailLength, size_t length)
+{
+    for (size_t i = 0; i < tailLength; i++)
+    {
+        hash = (hash ^ tail[i]) * HASH_PRIME;
+    }
+    return hash ^ (hash >> 32) ^ length;
+}
+
+void PCFrameKernels::invert(uint8_t *destination, const uint8_t *source, size_t length)
+{
+    size_t i = 0;
+#ifdef VECTOR_BYTES
+    size_t head = vectorHead(destination, source, source, length);
+    invertScalar(destination, source, head);
+    size_t blocks = (length - head) / VECTOR_BYTES;
+    invertBlocks(destination + head, source + head, blocks);
+    i = head + blocks * VECTOR_BYTES;
+#endif
+    if (isWordAligned(destination + i, source + i))
+    {
+        uint32_t *destinationWords = (uint32_t *)(destination + i);
+        const uint32_t *sourceWords = (const uint32_t *)(source + i);
+        size_t words = (length - i) / 4;
+        for (size_t w = 0; w < words; w++)
+        {
+            destinationWords[w] = ~sourceWords[w];
+        }
+        i += words * 4;
+    }
+    for (; i < length; i++)
+    {
+        destination[i] = ~source[i];
+    }
+}
+
+void PCFrameKernels::orMerge(uint8_t *destination, const uint8_t *source, size_t length)
+{
+    size_t i = 0;
+#ifdef VECTOR_BYTES
+    size_t head = vectorHead(destination, source, source, length);
+    orMergeScalar(destination, source, head);
+    size_t blocks = (length - head) / VECTOR_BYTES;
+    orBlocks(destination + head, source + head, blocks);
+    i = head + blocks * VECTOR_BYTES;
+#endif
+    if (isWordAligned(destination + i, source + i))
+    {
+        uint32_t *destinationWords = (uint32_t *)(destination + i);
+        const uint32_t *sourceWords = (const uint32_t *)(source + i);
+        size_t words = (length - i) / 4;
+        for (size_t w = 0; w < words; w++)
+        {
+            destinationWords[w] |= sourceWords[w];
+        }
+        i += words * 4;
+    }
+    for (; i < length; i++)
+    {
+        destination[i] |= source[i];
+    }
+}
+
+// XOR of two planes, destination may be NULL when only the dirty rows matter.
+// Bit r of dirtyRows is set when row r differs.
+int PCFrameKernels::xorDiff(uint8_t *destination, const uint8_t *previous, const uint8_t *current, size_t rowBytes, int rows, uint8_t *dirtyRows)
+{
+    if (rowBytes % 4 != 0 || !isWordAligned(previous, current) || (destination != NULL && !isWordAligned(destination, previous)))
+        return xorDiffScalar(destination, previous, current, rowBytes, rows, dirtyRows);
+
+    int numberOfDirtyRows = 0;
+    for (int row = 0; row < rows; row++)
+    {
+        size_t offset = row * rowBytes;
+        uint8_t *rowDestination = (destination != NULL) ? destination + offset : NULL;
+        uint32_t difference = 0;
+        size_t i = 0;
+#ifdef VECTOR_BYTES
+        // Rows start at word boundaries, so the head before the blocks is whole words
+        size_t head = vectorHead(previous + offset, current + offset, rowDestination ? rowDestination : previous + offset, rowBytes);
+        difference = xorWords(rowDestination, previous + offset, current + offset, head / 4);
+        size_t blocks = (rowBytes - head) / VECTOR_BYTES;
+        difference |= xorBlocks(rowDestination ? rowDestination + head : NULL, previous + offset + head, current + offset + head, blocks);
+        i = head + blocks * VECTOR_BYTES;
+#endif
+        difference |= xorWords(rowDestination ? rowDestination + i : NULL, previous + offset + i, current + offset + i, (rowBytes - i) / 4);
+        if (dirtyRows != NULL)
+        {
+            if (difference != 0)
+                dirtyRows[row / 8] |= (1 << (row % 8));
+            else
+                dirtyRows[row / 8] &= ~(1 << (row % 8));
+        }
+        numberOfDirtyRows += (difference != 0) ? 1 : 0;
+    }
+    return numberOfDirtyRows;
+}
+
+// 8 byte little-endian blocks, each mixed by an FNV multiply and a fold
+uint64_t PCFrameKernels::hash64(const uint8_t *data, size_t length, uint64_t seed)
+{
+    if (!isWordAligned(data, data))
+        return hash64Scalar(data, length, seed);
+    uint64_t hash = seed;
+    const uint32_t *words = (const uint32_t *)data;
+    size_t blocks = length / 8;
+    for (size_t b = 0; b < blocks; b++)
+    {
+        hash = mixBlock(hash, (uint64_t)words[b * 2] | ((uint64_t)words[b * 2 + 1] << 32));
+    }
+    return finishHash(hash, data + blocks * 8, length % 8, length);
+}
+
+// PackBits: header n >= 0 is followed by n + 1 literal bytes,
+// -127 <= n <= -1 by one byte repeated 1 - n times
+size_t PCFrameKernels::encodeRuns(const uint8_t *source, size_t length, uint8_t *destination)
+{
+    size_t in = 0;
+    size_t out = 0;
+    while (in < length)
+    {
+        // Once two bytes match, aligned words equal to the run are skipped
+        // whole, and the lowest differing byte of the first other word ends
+        // the run. Literal bytes never reach the word loop.
+        uint8_t value = source[in];
+        size_t end = min(length, in + 128);
+        size_t position = in + 1;
+        if (position < end && source[position] == value)
+        {
+            uint32_t pattern = value * 0x01010101UL;
+            position++;
+            while (position < end && ((uintptr_t)(source + position) & 3) != 0 && source[position] == value)
+                position++;
+            uint32_t difference = 0;
+            while (position + 4 <= end && ((uintptr_t)(source + position) & 3) == 0 &&
+                   (difference = *(const uint32_t *)(source + position) ^ pattern) == 0)
+                position += 4;
+            if (difference != 0)
+                position += __builtin_ctz(difference) / 8; // words are little-endian
+            else
+                while (position < end && source[position] == value)
+                    position++;
+        }
+        size_t run = position - in;
+        if (run >= 2)
+        {
+            destination[out++] = (uint8_t)(int8_t)(1 - (int)run);
+            destination[out++] = value;
+            in += run;
+            continue;
+        }
+        // Literal bytes up to the next run of 3 or more
+        size_t literal = 1;
+        while (in + literal < length && literal < 128)
+        {
+            if (in + literal + 2 < length && source[in + literal] == source[in + literal + 1] && source[in + literal] == source[in + literal + 2])
+                break;
+            literal++;
+        }
+        destination[out++] = (uint8_t)(literal - 1);
+        memcpy(destination + out, source + in, literal);
+        out += literal;
+        in += literal;
+    }
+    return out;
+}
+
+boolean PCFrameKernels::decodeRuns(const uint8_t *source, size_t sourceLength, uint8_t *destination, size_t length)
+{
+    size_t in = 0;
+    size_t out = 0;
+    while (in < sourceLength && out < length)
+    {
+        int8_t header = (int8_t)source[in++];
+        if (header >= 0)
+        {
+            size_t literal = header + 1;
+            if (in + literal > sourceLength || out + literal > length)
+                return false;
+            memcpy(destination + out, source + in, literal);
+            in += literal;
+            out += literal;
+        }
+        else if (header != -128)
+        {
+            size_t run = 1 - header;
+            if (in >= sourceLength || out + run > length)
+                return false;
+            memset(destination + out, source[in++], run);
+            out += run;
+        }
+    }
+    return out == length;
+}
+
+size_t PCFrameKernels::maxEncodedLength(size_t length)
+{
+    return length + (length + 127) / 128;
+}
+
+void PCFrameKernels::invertScalar(uint8_t *destination, const uint8_t *source, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        destination[i] = ~source[i];
+    }
+}
+
+void PCFrameKernels::orMergeScalar(uint8_t *destination, const uint8_t *source, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        destination[i] |= source[i];
+    }
+}
+
+int PCFrameKernels::xorDiffScalar(uint8_t *destination, const uint8_t *previous, const uint8_t *current, size_t rowBytes, int rows, uint8_t *dirtyRows)
+{
+    int numberOfDirtyRows = 0;
+    for (int row = 0; row < rows; row++)
+    {
+        uint8_t difference = 0;
+        for (size_t i = row * rowBytes; i < (row + 1) * rowBytes; i++)
+        {
+            uint8_t bits = previous[i] ^ current[i];
+            if (destination != NULL)
+                destination[i] = bits;
+            difference |= bits;
+        }
+        if (dirtyRows != NULL)
+        {
+            if (difference != 0)
+                dirtyRows[row / 8] |= (1 << (row % 8));
+            else
+                dirtyRows[row / 8] &= ~(1 << (row % 8));
+        }
+        numberOfDirtyRows += (difference != 0) ? 1 : 0;
+    }
+    return numberOfDirtyRows;
+}
+
+uint64_t PCFrameKernels::hash64Scalar(const uint8_t *data, size_t length, uint64_t seed)
+{
+    uint64_t hash = seed;
+    size_t blocks = length / 8;
+    for (size_t b = 0; b < blocks; b++)
+    {
+        uint64_t block = 0;
+        for (int i = 7; i >= 0; i--)
+        {
+            block = (block << 8) | data[b * 8 + i];
+        }
+        hash = mixBlock(hash, block);
+    }
+    return finishHash(hash, data + blocks * 8, length % 8, length);
+}
+
+size_t PCFrameKernels::encodeRunsScalar(const uint8_t *source, size_t length, uint8_t *destination)
+{
+    size_t in = 0;
+    size_t out = 0;
+    while (in < length)
+    {
+        size_t run = 1;
+        while (in + run < length && run < 128 && source[in + run] == source[in])
+        {
+            run++;
+        }
+        if (run >= 2)
+        {
+            destination[out++] = (uint8_t)(int8_t)(1 - (int)run);
+            destination[out++] = source[in];
+            in += run;
+            continue;
+        }
+        size_t literal = 1;
+        while (in + literal < length && literal < 128)
+        {
+            if (in + literal + 2 < length && source[in + literal] == source[in + literal + 1] && source[in + literal] == source[in + literal + 2])
+                break;
+            literal++;
+        }
+        destination[out++] = (uint8_t)(literal - 1);
+        memcpy(destination + out, source + in, literal);
+        out += literal;
+        in += literal;
+    }
+    return out;
+}
+
+// Runs every kernel and its reference on two planes, logs both times and
+// returns false when any result differs
+boolean PCFrameKernels::benchmark(const uint8_t *first, const uint8_t *second, size_t rowBytes, int rows)
+{
+    size_t length = rowBytes * rows;
+    size_t encodedLength = maxEncodedLength(length);
+    uint32_t caps = psramFound() ? (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    uint8_t *buffers = (uint8_t *)heap_caps_malloc(length * 3 + encodedLength * 2 + (rows + 7) / 8 * 2, caps);
+    if (buffers == NULL)
+    {
+        log_printf("Kernels: no memory for the benchmark\n");
+        return false;
+    }
+    uint8_t *result = buffers;
+    uint8_t *reference = result + length;
+    uint8_t *decoded = reference + length;
+    uint8_t *encoded = decoded + length;
+    uint8_t *encodedReference = encoded + encodedLength;
+    uint8_t *dirtyRows = encodedReference + encodedLength;
+    uint8_t *dirtyRowsReference = dirtyRows + (rows + 7) / 8;
+    // Bits past the last row are never written, so both bitmaps start clear
+    memset(dirtyRows, 0, (rows + 7) / 8 * 2);
+    boolean agree = true;
+    unsigned long start;
+    unsigned long fast;
+
+    start = micros();
+    invert(result, first, length);
+    fast = micros() - start;
+    start = micros();
+    invertScalar(reference, first, length);
+    log_printf("Kernels: invert %lu us, scalar %lu us\n", fast, micros() - start);
+    agree = agree && memcmp(result, reference, length) == 0;
+
+    start = micros();
+    orMerge(result, second, length);
+    fast = micros() - start;
+    start = micros();
+    orMergeScalar(reference, second, length);
+    log_printf("Kernels: or %lu us, scalar %lu us\n", fast, micros() - start);
+    agree = agree && memcmp(result, reference, length) == 0;
+
+    start = micros();
+    int dirty = xorDiff(result, first, second, rowBytes, rows, dirtyRows);
+    fast = micros() - start;
+    start = micros();
+    int dirtyReference = xorDiffScalar(reference, first, second, rowBytes, rows, dirtyRowsReference);
+    log_printf("Kernels: xor diff %lu us, scalar %lu us, %d dirty rows\n", fast, micros() - start, dirty);
+    agree = agree && dirty == dirtyReference && memcmp(result, reference, length) == 0 && memcmp(dirtyRows, dirtyRowsReference, (rows + 7) / 8) == 0;
+
+    start = micros();
+    uint64_t hash = hash64(first, length);
+    fast = micros() - start;
+    start = micros();
+    uint64_t hashReference = hash64Scalar(first, length);
+    log_printf("Kernels: hash %lu us, scalar %lu us\n", fast, micros() - start);
+    agree = agree && hash == hashReference;
+
+    start = micros();
+    size_t size = encodeRuns(first, length, encoded);
+    fast = micros() - start;
+    start = micros();
+    size_t sizeReference = encodeRunsScalar(first, length, encodedReference);
+    log_printf("Kernels: encode %lu us, scalar %lu us, %u bytes\n", fast, micros() - start, (unsigned int)size);
+    agree = agree && size == sizeReference && memcmp(encoded, encodedReference, size) == 0 &&
+            decodeRuns(encoded, size, decoded, length) && memcmp(decoded, first, length) == 0;
+
+    heap_caps_free(buffers);
+    log_printf("Kernels: %s\n", agree ? "all agree" : "MISMATCH");
+    return agree;
+}
@@ -0,0 +1,34 @@
+#ifndef PCFRAMEKERNELS_H_INCLUDE
+#define PCFRAMEKERNELS_H_INCLUDE
+
+#include <Arduino.h>
+
+#define FRAME_HASH_SEED 0xCBF29CE484222325ULL
+
+// Whole-plane operations on 1-bit framebuffers.
+// Planes are 48 KB, so each kernel walks aligned 32-bit words and leaves only
+// the unaligned head and tail to byte loops. invert, orMerge and xorDiff take
+// 16 byte blocks with the PIE instructions on the ESP32-S3, and SSE2 or AVX2
+// blocks in the native test build. The *Scalar versions are the
+// byte-by-byte references that benchmark() and the native tests compare against.
+class PCFrameKernels
+{
+public:
+    static void invert(uint8_t *destination, const uint8_t *source, size_t length);
+    static void orMerge(uint8_t *destination, const uint8_t *source, size_t length);
+    static int xorDiff(uint8_t *destination, const uint8_t *previous, const uint8_t *current, size_t rowBytes, int rows, uint8_t *dirtyRows);
+    static uint64_t hash64(const uint8_t *data, size_t length, uint64_t seed = FRAME_HASH_SEED);
+    static size_t encodeRuns(const uint8_t *source, size_t length, uint8_t *destination);
+    static boolean decodeRuns(const uint8_t *source, size_t sourceLength, uint8_t *destination, size_t length);
+    static size_t maxEncodedLength(size_t length);
+
+    static void invertScalar(uint8_t *destination, const uint8_t *source, size_t length);
+    static void orMergeScalar(uint8_t *destination, const uint8_t *source, size_t length);
+    static int xorDiffScalar(uint8_t *destination, const uint8_t *previous, const uint8_t *current, size_t rowBytes, int rows, uint8_t *dirtyRows);
+    static uint64_t hash64Scalar(const uint8_t *data, size_t length, uint64_t seed = FRAME_HASH_SEED);
+    static size_t encodeRunsScalar(const uint8_t *source, size_t length, uint8_t *destination);
+
+    static boolean benchmark(const uint8_t *first, const uint8_t *second, size_t rowBytes, int rows);
+};
+
+#endif
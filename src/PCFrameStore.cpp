@@ -0,0 +1,93 @@
+#include "PCFrameStore.h"
+#include "PCFrameKernels.h"
+
+String PCFrameStore::pathOfDate(uint32_t date)
+{
+    return String(FRAME_DIRECTORY) + "/" + String(date) + ".rle";
+}
+
+boolean PCFrameStore::save(fs::FS &fs, uint32_t date, uint32_t renderedAt, int width, int height, const uint8_t *black, const uint8_t *red)
+{
+    size_t length = width * height / 8;
+    uint8_t *buffer = (uint8_t *)malloc(PCFrameKernels::maxEncodedLength(length) * 2);
+    if (buffer == NULL)
+    {
+        log_printf("Frame: no memory to encode %u\n", date);
+        return false;
+    }
+    PCFrameHeader header = {FRAME_MAGIC, FRAME_VERSION, date, renderedAt, (uint32_t)width, (uint32_t)height, 0, 0};
+    header.blackLength = PCFrameKernels::encodeRuns(black, length, buffer);
+    header.redLength = PCFrameKernels::encodeRuns(red, length, buffer + header.blackLength);
+
+    fs.mkdir(FRAME_DIRECTORY);
+    File file = fs.open(pathOfDate(date), FILE_WRITE, true);
+    boolean saved = false;
+    if (file)
+    {
+        size_t dataLength = header.blackLength + header.redLength;
+        saved = file.write((const uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+                file.write(buffer, dataLength) == dataLength;
+        file.close();
+    }
+    free(buffer);
+    log_printf("Frame %u: %u + %u bytes%s\n", date, header.blackLength, header.redLength, saved ? "" : ", write failed");
+    return saved;
+}
+
+boolean PCFrameStore::load(fs::FS &fs, uint32_t date, int width, int height, uint8_t *black, uint8_t *red, uint32_t *renderedAt)
+{
+    File file = fs.open(pathOfDate(date), FILE_READ);
+    if (!file)
+        return false;
+    PCFrameHeader header;
+    size_t length = width * height / 8;
+    boolean valid = file.read((uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+                    header.magic == FRAME_MAGIC && header.version == FRAME_VERSION && header.date == date &&
+                    header.width == (uint32_t)width && header.height == (uint32_t)height &&
+                    header.blackLength <= PCFrameKernels::maxEncodedLength(length) && header.redLength <= PCFrameKernels::maxEncodedLength(length);
+    uint8_t *buffer = valid ? (uint8_t *)malloc(header.blackLength + header.redLength) : NULL;
+    if (buffer != NULL)
+    {
+        size_t dataLength = header.blackLength + header.redLength;
+        valid = file.read(buffer, dataLength) == dataLength &&
+                PCFrameKernels::decodeRuns(buffer, header.blackLength, black, length) &&
+                PCFrameKernels::decodeRuns(buffer + header.blackLength, header.redLength, red, length);
+        free(buffer);
+    }
+    else
+    {
+        valid = false;
+    }
+    file.close();
+    if (valid && renderedAt != NULL)
+    {
+        *renderedAt = header.renderedAt;
+    }
+    return valid;
+}
+
+boolean PCFrameStore::exists(fs::FS &fs, uint32_t date)
+{
+    return fs.exists(pathOfDate(date));
+}
+
+void PCFrameStore::removeBefore(fs::FS &fs, uint32_t date)
+{
+    File directory = fs.open(FRAME_DIRECTORY);
+    if (!directory || !directory.isDirectory())
+        return;
+    File file = directory.openNextFile();
+    while (file)
+    {
+        String name = file.name();
+        file.close();
+        int slash = name.lastIndexOf('/');
+        uint32_t fileDate = name.substring(slash + 1).toInt();
+        if (fileDate < date)
+        {
+            fs.remove(String(FRAME_DIRECTORY) + "/" + name.substring(slash + 1));
+        }
+        file = directory.openNextFile();
+    }
+    directory.close();
+}
@@ -0,0 +1,38 @@
+#ifndef PCFRAMESTORE_H_INCLUDE
+#define PCFRAMESTORE_H_INCLUDE
+
+#include <Arduino.h>
+#include <FS.h>
+
+#define FRAME_DIRECTORY "/frames"
+#define FRAME_MAGIC 0x52464350 // "PCFR"
+#define FRAME_VERSION 1
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t date;
+    uint32_t renderedAt;
+    uint32_t width;
+    uint32_t height;
+    uint32_t blackLength;
+    uint32_t redLength;
+} PCFrameHeader;
+
+// Rendered black and red planes stored on SD card, one file per date.
+// Planes are PackBits encoded: a calendar is mostly white, so a 48 KB plane
+// becomes a few KB and loads quickly without WiFi.
+class PCFrameStore
+{
+public:
+    static boolean save(fs::FS &fs, uint32_t date, uint32_t renderedAt, int width, int height, const uint8_t *black, const uint8_t *red);
+    static boolean load(fs::FS &fs, uint32_t date, int width, int height, uint8_t *black, uint8_t *red, uint32_t *renderedAt = NULL);
+    static boolean exists(fs::FS &fs, uint32_t date);
+    static void removeBefore(fs::FS &fs, uint32_t date);
+
+private:
+    static String pathOfDate(uint32_t date);
+};
+
+#endif
@@ -0,0 +1,245 @@
+#include "PCHoliday.h"
+#include "PCEvent.h"
+
+#define HOLIDAY_FIXED 0
+#define HOLIDAY_MONDAY 1 // day is the week number
+#define HOLIDAY_VERNAL_EQUINOX 2
+#define HOLIDAY_AUTUMNAL_EQUINOX 3
+
+#define SUBSTITUTE_HOLIDAY "振替休日"
+#define CITIZENS_HOLIDAY "国民の休日"
+
+typedef struct
+{
+    uint8_t month;
+    uint8_t day;
+    uint8_t kind;
+    uint16_t fromYear;
+    uint16_t toYear;
+    const char *name;
+} PCHolidayRule;
+
+typedef struct
+{
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+    const char *name;
+} PCSingleHoliday;
+
+static const PCHolidayRule holidayRules[] = {
+    {1, 1, HOLIDAY_FIXED, 1949, 9999, "元日"},
+    {1, 15, HOLIDAY_FIXED, 1949, 1999, "成人の日"},
+    {1, 2, HOLIDAY_MONDAY, 2000, 9999, "成人の日"},
+    {2, 11, HOLIDAY_FIXED, 1967, 9999, "建国記念の日"},
+    {2, 23, HOLIDAY_FIXED, 2020, 9999, "天皇誕生日"},
+    {3, 0, HOLIDAY_VERNAL_EQUINOX, 1949, 9999, "春分の日"},
+    {4, 29, HOLIDAY_FIXED, 1949, 1988, "天皇誕生日"},
+    {4, 29, HOLIDAY_FIXED, 1989, 2006, "みどりの日"},
+    {4, 29, HOLIDAY_FIXED, 2007, 9999, "昭和の日"},
+    {5, 3, HOLIDAY_FIXED, 1949, 9999, "憲法記念日"},
+    {5, 4, HOLIDAY_FIXED, 2007, 9999, "みどりの日"},
+    {5, 5, HOLIDAY_FIXED, 1949, 9999, "こどもの日"},
+    {7, 20, HOLIDAY_FIXED, 1996, 2002, "海の日"},
+    {7, 3, HOLIDAY_MONDAY, 2003, 2019, "海の日"},
+    {7, 3, HOLIDAY_MONDAY, 2022, 9999, "海の日"},
+    {8, 11, HOLIDAY_FIXED, 2016, 2019, "山の日"},
+    {8, 11, HOLIDAY_FIXED, 2022, 9999, "山の日"},
+    {9, 15, HOLIDAY_FIXED, 1966, 2002, "敬老の日"},
+    {9, 3, HOLIDAY_MONDAY, 2003, 9999, "敬老の日"},
+    {9, 0, HOLIDAY_AUTUMNAL_EQUINOX, 1948, 9999, "秋分の日"},
+    {10, 10, HOLIDAY_FIXED, 1966, 1999, "体育の日"},
+    {10, 2, HOLIDAY_MONDAY, 2000, 2019, "体育の日"},
+    {10, 2, HOLIDAY_MONDAY, 2022, 9999, "スポーツの日"},
+    {11, 3, HOLIDAY_FIXED, 1948, 9999, "文化の日"},
+    {11, 23, HOLIDAY_FIXED, 1948, 9999, "勤労感謝の日"},
+    {12, 23, HOLIDAY_FIXED, 1989, 2018, "天皇誕生日"},
+};
+
+// Days set by their own laws, including the moved days of 2020 and 2021
+static const PCSingleHoliday singleHolidays[] = {
+    {1959, 4, 10, "皇太子明仁親王の結婚の儀"},
+    {1989, 2, 24, "昭和天皇の大喪の礼"},
+    {1990, 11, 12, "即位礼正殿の儀"},
+    {1993, 6, 9, "皇太子徳仁親王の結婚の儀"},
+    {2019, 5, 1, "天皇の即位の日"},
+    {2019, 10, 22, "即位礼正殿の儀が行われる日"},
+    {2020, 7, 23, "海の日"},
+    {2020, 7, 24, "スポーツの日"},
+    {2020, 8, 10, "山の日"},
+    {2021, 7, 22, "海の日"},
+    {2021, 7, 23, "スポーツの日"},
+    {2021, 8, 8, "山の日"},
+};
+
+std::vector<PCHolidayOverride> PCHoliday::_overrides;
+
+// Names by day of the year, reused between calls
+static const char *namesOfDays[367];
+static boolean nationalDays[367];
+static int cachedYear = 0;
+static int numberOfCachedHolidays = 0;
+static PCHolidayDate cachedHolidays[MAX_HOLIDAYS_IN_YEAR];
+
+static int dayOfYear(int year, int month, int day)
+{
+    int result = day;
+    for (int i = 1; i < month; i++)
+    {
+        result += numberOfDaysInMonth(year, i);
+    }
+    return result;
+}
+
+boolean PCHoliday::setRules(String rules)
+{
+    return rules == "JP";
+}
+
+void PCHoliday::setOverrides(String overrides)
+{
+    _overrides.clear();
+    cachedYear = 0;
+    int start = 0;
+    while (start < (int)overrides.length())
+    {
+        int end = overrides.indexOf('\n', start);
+        if (end < 0)
+            end = overrides.length();
+        String line = overrides.substring(start, end);
+        start = end + 1;
+        line.trim();
+        int separator = line.indexOf(':');
+        if (line.startsWith("//") || separator != 8)
+            continue;
+        PCHolidayOverride override = {(uint32_t)line.substring(0, 8).toInt(), line.substring(separator + 1)};
+        int year = override.date / 10000;
+        int month = override.date / 100 % 100;
+        int day = override.date % 100;
+        if (year >= 1900 && month >= 1 && month <= 12 && day >= 1 && day <= numberOfDaysInMonth(year, month) && !override.name.isEmpty())
+            _overrides.push_back(override);
+    }
+}
+
+int PCHoliday::vernalEquinoxDay(int year)
+{
+    if (year < 1980 || year > 2099)
+        return 0;
+    return (int)(20.8431 + 0.242194 * (year - 1980)) - (year - 1980) / 4;
+}
+
+int PCHoliday::autumnalEquinoxDay(int year)
+{
+    if (year < 1980 || year > 2099)
+        return 0;
+    return (int)(23.2488 + 0.242194 * (year - 1980)) - (year - 1980) / 4;
+}
+
+int PCHoliday::holidaysInYear(int year, PCHolidayDate *dates, int maxDates)
+{
+    int numberOfDays = dayOfYear(year, 12, 31);
+    int firstDayOfWeek = dayOfWeek(year, 1, 1);
+    memset(namesOfDays, 0, sizeof(namesOfDays));
+    memset(nationalDays, 0, sizeof(nationalDays));
+
+    // Days named by the act or by their own laws
+    for (auto &rule : holidayRules)
+    {
+        if (year < rule.fromYear || year > rule.toYear)
+            continue;
+        int day = rule.day;
+        if (rule.kind == HOLIDAY_MONDAY)
+        {
+            int firstMonday = (8 - dayOfWeek(year, rule.month, 1)) % 7 + 1;
+            day = firstMonday + (rule.day - 1) * 7;
+        }
+        else if (rule.kind == HOLIDAY_VERNAL_EQUINOX)
+            day = vernalEquinoxDay(year);
+        else if (rule.kind == HOLIDAY_AUTUMNAL_EQUINOX)
+            day = autumnalEquinoxDay(year);
+        if (day == 0)
+            continue;
+        namesOfDays[dayOfYear(year, rule.month, day)] = rule.name;
+    }
+    for (auto &single : singleHolidays)
+    {
+        if (single.year == year)
+            namesOfDays[dayOfYear(year, single.month, single.day)] = single.name;
+    }
+    for (auto &override : _overrides)
+    {
+        if ((int)(override.date / 10000) == year)
+            namesOfDays[dayOfYear(year, override.date / 100 % 100, override.date % 100)] = (override.name == "-") ? NULL : override.name.c_str();
+    }
+    for (int i = 1; i <= numberOfDays; i++)
+    {
+        nationalDays[i] = (namesOfDays[i] != NULL);
+    }
+
+    // A holiday on Sunday moves to the next weekday that is not a holiday.
+    // Before 2007 it moved to Monday only.
+    if (year >= 1973)
+    {
+        for (int i = 1; i <= numberOfDays; i++)
+        {
+            if (!nationalDays[i] || (firstDayOfWeek + i - 1) % 7 != 0)
+                continue;
+            int substitute = i + 1;
+            while (year >= 2007 && substitute <= numberOfDays && nationalDays[substitute])
+                substitute++;
+            if (substitute <= numberOfDays && namesOfDays[substitute] == NULL)
+                namesOfDays[substitute] = SUBSTITUTE_HOLIDAY;
+        }
+    }
+
+    // A weekday between two holidays is a holiday too
+    if (year >= 1986)
+    {
+        for (int i = 2; i < numberOfDays; i++)
+        {
+            if (namesOfDays[i] == NULL && nationalDays[i - 1] && nationalDays[i + 1] && (firstDayOfWeek + i - 1) % 7 != 0)
+                namesOfDays[i] = CITIZENS_HOLIDAY;
+        }
+    }
+
+    // Removed days stay removed even if a rule above added them
+    for (auto &override : _overrides)
+    {
+        if ((int)(override.date / 10000) == year && override.name == "-")
+            namesOfDays[dayOfYear(year, override.date / 100 % 100, override.date % 100)] = NULL;
+    }
+
+    int count = 0;
+    int month = 1;
+    int monthStart = 0;
+    for (int i = 1; i <= numberOfDays && count < maxDates; i++)
+    {
+        while (i > monthStart + numberOfDaysInMonth(year, month))
+        {
+            monthStart += numberOfDaysInMonth(year, month);
+            month++;
+        }
+        if (namesOfDays[i] == NULL)
+            continue;
+        dates[count].month = month;
+        dates[count].day = i - monthStart;
+        dates[count].name = namesOfDays[i];
+        count++;
+    }
+    return count;
+}
+
+const char *PCHoliday::nameOfDay(int year, int month, int day)
+{
+    if (year != cachedYear)
+    {
+        numberOfCachedHolidays = holidaysInYear(year, cachedHolidays, MAX_HOLIDAYS_IN_YEAR);
+        cachedYear = year;
+    }
+    for (int i = 0; i < numberOfCachedHolidays; i++)
+    {
+        if (cachedHolidays[i].month == month && cachedHolidays[i].day == day)
+            return cachedHolidays[i].name;
+    }
+    return NULL;
+}
@@ -0,0 +1,44 @@
+#ifndef PCHOLIDAY_H_INCLUDE
+#define PCHOLIDAY_H_INCLUDE
+
+#include <Arduino.h>
+#include <vector>
+
+#define HOLIDAY_OVERRIDE_FILE "/holidays.txt"
+#define MAX_HOLIDAYS_IN_YEAR 40
+
+typedef struct
+{
+    uint8_t month;
+    uint8_t day;
+    const char *name;
+} PCHolidayDate;
+
+typedef struct
+{
+    uint32_t date; // YYYYMMDD
+    String name;   // "-" removes the day
+} PCHolidayOverride;
+
+// Japanese public holidays computed from the rules of the National Holidays Act,
+// so the holiday feed does not have to be fetched.
+// Fixed dates, Happy Monday rules and equinox days come from a table,
+// substitute holidays and days between two holidays are derived from them.
+// Equinox days use the approximation valid from 1980 to 2099.
+// Lines of the override file ("YYYYMMDD:Name" or "YYYYMMDD:-") add or remove
+// single days for changes announced after this table was written.
+class PCHoliday
+{
+public:
+    static boolean setRules(String rules);
+    static void setOverrides(String overrides);
+    static int holidaysInYear(int year, PCHolidayDate *dates, int maxDates);
+    static const char *nameOfDay(int year, int month, int day);
+    static int vernalEquinoxDay(int year);
+    static int autumnalEquinoxDay(int year);
+
+private:
+    static std::vector<PCHolidayOverride> _overrides;
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include "PCLog.h"
+
+#define RECORDS_PER_SECTOR (LOG_SECTOR_SIZE / sizeof(PCLogRecord))
+
+uint8_t PCLog::_level = LOG_INFO;
+
+RTC_DATA_ATTR static PCLogRecord bufferedRecords[LOG_BUFFER_RECORDS];
+RTC_DATA_ATTR static int numberOfBuffered = 0;
+RTC_DATA_ATTR static uint32_t droppedRecords = 0;
+RTC_DATA_ATTR static uint16_t wakeNumber = 0;
+
+static_assert(sizeof(PCLogRecord) == 32, "log records must divide a sector");
+
+void PCLog::begin()
+{
+    wakeNumber++;
+    if (numberOfBuffered < 0 || numberOfBuffered > LOG_BUFFER_RECORDS)
+        numberOfBuffered = 0;
+}
+
+void PCLog::setLevel(uint8_t level)
+{
+    _level = level;
+}
+
+uint8_t PCLog::levelFromString(String levelString)
+{
+    if (levelString == "off")
+        return LOG_OFF;
+    if (levelString == "error")
+        return LOG_ERROR;
+    if (levelString == "verbose")
+        return LOG_VERBOSE;
+    return LOG_INFO;
+}
+
+void PCLog::record(uint8_t level, uint8_t code, int32_t value0, int32_t value1, int32_t value2, int32_t value3)
+{
+    if (level > _level)
+        return;
+    append(level, code, value0, value1, value2, value3);
+}
+
+void PCLog::append(uint8_t level, uint8_t code, int32_t value0, int32_t value1, int32_t value2, int32_t value3)
+{
+    if (numberOfBuffered >= LOG_BUFFER_RECORDS)
+    {
+        droppedRecords++;
+        return;
+    }
+    PCLogRecord &entry = bufferedRecords[numberOfBuffered++];
+    entry.sequence = 0;
+    entry.time = (uint32_t)time(NULL);
+    entry.millis = millis();
+    entry.level = level;
+    entry.code = code;
+    entry.wake = wakeNumber;
+    entry.values[0] = value0;
+    entry.values[1] = value1;
+    entry.values[2] = value2;
+    entry.values[3] = value3;
+}
+
+boolean PCLog::needsFlush()
+{
+    return numberOfBuffered >= LOG_FLUSH_THRESHOLD || droppedRecords > 0;
+}
+
+int PCLog::numberOfBufferedRecords()
+{
+    return numberOfBuffered;
+}
+
+boolean PCLog::openRing(fs::FS &fs, File &file, PCLogHeader &header)
+{
+    size_t fileSize = LOG_SECTOR_SIZE + LOG_CAPACITY * sizeof(PCLogRecord);
+    file = fs.open(LOG_FILE, "r+");
+    if (file && file.size() == fileSize &&
+        file.read((uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+        header.magic == LOG_MAGIC && header.version == LOG_VERSION &&
+        header.recordSize == sizeof(PCLogRecord) && header.capacity == LOG_CAPACITY && header.nextIndex < LOG_CAPACITY)
+        return true;
+    if (file)
+        file.close();
+
+    // Allocate the whole ring once, later flushes only overwrite sectors
+    file = fs.open(LOG_FILE, FILE_WRITE, true);
+    if (!file)
+        return false;
+    uint8_t sector[LOG_SECTOR_SIZE];
+    memset(sector, 0, sizeof(sector));
+    header = {LOG_MAGIC, LOG_VERSION, sizeof(PCLogRecord), LOG_CAPACITY, 0, 1, {0, 0, 0}};
+    memcpy(sector, &header, sizeof(header));
+    for (size_t written = 0; written < fileSize; written += LOG_SECTOR_SIZE)
+    {
+        if (file.write(sector, LOG_SECTOR_SIZE) != LOG_SECTOR_SIZE)
+        {
+            file.close();
+            return false;
+        }
+        memset(sector, 0, sizeof(header));
+    }
+    file.close();
+    file = fs.open(LOG_FILE, "r+");
+    log_printf("Log: created %s, %d records\n", LOG_FILE, LOG_CAPACITY);
+    return (boolean)file;
+}
+
+boolean PCLog::flush(fs::FS &fs)
+{
+    if (numberOfBuffered == 0 && droppedRecords == 0)
+        return true;
+    if (droppedRecords > 0)
+    {
+        // Overwrite the last slot, so the loss itself is never lost
+        uint32_t dropped = droppedRecords + (numberOfBuffered >= LOG_BUFFER_RECORDS ? 1 : 0);
+        numberOfBuffered = min(numberOfBuffered, LOG_BUFFER_RECORDS - 1);
+        droppedRecords = 0;
+        append(LOG_ERROR, LOG_DROPPED, dropped, 0, 0, 0);
+    }
+
+    File file;
+    PCLogHeader header;
+    if (!openRing(fs, file, header))
+    {
+        log_printf("Log: cannot open %s\n", LOG_FILE);
+        return false;
+    }
+
+    // Each flush starts on a sector boundary, the tail of its last sector stays empty
+    uint32_t index = (header.nextIndex + RECORDS_PER_SECTOR - 1) / RECORDS_PER_SECTOR * RECORDS_PER_SECTOR;
+    PCLogRecord sector[RECORDS_PER_SECTOR];
+    boolean written = true;
+    for (int first = 0; first < numberOfBuffered && written; first += RECORDS_PER_SECTOR)
+    {
+        if (index >= LOG_CAPACITY)
+            index = 0;
+        memset(sector, 0, sizeof(sector));
+        int count = min((int)RECORDS_PER_SECTOR, numberOfBuffered - first);
+        for (int i = 0; i < count; i++)
+        {
+            sector[i] = bufferedRecords[first + i];
+            sector[i].sequence = header.nextSequence++;
+        }
+        written = file.seek(LOG_SECTOR_SIZE + index * sizeof(PCLogRecord)) &&
+                  file.write((const uint8_t *)sector, sizeof(sector)) == sizeof(sector);
+        index += RECORDS_PER_SECTOR;
+    }
+    header.nextIndex = index >= LOG_CAPACITY ? 0 : index;
+    written = written && file.seek(0) && file.write((const uint8_t *)&header, sizeof(header)) == sizeof(header);
+    file.close();
+    if (written)
+    {
+        numberOfBuffered = 0;
+    }
+    else
+    {
+        log_printf("Log: write failed\n");
+    }
+    return written;
+}
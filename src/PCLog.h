@@ -0,0 +1,86 @@
+#ifndef PCLOG_H_INCLUDE
+#define PCLOG_H_INCLUDE
+
+#include <Arduino.h>
+#include <FS.h>
+
+#define LOG_FILE "/log.bin"
+#define LOG_MAGIC 0x474C4350 // "PCLG"
+#define LOG_VERSION 1
+#define LOG_SECTOR_SIZE 512
+#define LOG_CAPACITY 2048      // records in the ring, 64 KB
+#define LOG_BUFFER_RECORDS 48  // records kept in RTC memory between flushes
+#define LOG_FLUSH_THRESHOLD 32 // flush even without SD card work once this many are waiting
+
+#define LOG_OFF 0
+#define LOG_ERROR 1
+#define LOG_INFO 2
+#define LOG_VERBOSE 3
+
+// Record codes. tools/pclog.py has the matching format strings.
+enum PCLogCode
+{
+    LOG_BOOT = 1,         // wakeup cause, wakes so far
+    LOG_WIFI = 2,         // connect ms, fast path, connected
+    LOG_FEED = 3,         // feed index, loaded, ms
+    LOG_BUILD = 4,        // events in month, duplicates, changed feeds, events over the per-day limit
+    LOG_SKIP = 5,         // skipped wakes, wakes
+    LOG_DISPLAY = 6,      // BUSY waits, ms on BUSY
+    LOG_FRAME = 7,        // date, offline wakes
+    LOG_ARENA = 8,        // peak, capacity, allocations, overflow bytes
+    LOG_SLEEP = 9,        // sleep seconds, ms awake
+    LOG_NO_SETTINGS = 10, //
+    LOG_EPD_FAILED = 11,  // init result
+    LOG_MEMORY = 12,      // phase, free heap, largest block, block needed
+    LOG_CLOCK = 13,       // step ms, drift ppm, wake error ms, from SNTP
+    LOG_BUDGET = 14,      // phase, feed index, ms, bytes read
+    LOG_DROPPED = 15,     // records lost while the buffer was full
+    LOG_GRAPH = 16        // ms of the task graph, ms of its tasks, ms on the critical path, critical tasks
+};
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t capacity;
+    uint32_t nextIndex;
+    uint32_t nextSequence;
+    uint32_t reserved[3];
+} PCLogHeader;
+
+typedef struct
+{
+    uint32_t sequence; // 0 marks an unused slot
+    uint32_t time;
+    uint32_t millis;
+    uint8_t level;
+    uint8_t code;
+    uint16_t wake;
+    int32_t values[4];
+} PCLogRecord;
+
+// Binary log ring on SD card.
+// Records are fixed 32 byte structs kept in RTC memory, so a wake only pays
+// for a memcpy. They are written in whole sectors into a preallocated file,
+// so the FAT is never touched after the file is created.
+// The first sector holds the header, the next write position wraps around.
+class PCLog
+{
+public:
+    static void begin();
+    static void setLevel(uint8_t level);
+    static uint8_t levelFromString(String levelString);
+    static void record(uint8_t level, uint8_t code, int32_t value0 = 0, int32_t value1 = 0, int32_t value2 = 0, int32_t value3 = 0);
+    static boolean needsFlush();
+    static boolean flush(fs::FS &fs);
+    static int numberOfBufferedRecords();
+
+private:
+    static void append(uint8_t level, uint8_t code, int32_t value0, int32_t value1, int32_t value2, int32_t value3);
+    static boolean openRing(fs::FS &fs, File &file, PCLogHeader &header);
+
+    static uint8_t _level;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#include "PCMemoryPhase.h"
+#include "PCLog.h"
+
+// Free heap and largest block needed when a phase starts.
+// Network: mbedTLS keeps 16 KB in and 4 KB out record buffers per connection
+// plus the certificate chain, the WiFi stack grows its own pools while
+// associating. Render is set from the panel size by the caller.
+PCMemoryBudget PCMemoryPhase::_budgets[NUMBER_OF_PHASES] = {
+    {"boot", 0, 0, false},
+    {"network", 56000, 24000, false},
+    {"parse", 16000, 8000, false},
+    {"render", 0, 0, false},
+    {"display", 8000, 4096, false},
+};
+PCPhase PCMemoryPhase::_current = PHASE_BOOT;
+int PCMemoryPhase::_numberOfOverruns = 0;
+
+boolean PCMemoryPhase::enter(PCPhase phase)
+{
+    _current = phase;
+    const PCMemoryBudget &budget = _budgets[phase];
+    uint32_t caps = budget.inPSRAM ? MALLOC_CAP_SPIRAM : (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    size_t freeHeap = heap_caps_get_free_size(caps);
+    size_t largestBlock = heap_caps_get_largest_free_block(caps);
+    if (freeHeap >= budget.minimumFreeHeap && largestBlock >= budget.minimumLargestBlock)
+    {
+        log_printf("Memory: %s, %u free, %u block\n", budget.name, (unsigned int)freeHeap, (unsigned int)largestBlock);
+        return true;
+    }
+    _numberOfOverruns++;
+    log_printf("Memory: %s needs %u free and a %u byte block in %s, has %u free and a %u byte block\n",
+               budget.name, (unsigned int)budget.minimumFreeHeap, (unsigned int)budget.minimumLargestBlock,
+               budget.inPSRAM ? "PSRAM" : "internal RAM", (unsigned int)freeHeap, (unsigned int)largestBlock);
+    PCLog::record(LOG_ERROR, LOG_MEMORY, phase, freeHeap, largestBlock, budget.minimumLargestBlock);
+    return false;
+}
+
+void PCMemoryPhase::setBudget(PCPhase phase, size_t minimumFreeHeap, size_t minimumLargestBlock, boolean inPSRAM)
+{
+    _budgets[phase].minimumFreeHeap = minimumFreeHeap;
+    _budgets[phase].minimumLargestBlock = minimumLargestBlock;
+    _budgets[phase].inPSRAM = inPSRAM;
+}
+
+PCPhase PCMemoryPhase::current()
+{
+    return _current;
+}
+
+const char *PCMemoryPhase::name(PCPhase phase)
+{
+    return _budgets[phase].name;
+}
+
+int PCMemoryPhase::numberOfOverruns()
+{
+    return _numberOfOverruns;
+}
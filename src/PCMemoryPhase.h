@@ -0,0 +1,43 @@
+#ifndef PCMEMORYPHASE_H_INCLUDE
+#define PCMEMORYPHASE_H_INCLUDE
+
+#include <Arduino.h>
+
+enum PCPhase
+{
+    PHASE_BOOT = 0,
+    PHASE_NETWORK,
+    PHASE_PARSE,
+    PHASE_RENDER,
+    PHASE_DISPLAY,
+    NUMBER_OF_PHASES
+};
+
+typedef struct
+{
+    const char *name;
+    size_t minimumFreeHeap;
+    size_t minimumLargestBlock;
+    boolean inPSRAM; // checked against PSRAM instead of internal RAM
+} PCMemoryBudget;
+
+// Wake split into phases that never hold their large buffers at the same time.
+// TLS and HTTP buffers exist only in the network phase, framebuffers only from
+// the render phase on. Entering a phase checks its budget and reports the
+// shortfall, so a failed allocation later is not a mystery.
+class PCMemoryPhase
+{
+public:
+    static boolean enter(PCPhase phase);
+    static void setBudget(PCPhase phase, size_t minimumFreeHeap, size_t minimumLargestBlock, boolean inPSRAM);
+    static PCPhase current();
+    static const char *name(PCPhase phase);
+    static int numberOfOverruns();
+
+private:
+    static PCMemoryBudget _budgets[NUMBER_OF_PHASES];
+    static PCPhase _current;
+    static int _numberOfOverruns;
+};
+
+#endif
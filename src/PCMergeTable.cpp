@@ -0,0 +1,45 @@
+#include "PCMergeTable.h"
+
+PCMergeTable::PCMergeTable(int expectedCount)
+{
+    size_t capacity = 16;
+    while (capacity < (size_t)expectedCount * 2)
+    {
+        capacity *= 2;
+    }
+    _keys.assign(capacity, 0);
+    _values.assign(capacity, -1);
+    _mask = capacity - 1;
+}
+
+// Returns the value already stored for key, or -1 after storing value
+int PCMergeTable::findOrInsert(uint64_t key, int value)
+{
+    size_t slot = slotOf(key);
+    if (_keys[slot] == key)
+    {
+        return _values[slot];
+    }
+    _keys[slot] = key;
+    _values[slot] = value;
+    return -1;
+}
+
+void PCMergeTable::replace(uint64_t key, int value)
+{
+    size_t slot = slotOf(key);
+    _keys[slot] = key;
+    _values[slot] = value;
+}
+
+size_t PCMergeTable::slotOf(uint64_t key)
+{
+    // Mix the bits, since keys are built from FNV hashes and times
+    uint64_t mixed = key * 0x9E3779B97F4A7C15ULL;
+    size_t slot = (size_t)(mixed >> 32) & _mask;
+    while (_keys[slot] != 0 && _keys[slot] != key)
+    {
+        slot = (slot + 1) & _mask;
+    }
+    return slot;
+}
@@ -0,0 +1,27 @@
+#ifndef PCMERGETABLE_H_INCLUDE
+#define PCMERGETABLE_H_INCLUDE
+
+#include <Arduino.h>
+#include <vector>
+
+#include "PCArena.h"
+
+// Open-addressing hash table from a 64-bit key to an event number.
+// Linear probing over a power-of-two array kept under half full, so
+// each lookup is O(1) on average. Key 0 marks an empty slot.
+class PCMergeTable
+{
+public:
+    PCMergeTable(int expectedCount);
+    int findOrInsert(uint64_t key, int value);
+    void replace(uint64_t key, int value);
+
+private:
+    size_t slotOf(uint64_t key);
+
+    std::vector<uint64_t, PCArenaAllocator<uint64_t>> _keys;
+    std::vector<int, PCArenaAllocator<int>> _values;
+    size_t _mask;
+};
+
+#endif
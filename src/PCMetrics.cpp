@@ -0,0 +1,74 @@
+#include "PCMetrics.h"
+
+// Tasks whose stack is measured. NULL is the calling (loop) task.
+static const char *taskNames[MAX_METRICS_TASKS] = {NULL, "wifi", "tiT", "sys_evt"};
+
+PCMetricsRecord PCMetrics::_records[MAX_METRICS_PHASES];
+int PCMetrics::_numberOfRecords = 0;
+
+void PCMetrics::mark(const char *phase)
+{
+    if (_numberOfRecords >= MAX_METRICS_PHASES)
+        return;
+    PCMetricsRecord &record = _records[_numberOfRecords++];
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_INTERNAL);
+    record.phase = phase;
+    record.millis = millis();
+    record.freeHeap = info.total_free_bytes;
+    record.largestFreeBlock = info.largest_free_block;
+    record.minimumFreeHeap = info.minimum_free_bytes;
+    record.allocatedBlocks = info.allocated_blocks;
+    record.freePSRAM = psramFound() ? heap_caps_get_free_size(MALLOC_CAP_SPIRAM) : 0;
+    for (int i = 0; i < MAX_METRICS_TASKS; i++)
+    {
+        TaskHandle_t task = (taskNames[i] == NULL) ? NULL : xTaskGetHandle(taskNames[i]);
+        record.taskStackFree[i] = (taskNames[i] == NULL || task != NULL) ? uxTaskGetStackHighWaterMark(task) : 0;
+    }
+}
+
+void PCMetrics::report()
+{
+    log_printf("%-10s %7s %7s %7s %7s %6s %7s  stack free: %s/%s/%s/%s\n", "phase", "ms", "free", "block", "min", "blocks", "psram",
+               pcTaskGetName(NULL), taskNames[1], taskNames[2], taskNames[3]);
+    for (int i = 0; i < _numberOfRecords; i++)
+    {
+        PCMetricsRecord &record = _records[i];
+        log_printf("%-10s %7lu %7u %7u %7u %6u %7u  %u/%u/%u/%u\n", record.phase, record.millis,
+                   (unsigned int)record.freeHeap, (unsigned int)record.largestFreeBlock, (unsigned int)record.minimumFreeHeap,
+                   (unsigned int)record.allocatedBlocks, (unsigned int)record.freePSRAM,
+                   record.taskStackFree[0], record.taskStackFree[1], record.taskStackFree[2], record.taskStackFree[3]);
+    }
+}
+
+String PCMetrics::summary()
+{
+    // Lowest free heap and smallest largest-block seen, with their phases
+    if (_numberOfRecords == 0)
+        return "";
+    int minimumIndex = 0;
+    int blockIndex = 0;
+    uint32_t stackFree = _records[0].taskStackFree[0];
+    for (int i = 1; i < _numberOfRecords; i++)
+    {
+        if (_records[i].minimumFreeHeap < _records[minimumIndex].minimumFreeHeap)
+            minimumIndex = i;
+        if (_records[i].largestFreeBlock < _records[blockIndex].largestFreeBlock)
+            blockIndex = i;
+        stackFree = min(stackFree, _records[i].taskStackFree[0]);
+    }
+    char buf[64];
+    sprintf(buf, "Heap min:%uK@%s blk:%uK@%s stk:%u", (unsigned int)(_records[minimumIndex].minimumFreeHeap / 1024), _records[minimumIndex].phase,
+            (unsigned int)(_records[blockIndex].largestFreeBlock / 1024), _records[blockIndex].phase, stackFree);
+    return String(buf);
+}
+
+int PCMetrics::numberOfRecords()
+{
+    return _numberOfRecords;
+}
+
+const PCMetricsRecord &PCMetrics::record(int index)
+{
+    return _records[index];
+}
@@ -0,0 +1,39 @@
+#ifndef PCMETRICS_H_INCLUDE
+#define PCMETRICS_H_INCLUDE
+
+#include <Arduino.h>
+
+#define MAX_METRICS_PHASES 16
+#define MAX_METRICS_TASKS 4
+
+typedef struct
+{
+    const char *phase;
+    unsigned long millis;
+    size_t freeHeap;
+    size_t largestFreeBlock;
+    size_t minimumFreeHeap;
+    size_t allocatedBlocks;
+    size_t freePSRAM;
+    uint32_t taskStackFree[MAX_METRICS_TASKS];
+} PCMetricsRecord;
+
+// Memory and stack usage recorded at phase boundaries.
+// Each mark takes internal heap, largest free block, the low-water mark
+// since boot, allocated block count, free PSRAM and the unused stack of
+// the loop task and the WiFi and network tasks.
+class PCMetrics
+{
+public:
+    static void mark(const char *phase);
+    static void report();
+    static String summary();
+    static int numberOfRecords();
+    static const PCMetricsRecord &record(int index);
+
+private:
+    static PCMetricsRecord _records[MAX_METRICS_PHASES];
+    static int _numberOfRecords;
+};
+
+#endif
@@ -0,0 +1,376 @@
+#include <algorithm>
+
+#include "PCRecurrence.h"
+#include "PCEvent.h"
+
+#define SECONDS_IN_DAY 86400
+
+static const char *weekdayCodes[] = {"SU", "MO", "TU", "WE", "TH", "FR", "SA"};
+
+static int weekdayFromCode(String code)
+{
+    for (int i = 0; i < 7; i++)
+    {
+        if (code == weekdayCodes[i])
+            return i;
+    }
+    return -1;
+}
+
+static int weekdayOfTime(time_t time)
+{
+    // 1970-01-01 was a Thursday
+    long days = (time >= 0) ? time / SECONDS_IN_DAY : (time - SECONDS_IN_DAY + 1) / SECONDS_IN_DAY;
+    return (int)(((days + 4) % 7 + 7) % 7);
+}
+
+static time_t dayOfTime(time_t time)
+{
+    return (time >= 0) ? time - time % SECONDS_IN_DAY : time - ((time % SECONDS_IN_DAY) + SECONDS_IN_DAY) % SECONDS_IN_DAY;
+}
+
+PCRecurrence::PCRecurrence()
+{
+    _frequency = RECURRENCE_NONE;
+    _interval = 1;
+    _count = 0;
+    _until = 0;
+    _byDayMask = 0;
+    _byMonthMask = 0;
+}
+
+boolean PCRecurrence::parse(String rule, float toTimezone)
+{
+    // FREQ=WEEKLY;INTERVAL=2;BYDAY=MO,WE;UNTIL=20241231T150000Z
+    int position = 0;
+    while (position < (int)rule.length())
+    {
+        int end = rule.indexOf(';', position);
+        if (end < 0)
+            end = rule.length();
+        String part = rule.substring(position, end);
+        position = end + 1;
+        int equal = part.indexOf('=');
+        if (equal < 0)
+            continue;
+        String key = part.substring(0, equal);
+        String value = part.substring(equal + 1);
+        value.trim();
+
+        if (key == "FREQ")
+        {
+            if (value == "DAILY")
+                _frequency = RECURRENCE_DAILY;
+            else if (value == "WEEKLY")
+                _frequency = RECURRENCE_WEEKLY;
+            else if (value == "MONTHLY")
+                _frequency = RECURRENCE_MONTHLY;
+            else if (value == "YEARLY")
+                _frequency = RECURRENCE_YEARLY;
+        }
+        else if (key == "INTERVAL")
+        {
+            _interval = max(1, (int)value.toInt());
+        }
+        else if (key == "COUNT")
+        {
+            _count = value.toInt();
+        }
+        else if (key == "UNTIL")
+        {
+            _until = timeFromTM(tmFromICalDateString(value, value.endsWith("Z") ? toTimezone : 0.0f));
+            if (value.length() == 8)
+            { // a date includes the whole day
+                _until += SECONDS_IN_DAY - 1;
+            }
+        }
+        else if (key == "BYDAY")
+        {
+            int itemStart = 0;
+            while (itemStart < (int)value.length())
+            {
+                int itemEnd = value.indexOf(',', itemStart);
+                if (itemEnd < 0)
+                    itemEnd = value.length();
+                String item = value.substring(itemStart, itemEnd);
+                itemStart = itemEnd + 1;
+                if (item.length() < 2)
+                    continue;
+                int weekday = weekdayFromCode(item.substring(item.length() - 2));
+                if (weekday < 0)
+                    continue;
+                int ordinal = item.substring(0, item.length() - 2).toInt();
+                if (ordinal == 0)
+                {
+                    _byDayMask |= 1 << weekday;
+                }
+                else
+                { // ordinal and weekday packed together: 2MO -> 21, -1FR -> -15
+                    _byDayOrdinals.push_back(ordinal > 0 ? ordinal * 10 + weekday : ordinal * 10 - weekday);
+                }
+            }
+        }
+        else if (key == "BYMONTHDAY")
+        {
+            int itemStart = 0;
+            while (itemStart < (int)value.length())
+            {
+                int itemEnd = value.indexOf(',', itemStart);
+                if (itemEnd < 0)
+                    itemEnd = value.length();
+                int monthDay = value.substring(itemStart, itemEnd).toInt();
+                itemStart = itemEnd + 1;
+                if (monthDay != 0)
+                    _byMonthDays.push_back(monthDay);
+            }
+        }
+        else if (key == "BYMONTH")
+        {
+            int itemStart = 0;
+            while (itemStart < (int)value.length())
+            {
+                int itemEnd = value.indexOf(',', itemStart);
+                if (itemEnd < 0)
+                    itemEnd = value.length();
+                int month = value.substring(itemStart, itemEnd).toInt();
+                itemStart = itemEnd + 1;
+                if (month >= 1 && month <= 12)
+                    _byMonthMask |= 1 << month;
+            }
+        }
+    }
+    return _frequency != RECURRENCE_NONE;
+}
+
+void PCRecurrence::addExceptionDates(String property, float toTimezone)
+{
+    // EXDATE;TZID=Asia/Tokyo:20240108T090000,20240115T090000
+    int colon = property.indexOf(':');
+    if (colon < 0)
+        return;
+    String parameters = property.substring(0, colon + 1);
+    int itemStart = colon + 1;
+    while (itemStart < (int)property.length())
+    {
+        int itemEnd = property.indexOf(',', itemStart);
+        if (itemEnd < 0)
+            itemEnd = property.length();
+        String value = property.substring(itemStart, itemEnd);
+        itemStart = itemEnd + 1;
+        value.trim();
+        if (value.length() < 8)
+            continue;
+        time_t time = timeFromTM(tmFromICalProperty(parameters + value, toTimezone));
+        if (value.length() == 8)
+        {
+            _exceptionDays.push_back(time);
+        }
+        else
+        {
+            _exceptionTimes.push_back(time);
+        }
+    }
+}
+
+boolean PCRecurrence::isRecurring()
+{
+    return _frequency != RECURRENCE_NONE;
+}
+
+time_t PCRecurrence::getUntil()
+{
+    return _until;
+}
+
+// Appends the start of every occurrence overlapping [windowStart, windowEnd)
+void PCRecurrence::occurrences(time_t start, time_t duration, time_t windowStart, time_t windowEnd, std::vector<time_t> &result)
+{
+    if (_frequency == RECURRENCE_NONE)
+    {
+        result.push_back(start);
+        return;
+    }
+    int number = 0;
+    time_t timeOfDay = start - dayOfTime(start);
+
+    if (_frequency == RECURRENCE_DAILY && _byDayMask == 0)
+    {
+        time_t step = (time_t)_interval * SECONDS_IN_DAY;
+        long first = 0;
+        if (_count == 0 && windowStart - duration > start)
+        { // jump close to the window, there is no count to keep
+            first = (windowStart - duration - start) / step;
+        }
+        for (long k = first; k < first + MAX_RECURRENCE_ITERATIONS; k++)
+        {
+            if (!accept(start + k * step, duration, windowStart, windowEnd, number, result))
+                break;
+        }
+    }
+    else if (_frequency == RECURRENCE_WEEKLY || _frequency == RECURRENCE_DAILY)
+    {
+        // Weeks begin on Monday (WKST=MO)
+        uint8_t mask = _byDayMask ? _byDayMask : 1 << weekdayOfTime(start);
+        int step = (_frequency == RECURRENCE_DAILY) ? _interval : 7 * _interval;
+        time_t weekStart = dayOfTime(start) - ((weekdayOfTime(start) + 6) % 7) * SECONDS_IN_DAY;
+        if (_frequency == RECURRENCE_DAILY)
+        {
+            weekStart = dayOfTime(start);
+        }
+        long first = 0;
+        if (_count == 0 && windowStart - duration - 7 * SECONDS_IN_DAY > weekStart)
+        {
+            first = (windowStart - duration - 7 * SECONDS_IN_DAY - weekStart) / ((time_t)step * SECONDS_IN_DAY);
+        }
+        int daysInPeriod = (_frequency == RECURRENCE_DAILY) ? 1 : 7;
+        boolean running = true;
+        for (long k = first; running && k < first + MAX_RECURRENCE_ITERATIONS; k++)
+        {
+            time_t periodStart = weekStart + k * step * SECONDS_IN_DAY;
+            for (int d = 0; running && d < daysInPeriod; d++)
+            {
+                time_t candidate = periodStart + d * SECONDS_IN_DAY + timeOfDay;
+                if (!(mask & (1 << weekdayOfTime(candidate))) || candidate < start)
+                    continue;
+                running = accept(candidate, duration, windowStart, windowEnd, number, result);
+            }
+        }
+    }
+    else
+    {
+        tm startTM;
+        time_t startTime = start;
+        gmtime_r(&startTime, &startTM);
+        int year = startTM.tm_year + 1900;
+        int month = startTM.tm_mon + 1;
+        std::vector<time_t> candidates;
+        boolean running = true;
+        for (int k = 0; running && k < MAX_RECURRENCE_ITERATIONS; k++)
+        {
+            candidates.clear();
+            if (_frequency == RECURRENCE_MONTHLY)
+            {
+                int monthIndex = (month - 1) + k * _interval;
+                candidatesInMonth(year + monthIndex / 12, monthIndex % 12 + 1, start, candidates);
+            }
+            else
+            {
+                for (int m = 1; m <= 12; m++)
+                {
+                    if (_byMonthMask ? (_byMonthMask & (1 << m)) : (m == month))
+                    {
+                        candidatesInMonth(year + k * _interval, m, start, candidates);
+                    }
+                }
+            }
+            // A day picked twice, as by BYDAY=MO,1MO, is one occurrence
+            std::sort(candidates.begin(), candidates.end());
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+            for (time_t candidate : candidates)
+            {
+                if (candidate < start)
+                    continue;
+                running = accept(candidate, duration, windowStart, windowEnd, number, result);
+                if (!running)
+                    break;
+            }
+        }
+    }
+}
+
+void PCRecurrence::candidatesInMonth(int year, int month, time_t start, std::vector<time_t> &candidates)
+{
+    time_t monthStart = timeFromDate(year, month, 1);
+    time_t timeOfDay = start - dayOfTime(start);
+    int numberOfDays = numberOfDaysInMonth(year, month);
+    boolean hasByDay = !_byDayOrdinals.empty() || _byDayMask != 0;
+    std::vector<int> days;
+    if (hasByDay)
+    {
+        int firstWeekday = weekdayOfTime(monthStart);
+        for (int packed : _byDayOrdinals)
+        {
+            int ordinal = packed / 10;
+            int weekday = abs(packed % 10);
+            if (ordinal > 0)
+            {
+                days.push_back(1 + (weekday - firstWeekday + 7) % 7 + (ordinal - 1) * 7);
+            }
+            else
+            {
+                int lastWeekday = (firstWeekday + numberOfDays - 1) % 7;
+                days.push_back(numberOfDays - (lastWeekday - weekday + 7) % 7 + (ordinal + 1) * 7);
+            }
+        }
+        for (int day = 1; _byDayMask != 0 && day <= numberOfDays; day++)
+        {
+            if (_byDayMask & (1 << ((firstWeekday + day - 1) % 7)))
+                days.push_back(day);
+        }
+    }
+    if (!_byMonthDays.empty())
+    {
+        // With BYDAY too, only days picked by both are kept: BYDAY=FR;BYMONTHDAY=13
+        std::vector<int> monthDays;
+        for (int monthDay : _byMonthDays)
+        {
+            monthDays.push_back((monthDay > 0) ? monthDay : numberOfDays + monthDay + 1);
+        }
+        if (hasByDay)
+        {
+            days.erase(std::remove_if(days.begin(), days.end(), [&](int day)
+                                      { return std::find(monthDays.begin(), monthDays.end(), day) == monthDays.end(); }),
+                       days.end());
+        }
+        else
+        {
+            days = monthDays;
+        }
+    }
+    if (!hasByDay && _byMonthDays.empty())
+    {
+        // Same day of month as DTSTART, months without that day are skipped
+        tm startTM;
+        time_t startTime = start;
+        gmtime_r(&startTime, &startTM);
+        days.push_back(startTM.tm_mday);
+    }
+    for (int day : days)
+    {
+        if (day >= 1 && day <= numberOfDays)
+            candidates.push_back(monthStart + (day - 1) * SECONDS_IN_DAY + timeOfDay);
+    }
+}
+
+// Returns false when no later occurrence can be accepted
+boolean PCRecurrence::accept(time_t candidate, time_t duration, time_t windowStart, time_t windowEnd, int &number, std::vector<time_t> &result)
+{
+    number++;
+    if (_count > 0 && number > _count)
+        return false;
+    if (_until != 0 && candidate > _until)
+        return false;
+    if (candidate >= windowEnd)
+        return false;
+    if (candidate + duration > windowStart && !isExcluded(candidate))
+    {
+        result.push_back(candidate);
+    }
+    return true;
+}
+
+boolean PCRecurrence::isExcluded(time_t occurrence)
+{
+    for (time_t time : _exceptionTimes)
+    {
+        if (time == occurrence)
+            return true;
+    }
+    time_t day = dayOfTime(occurrence);
+    for (time_t exceptionDay : _exceptionDays)
+    {
+        if (exceptionDay == day)
+            return true;
+    }
+    return false;
+}
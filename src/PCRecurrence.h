@@ -0,0 +1,53 @@
+#ifndef PCRECURRENCE_H_INCLUDE
+#define PCRECURRENCE_H_INCLUDE
+
+#include <Arduino.h>
+#include <vector>
+#include <time.h>
+
+#define MAX_RECURRENCE_ITERATIONS 5000
+
+typedef enum
+{
+    RECURRENCE_NONE,
+    RECURRENCE_DAILY,
+    RECURRENCE_WEEKLY,
+    RECURRENCE_MONTHLY,
+    RECURRENCE_YEARLY
+} PCRecurrenceFrequency;
+
+// RRULE and EXDATE of a recurring event (RFC 5545 3.3.10).
+// Supported: FREQ=DAILY/WEEKLY/MONTHLY/YEARLY with INTERVAL, COUNT, UNTIL,
+// BYDAY (weekdays, and ordinal weekdays such as 2MO or -1FR for monthly
+// rules), BYMONTHDAY and BYMONTH. BYDAY with BYMONTHDAY keeps the days both
+// pick. Other parts are ignored. The PCAL compiler in tools/pcal expands
+// rules with this class too.
+// Times are local seconds as returned by timeFromTM().
+class PCRecurrence
+{
+public:
+    PCRecurrence();
+    boolean parse(String rule, float toTimezone);
+    void addExceptionDates(String property, float toTimezone);
+    boolean isRecurring();
+    time_t getUntil();
+    void occurrences(time_t start, time_t duration, time_t windowStart, time_t windowEnd, std::vector<time_t> &result);
+
+private:
+    boolean isExcluded(time_t occurrence);
+    boolean accept(time_t candidate, time_t duration, time_t windowStart, time_t windowEnd, int &number, std::vector<time_t> &result);
+    void candidatesInMonth(int year, int month, time_t start, std::vector<time_t> &candidates);
+
+    PCRecurrenceFrequency _frequency;
+    int _interval;
+    int _count;
+    time_t _until;
+    uint8_t _byDayMask;
+    std::vector<int> _byDayOrdinals;
+    std::vector<int> _byMonthDays;
+    uint16_t _byMonthMask;
+    std::vector<time_t> _exceptionTimes;
+    std::vector<time_t> _exceptionDays;
+};
+
+#endif
@@ -0,0 +1,157 @@
+#include "PCScheduler.h"
+
+#define MIDNIGHT_MARGIN_SECONDS 300
+#define MINIMUM_SLEEP_SECONDS 60
+#define MAX_BACKOFF_SHIFT 8
+#define MAX_BOUNDARIES 16
+
+// Number of consecutive wakes without feed changes
+RTC_DATA_ATTR static uint32_t unchangedWakes = 0;
+
+// Event boundaries of the displayed day, kept for wakes that skip parsing
+RTC_DATA_ATTR static int boundaries[MAX_BOUNDARIES];
+RTC_DATA_ATTR static int numberOfBoundaries = 0;
+
+PCWakePolicy PCScheduler::_policy = WAKE_POLICY_DAILY;
+uint32_t PCScheduler::_intervalMinutes = 60;
+uint32_t PCScheduler::_maxBackoffMinutes = 720;
+uint32_t PCScheduler::_batteryFloor = 0;
+String PCScheduler::_reason = "";
+
+PCWakePolicy PCScheduler::policyFromString(String policyString)
+{
+    if (policyString == "interval")
+        return WAKE_POLICY_INTERVAL;
+    if (policyString == "events")
+        return WAKE_POLICY_EVENTS;
+    if (policyString == "adaptive")
+        return WAKE_POLICY_ADAPTIVE;
+    return WAKE_POLICY_DAILY;
+}
+
+void PCScheduler::configure(PCWakePolicy policy, uint32_t intervalMinutes, uint32_t maxBackoffMinutes, uint32_t batteryFloor)
+{
+    _policy = policy;
+    _intervalMinutes = max(intervalMinutes, (uint32_t)1);
+    _maxBackoffMinutes = max(maxBackoffMinutes, _intervalMinutes);
+    _batteryFloor = batteryFloor;
+}
+
+void PCScheduler::clearBoundaries()
+{
+    numberOfBoundaries = 0;
+}
+
+void PCScheduler::addBoundary(int secondsInDay)
+{
+    if (numberOfBoundaries < MAX_BOUNDARIES)
+    {
+        boundaries[numberOfBoundaries++] = secondsInDay;
+    }
+}
+
+int PCScheduler::nextWakeSeconds(tm now, boolean feedsChanged, uint32_t batteryVoltage)
+{
+    unchangedWakes = feedsChanged ? 0 : unchangedWakes + 1;
+    char reasonBuffer[48];
+    int seconds = wakeSeconds(now, unchangedWakes, batteryVoltage, reasonBuffer);
+    _reason = reasonBuffer;
+    log_printf("Next wake in %d s: %s\n", seconds, reasonBuffer);
+    return seconds;
+}
+
+// The wake to use when this one fails before the next wake is chosen.
+// It is counted as one more unchanged wake, but nothing is recorded, so a
+// wake that succeeds afterwards backs off only once.
+int PCScheduler::fallbackWakeSeconds(tm now, uint32_t batteryVoltage)
+{
+    char reasonBuffer[48];
+    int seconds = wakeSeconds(now, unchangedWakes + 1, batteryVoltage, reasonBuffer);
+    log_printf("Fallback wake in %d s: %s\n", seconds, reasonBuffer);
+    return seconds;
+}
+
+int PCScheduler::wakeSeconds(tm now, uint32_t unchanged, uint32_t batteryVoltage, char *reasonBuffer)
+{
+    int secondsInDay = now.tm_hour * 3600 + now.tm_min * 60 + now.tm_sec;
+    int untilMidnight = 24 * 3600 - secondsInDay + MIDNIGHT_MARGIN_SECONDS;
+    int seconds = untilMidnight;
+    boolean lowBattery = (_batteryFloor > 0 && batteryVoltage > 0 && batteryVoltage < _batteryFloor);
+    if (lowBattery)
+    {
+        sprintf(reasonBuffer, "battery %umV", batteryVoltage);
+    }
+    else
+    {
+        switch (_policy)
+        {
+        case WAKE_POLICY_INTERVAL:
+        {
+            seconds = _intervalMinutes * 60;
+            sprintf(reasonBuffer, "interval %um", _intervalMinutes);
+            break;
+        }
+        case WAKE_POLICY_EVENTS:
+        {
+            int boundary = nextBoundary(secondsInDay);
+            if (boundary > 0)
+            {
+                seconds = boundary - secondsInDay;
+                sprintf(reasonBuffer, "event %02d:%02d", boundary / 3600, (boundary % 3600) / 60);
+            }
+            else
+            {
+                strcpy(reasonBuffer, "no events");
+            }
+            break;
+        }
+        case WAKE_POLICY_ADAPTIVE:
+        {
+            uint32_t shift = min(unchanged, (uint32_t)MAX_BACKOFF_SHIFT);
+            uint32_t minutes = min(_intervalMinutes << shift, _maxBackoffMinutes);
+            seconds = minutes * 60;
+            sprintf(reasonBuffer, "backoff %um (%u unchanged)", minutes, unchanged);
+            int boundary = nextBoundary(secondsInDay);
+            if (boundary > 0 && boundary - secondsInDay < seconds)
+            {
+                seconds = boundary - secondsInDay;
+                sprintf(reasonBuffer, "event %02d:%02d", boundary / 3600, (boundary % 3600) / 60);
+            }
+            break;
+        }
+        default:
+        {
+            strcpy(reasonBuffer, "daily");
+        }
+        }
+    }
+
+    if (seconds >= untilMidnight)
+    {
+        seconds = untilMidnight;
+        if (_policy != WAKE_POLICY_DAILY && !lowBattery)
+        {
+            strcpy(reasonBuffer, "midnight");
+        }
+    }
+    return max(seconds, MINIMUM_SLEEP_SECONDS);
+}
+
+String PCScheduler::reason()
+{
+    return _reason;
+}
+
+int PCScheduler::nextBoundary(int secondsInDay)
+{
+    int next = -1;
+    for (int i = 0; i < numberOfBoundaries; i++)
+    {
+        int boundary = boundaries[i];
+        if (boundary >= secondsInDay + MINIMUM_SLEEP_SECONDS && (next < 0 || boundary < next))
+        {
+            next = boundary;
+        }
+    }
+    return next;
+}
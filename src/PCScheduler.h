@@ -0,0 +1,45 @@
+#ifndef PCSCHEDULER_H_INCLUDE
+#define PCSCHEDULER_H_INCLUDE
+
+#include <Arduino.h>
+#include <time.h>
+
+typedef enum
+{
+    WAKE_POLICY_DAILY,
+    WAKE_POLICY_INTERVAL,
+    WAKE_POLICY_EVENTS,
+    WAKE_POLICY_ADAPTIVE
+} PCWakePolicy;
+
+// Chooses the next wake time.
+// Every policy still wakes shortly after midnight to show the new day.
+//  daily:    only after midnight
+//  interval: every wakeInterval minutes
+//  events:   at the next start or end of a timed event today
+//  adaptive: interval, doubled for each wake without feed changes up to
+//            maxBackoff minutes, and never later than the next event boundary
+// Below batteryFloor, only the midnight wake is kept.
+class PCScheduler
+{
+public:
+    static PCWakePolicy policyFromString(String policyString);
+    static void configure(PCWakePolicy policy, uint32_t intervalMinutes, uint32_t maxBackoffMinutes, uint32_t batteryFloor);
+    static void clearBoundaries();
+    static void addBoundary(int secondsInDay);
+    static int nextWakeSeconds(tm now, boolean feedsChanged, uint32_t batteryVoltage);
+    static int fallbackWakeSeconds(tm now, uint32_t batteryVoltage);
+    static String reason();
+
+private:
+    static int wakeSeconds(tm now, uint32_t unchanged, uint32_t batteryVoltage, char *reasonBuffer);
+    static int nextBoundary(int secondsInDay);
+
+    static PCWakePolicy _policy;
+    static uint32_t _intervalMinutes;
+    static uint32_t _maxBackoffMinutes;
+    static uint32_t _batteryFloor;
+    static String _reason;
+};
+
+#endif
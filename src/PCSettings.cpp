@@ -0,0 +1,389 @@
+#include "PCSettings.h"
+
+#define settingsSnapshotKey "Settings"
+
+static uint32_t fnv1a(uint32_t hash, const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= data[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+static void appendUInt32(std::vector<uint8_t> &buffer, uint32_t value)
+{
+    buffer.push_back((uint8_t)value);
+    buffer.push_back((uint8_t)(value >> 8));
+    buffer.push_back((uint8_t)(value >> 16));
+    buffer.push_back((uint8_t)(value >> 24));
+}
+
+static void appendString(std::vector<uint8_t> &buffer, const String &value)
+{
+    appendUInt32(buffer, value.length());
+    buffer.insert(buffer.end(), value.c_str(), value.c_str() + value.length());
+}
+
+static boolean readUInt32(const uint8_t *data, size_t length, size_t &position, uint32_t &value)
+{
+    if (position + 4 > length)
+        return false;
+    value = data[position] | (data[position + 1] << 8) | (data[position + 2] << 16) | ((uint32_t)data[position + 3] << 24);
+    position += 4;
+    return true;
+}
+
+static boolean readString(const uint8_t *data, size_t length, size_t &position, String &value)
+{
+    uint32_t stringLength;
+    if (!readUInt32(data, length, position, stringLength) || position + stringLength > length)
+        return false;
+    value = "";
+    value.concat((const char *)data + position, stringLength);
+    position += stringLength;
+    return true;
+}
+
+PCSettings::PCSettings()
+{
+    wifiID = "wifiID";
+    wifiPW = "wifiPW";
+    subnet = "255.255.255.0";
+    pemFileName = "/root_ca.pem";
+    timezone = 0;
+    dnsTTL = 3600;
+    duplicatePolicy = "first";
+    layout = "month";
+    eventsPerDay = 0;
+    metrics = "log";
+    logLevel = "info";
+    prerenderDays = 0;
+    maxStaleness = 24;
+    wakeBudget = 120;
+    wifiBudget = 30;
+    feedBudget = 30;
+    epdLightSleep = "on";
+    epdResetMs = 10;
+    epdSettleMs = 0;
+    wakePolicy = "daily";
+    wakeInterval = 60;
+    maxBackoff = 720;
+    batteryFloor = 0;
+    fingerprint = 0;
+}
+
+void PCSettings::loadFromFile(File &file)
+{
+    while (file.available() > 0)
+    {
+        String line = file.readStringUntil('\n');
+        if (line.startsWith("//"))
+            continue;
+        if (line.endsWith("\r"))
+            line.remove(line.length() - 1);
+        int separatorLocation = line.indexOf(":");
+        if (separatorLocation > -1)
+        {
+            String key = line.substring(0, separatorLocation);
+            String content = line.substring(separatorLocation + 1);
+
+            // WiFi SSID and paassword
+            if (key == "SSID")
+                wifiID = content;
+
+            else if (key == "PASS")
+                wifiPW = content;
+
+            // Optional static IP configuration
+            else if (key == "staticIP")
+                staticIP = content;
+
+            else if (key == "gateway")
+                gateway = content;
+
+            else if (key == "subnet")
+                subnet = content;
+
+            else if (key == "dns")
+                dns = content;
+
+            // HTTPS access
+            else if (key == "pemFileName")
+                pemFileName = content;
+
+            else if (key == "iCalendarURL")
+                feeds.push_back(PCFeedCache::feedFromLine(content));
+
+            else if (key == "holidayURL")
+                holidayURL = content;
+
+            else if (key == "holidayRules")
+                holidayRules = content;
+
+            else if (key == "duplicatePolicy")
+                duplicatePolicy = content;
+
+            else if (key == "dnsTTL")
+                dnsTTL = content.toInt();
+
+            else if (key == "ntpServer")
+                ntpServer = content;
+
+            else if (key == "timezone")
+                timezone = content.toFloat();
+
+            // Display
+            else if (key == "layout")
+                layout = content;
+
+            else if (key == "eventsPerDay")
+                eventsPerDay = content.toInt();
+
+            else if (key == "metrics")
+                metrics = content;
+
+            else if (key == "logLevel")
+                logLevel = content;
+
+            // Offline wakes
+            else if (key == "prerenderDays")
+                prerenderDays = content.toInt();
+
+            else if (key == "maxStaleness")
+                maxStaleness = content.toInt();
+
+            // Time budget of a wake, in seconds
+            else if (key == "wakeBudget")
+                wakeBudget = content.toInt();
+
+            else if (key == "wifiBudget")
+                wifiBudget = content.toInt();
+
+            else if (key == "feedBudget")
+                feedBudget = content.toInt();
+
+            // e-Paper panel
+            else if (key == "epdLightSleep")
+                epdLightSleep = content;
+
+            else if (key == "epdResetMs")
+                epdResetMs = content.toInt();
+
+            else if (key == "epdSettleMs")
+                epdSettleMs = content.toInt();
+
+            // Wake scheduling
+            else if (key == "wakePolicy")
+                wakePolicy = content;
+
+            else if (key == "wakeInterval")
+                wakeInterval = content.toInt();
+
+            else if (key == "maxBackoff")
+                maxBackoff = content.toInt();
+
+            else if (key == "batteryFloor")
+                batteryFloor = content.toInt();
+        }
+    }
+}
+
+void PCSettings::loadRootCA(File &file)
+{
+    rootCA = "";
+    rootCA.reserve(file.size());
+    char buffer[256];
+    size_t length;
+    while ((length = file.readBytes(buffer, sizeof(buffer))) > 0)
+    {
+        rootCA.concat(buffer, length);
+    }
+}
+
+void PCSettings::loadHolidayOverrides(File &file)
+{
+    holidayOverrides = "";
+    holidayOverrides.reserve(file.size());
+    char buffer[256];
+    size_t length;
+    while ((length = file.readBytes(buffer, sizeof(buffer))) > 0)
+    {
+        holidayOverrides.concat(buffer, length);
+    }
+}
+
+uint32_t PCSettings::fingerprintOfFiles(File &settingFile, File &pemFile, File &holidayFile)
+{
+    uint32_t values[6] = {0, 0, 0, 0, 0, 0};
+    if (settingFile)
+    {
+        values[0] = settingFile.getLastWrite();
+        values[1] = settingFile.size();
+    }
+    if (pemFile)
+    {
+        values[2] = pemFile.getLastWrite();
+        values[3] = pemFile.size();
+    }
+    if (holidayFile)
+    {
+        values[4] = holidayFile.getLastWrite();
+        values[5] = holidayFile.size();
+    }
+    return fnv1a(2166136261UL, (const uint8_t *)values, sizeof(values));
+}
+
+boolean PCSettings::loadSnapshot(Preferences &pref)
+{
+    size_t length = pref.getBytesLength(settingsSnapshotKey);
+    if (length == 0)
+        return false;
+    uint8_t *data = new uint8_t[length];
+    boolean loaded = (pref.getBytes(settingsSnapshotKey, data, length) == length) && deserialize(data, length);
+    delete[] data;
+    return loaded;
+}
+
+boolean PCSettings::saveSnapshot(Preferences &pref)
+{
+    std::vector<uint8_t> snapshot = serialize();
+
+    // Write only when the stored snapshot differs
+    size_t length = pref.getBytesLength(settingsSnapshotKey);
+    if (length == snapshot.size())
+    {
+        uint8_t *data = new uint8_t[length];
+        boolean same = (pref.getBytes(settingsSnapshotKey, data, length) == length) && memcmp(data, snapshot.data(), length) == 0;
+        delete[] data;
+        if (same)
+            return true;
+    }
+    if (pref.putBytes(settingsSnapshotKey, snapshot.data(), snapshot.size()) != snapshot.size())
+    {
+        log_printf("Failed to save settings snapshot (%d bytes)\n", (int)snapshot.size());
+        return false;
+    }
+    log_printf("Settings snapshot saved (%d bytes)\n", (int)snapshot.size());
+    return true;
+}
+
+std::vector<uint8_t> PCSettings::serialize()
+{
+    std::vector<uint8_t> buffer;
+    appendUInt32(buffer, SETTINGS_SNAPSHOT_VERSION);
+    appendUInt32(buffer, fingerprint);
+    appendString(buffer, wifiID);
+    appendString(buffer, wifiPW);
+    appendString(buffer, staticIP);
+    appendString(buffer, gateway);
+    appendString(buffer, subnet);
+    appendString(buffer, dns);
+    appendString(buffer, pemFileName);
+    appendString(buffer, holidayURL);
+    appendString(buffer, holidayRules);
+    appendString(buffer, holidayOverrides);
+    appendString(buffer, duplicatePolicy);
+    uint32_t timezoneBits;
+    memcpy(&timezoneBits, &timezone, sizeof(timezoneBits));
+    appendUInt32(buffer, timezoneBits);
+    appendUInt32(buffer, dnsTTL);
+    appendString(buffer, ntpServer);
+    appendString(buffer, layout);
+    appendUInt32(buffer, eventsPerDay);
+    appendString(buffer, metrics);
+    appendString(buffer, logLevel);
+    appendUInt32(buffer, prerenderDays);
+    appendUInt32(buffer, maxStaleness);
+    appendUInt32(buffer, wakeBudget);
+    appendUInt32(buffer, wifiBudget);
+    appendUInt32(buffer, feedBudget);
+    appendString(buffer, epdLightSleep);
+    appendUInt32(buffer, epdResetMs);
+    appendUInt32(buffer, epdSettleMs);
+    appendString(buffer, wakePolicy);
+    appendUInt32(buffer, wakeInterval);
+    appendUInt32(buffer, maxBackoff);
+    appendUInt32(buffer, batteryFloor);
+    appendUInt32(buffer, feeds.size());
+    for (auto &feed : feeds)
+    {
+        appendString(buffer, feed.url);
+        appendUInt32(buffer, feed.refreshMinutes);
+        appendUInt32(buffer, feed.maxSize);
+        appendUInt32(buffer, feed.budgetSeconds);
+        appendUInt32(buffer, feed.priority);
+        appendUInt32(buffer, feed.color);
+    }
+    appendString(buffer, rootCA);
+    // Checksum of everything above
+    appendUInt32(buffer, fnv1a(2166136261UL, buffer.data(), buffer.size()));
+    return buffer;
+}
+
+boolean PCSettings::deserialize(const uint8_t *data, size_t length)
+{
+    if (length < 8 || fnv1a(2166136261UL, data, length - 4) != (data[length - 4] | (data[length - 3] << 8) | (data[length - 2] << 16) | ((uint32_t)data[length - 1] << 24)))
+        return false;
+
+    size_t position = 0;
+    uint32_t version;
+    if (!readUInt32(data, length, position, version) || version != SETTINGS_SNAPSHOT_VERSION)
+        return false;
+
+    uint32_t timezoneBits;
+    uint32_t numberOfFeeds;
+    boolean valid = readUInt32(data, length, position, fingerprint) &&
+                    readString(data, length, position, wifiID) &&
+                    readString(data, length, position, wifiPW) &&
+                    readString(data, length, position, staticIP) &&
+                    readString(data, length, position, gateway) &&
+                    readString(data, length, position, subnet) &&
+                    readString(data, length, position, dns) &&
+                    readString(data, length, position, pemFileName) &&
+                    readString(data, length, position, holidayURL) &&
+                    readString(data, length, position, holidayRules) &&
+                    readString(data, length, position, holidayOverrides) &&
+                    readString(data, length, position, duplicatePolicy) &&
+                    readUInt32(data, length, position, timezoneBits) &&
+                    readUInt32(data, length, position, dnsTTL) &&
+                    readString(data, length, position, ntpServer) &&
+                    readString(data, length, position, layout) &&
+                    readUInt32(data, length, position, eventsPerDay) &&
+                    readString(data, length, position, metrics) &&
+                    readString(data, length, position, logLevel) &&
+                    readUInt32(data, length, position, prerenderDays) &&
+                    readUInt32(data, length, position, maxStaleness) &&
+                    readUInt32(data, length, position, wakeBudget) &&
+                    readUInt32(data, length, position, wifiBudget) &&
+                    readUInt32(data, length, position, feedBudget) &&
+                    readString(data, length, position, epdLightSleep) &&
+                    readUInt32(data, length, position, epdResetMs) &&
+                    readUInt32(data, length, position, epdSettleMs) &&
+                    readString(data, length, position, wakePolicy) &&
+                    readUInt32(data, length, position, wakeInterval) &&
+                    readUInt32(data, length, position, maxBackoff) &&
+                    readUInt32(data, length, position, batteryFloor) &&
+                    readUInt32(data, length, position, numberOfFeeds);
+    if (!valid)
+        return false;
+    memcpy(&timezone, &timezoneBits, sizeof(timezone));
+
+    feeds.clear();
+    for (uint32_t i = 0; i < numberOfFeeds; i++)
+    {
+        PCFeed feed;
+        uint32_t color;
+        if (!readString(data, length, position, feed.url) ||
+            !readUInt32(data, length, position, feed.refreshMinutes) ||
+            !readUInt32(data, length, position, feed.maxSize) ||
+            !readUInt32(data, length, position, feed.budgetSeconds) ||
+            !readUInt32(data, length, position, feed.priority) ||
+            !readUInt32(data, length, position, color))
+            return false;
+        feed.color = color;
+        feeds.push_back(feed);
+    }
+    return readString(data, length, position, rootCA);
+}
@@ -0,0 +1,66 @@
+#ifndef PCSETTINGS_H_INCLUDE
+#define PCSETTINGS_H_INCLUDE
+
+#include <Arduino.h>
+#include <FS.h>
+#include <Preferences.h>
+#include <vector>
+
+#include "PCFeedCache.h"
+
+#define SETTINGS_SNAPSHOT_VERSION 13
+
+// Settings loaded from "settings.txt" and the PEM file in SD card.
+// A compiled snapshot is kept in NVS, so timer wakes can start without
+// mounting SD card or parsing text.
+class PCSettings
+{
+public:
+    PCSettings();
+    void loadFromFile(File &file);
+    void loadRootCA(File &file);
+    void loadHolidayOverrides(File &file);
+    boolean loadSnapshot(Preferences &pref);
+    boolean saveSnapshot(Preferences &pref);
+    static uint32_t fingerprintOfFiles(File &settingFile, File &pemFile, File &holidayFile);
+
+    String wifiID;
+    String wifiPW;
+    String staticIP;
+    String gateway;
+    String subnet;
+    String dns;
+    String pemFileName;
+    String rootCA;
+    std::vector<PCFeed> feeds;
+    String holidayURL;
+    String holidayRules;
+    String holidayOverrides;
+    String duplicatePolicy;
+    float timezone;
+    uint32_t dnsTTL;
+    String ntpServer;
+    String layout;
+    uint32_t eventsPerDay;
+    String metrics;
+    String logLevel;
+    uint32_t prerenderDays;
+    uint32_t maxStaleness;
+    uint32_t wakeBudget;
+    uint32_t wifiBudget;
+    uint32_t feedBudget;
+    String epdLightSleep;
+    uint32_t epdResetMs;
+    uint32_t epdSettleMs;
+    String wakePolicy;
+    uint32_t wakeInterval;
+    uint32_t maxBackoff;
+    uint32_t batteryFloor;
+    uint32_t fingerprint;
+
+private:
+    std::vector<uint8_t> serialize();
+    boolean deserialize(const uint8_t *data, size_t length);
+};
+
+#endif
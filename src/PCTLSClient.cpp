@@ -0,0 +1,163 @@
+#include <errno.h>
+#include <lwip/sockets.h>
+#include <mbedtls/ssl_internal.h>
+
+#include "PCTLSClient.h"
+#include "PCTLSSessions.h"
+
+#define TLS_CONNECT_TIMEOUT_MS 10000
+#define TLS_PERSONALIZATION "PaperCal"
+
+// Saved sessions pass through here, it is too large for the stack of a feed
+static uint8_t sessionBuffer[TLS_SESSION_MAX_BYTES];
+
+PCTLSClient::PCTLSClient()
+{
+    _resumed = false;
+}
+
+// TCP connection within TLS_CONNECT_TIMEOUT_MS, as start_ssl_client() opens it
+static int openSocket(IPAddress address, uint16_t port)
+{
+    int socket = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (socket < 0)
+        return -1;
+    struct sockaddr_in server;
+    memset(&server, 0, sizeof(server));
+    server.sin_family = AF_INET;
+    server.sin_addr.s_addr = (uint32_t)address;
+    server.sin_port = htons(port);
+
+    fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+    int result = lwip_connect(socket, (struct sockaddr *)&server, sizeof(server));
+    if (result < 0 && errno == EINPROGRESS)
+    {
+        fd_set sockets;
+        FD_ZERO(&sockets);
+        FD_SET(socket, &sockets);
+        struct timeval timeout = {TLS_CONNECT_TIMEOUT_MS / 1000, (TLS_CONNECT_TIMEOUT_MS % 1000) * 1000};
+        int error = 0;
+        socklen_t length = sizeof(error);
+        result = (select(socket + 1, NULL, &sockets, NULL, &timeout) > 0 &&
+                  getsockopt(socket, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0)
+                     ? 0
+                     : -1;
+    }
+    if (result < 0)
+    {
+        lwip_close(socket);
+        return -1;
+    }
+    fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) & ~O_NONBLOCK);
+    struct timeval timeout = {TLS_CONNECT_TIMEOUT_MS / 1000, 0};
+    int enable = 1;
+    lwip_setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    lwip_setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    lwip_setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    lwip_setsockopt(socket, SOL_SOCKET, SO_KEEPALIVE, &enable, sizeof(enable));
+    return socket;
+}
+
+int PCTLSClient::connect(IPAddress address, uint16_t port, const char *host, const char *rootCA)
+{
+    _resumed = false;
+    // stop() frees the certificate chain only when _CA_cert is set
+    setCACert(rootCA);
+    sslclient->socket = openSocket(address, port);
+    if (sslclient->socket < 0)
+    {
+        log_printf("TCP connection failed: %s\n", host);
+        return 0;
+    }
+
+    int result;
+    mbedtls_entropy_init(&sslclient->entropy_ctx);
+    if ((result = mbedtls_ctr_drbg_seed(&sslclient->drbg_ctx, mbedtls_entropy_func, &sslclient->entropy_ctx,
+                                        (const unsigned char *)TLS_PERSONALIZATION, strlen(TLS_PERSONALIZATION))) != 0 ||
+        (result = mbedtls_ssl_config_defaults(&sslclient->ssl_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                              MBEDTLS_SSL_PRESET_DEFAULT)) != 0)
+    {
+        log_printf("TLS setup failed: -0x%04x\n", -result);
+        return fail();
+    }
+    mbedtls_ssl_conf_authmode(&sslclient->ssl_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_x509_crt_init(&sslclient->ca_cert);
+    if ((result = mbedtls_x509_crt_parse(&sslclient->ca_cert, (const unsigned char *)rootCA, strlen(rootCA) + 1)) != 0)
+    {
+        log_printf("Root certificate not parsed: -0x%04x\n", -result);
+        return fail();
+    }
+    mbedtls_ssl_conf_ca_chain(&sslclient->ssl_conf, &sslclient->ca_cert, NULL);
+    mbedtls_ssl_conf_rng(&sslclient->ssl_conf, mbedtls_ctr_drbg_random, &sslclient->drbg_ctx);
+    if ((result = mbedtls_ssl_setup(&sslclient->ssl_ctx, &sslclient->ssl_conf)) != 0 ||
+        (result = mbedtls_ssl_set_hostname(&sslclient->ssl_ctx, host)) != 0)
+    {
+        log_printf("TLS setup failed: -0x%04x\n", -result);
+        return fail();
+    }
+    mbedtls_ssl_set_bio(&sslclient->ssl_ctx, &sslclient->socket, mbedtls_net_send, mbedtls_net_recv, NULL);
+
+    // The server resumes the session or falls back to a full handshake
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    size_t length = PCTLSSessions::load(host, port, sessionBuffer, sizeof(sessionBuffer));
+    if (length > 0 && (mbedtls_ssl_session_load(&session, sessionBuffer, length) != 0 ||
+                       mbedtls_ssl_set_session(&sslclient->ssl_ctx, &session) != 0))
+    {
+        PCTLSSessions::forget(host, port);
+    }
+    mbedtls_ssl_session_free(&session);
+
+    // Step by step, since the handshake parameters that tell a resumed
+    // handshake are freed when it ends
+    unsigned long startMillis = millis();
+    while (sslclient->ssl_ctx.state != MBEDTLS_SSL_HANDSHAKE_OVER)
+    {
+        result = mbedtls_ssl_handshake_step(&sslclient->ssl_ctx);
+        if (sslclient->ssl_ctx.handshake != NULL && sslclient->ssl_ctx.handshake->resume)
+            _resumed = true;
+        if (result == 0)
+            continue;
+        if ((result != MBEDTLS_ERR_SSL_WANT_READ && result != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+            millis() - startMillis > sslclient->handshake_timeout)
+        {
+            log_printf("TLS handshake failed: %s -0x%04x\n", host, -result);
+            PCTLSSessions::forget(host, port);
+            return fail();
+        }
+        delay(2);
+    }
+
+    // The session may carry a new ticket, so it is saved after every handshake
+    size_t savedLength = 0;
+    mbedtls_ssl_session_init(&session);
+    if (mbedtls_ssl_get_session(&sslclient->ssl_ctx, &session) == 0 &&
+        mbedtls_ssl_session_save(&session, sessionBuffer, sizeof(sessionBuffer), &savedLength) == 0)
+    {
+        PCTLSSessions::save(host, port, sessionBuffer, savedLength);
+    }
+    else
+    {
+        log_printf("TLS session of %s not saved, %u bytes\n", host, (unsigned int)savedLength);
+    }
+    mbedtls_ssl_session_free(&session);
+    _connected = true;
+    return 1;
+}
+
+// Frees what connect() set up. ssl_init() clears the whole context, so the
+// socket and handshake timeout are set again as a new client has them.
+int PCTLSClient::fail()
+{
+    unsigned long handshakeTimeout = sslclient->handshake_timeout;
+    stop();
+    ssl_init(sslclient);
+    sslclient->socket = -1;
+    sslclient->handshake_timeout = handshakeTimeout;
+    return 0;
+}
+
+boolean PCTLSClient::resumed()
+{
+    return _resumed;
+}
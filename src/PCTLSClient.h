@@ -0,0 +1,28 @@
+#ifndef PCTLSCLIENT_H_INCLUDE
+#define PCTLSCLIENT_H_INCLUDE
+
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+
+// WiFiClientSecure that offers the server the session of the last connection
+// to the same host, kept in PCTLSSessions, so a resumed handshake skips the
+// certificate chain and the key exchange of a full one.
+// WiFiClientSecure::connect() sets up mbedTLS and handshakes in one call,
+// so connect() here takes the same steps on the inherited sslclient context
+// and sets the saved session before the handshake. Reading, writing and
+// stop() are those of WiFiClientSecure.
+// The native tests build test/support/PCTLSClient.cpp with OpenSSL instead.
+class PCTLSClient : public WiFiClientSecure
+{
+public:
+    PCTLSClient();
+    int connect(IPAddress address, uint16_t port, const char *host, const char *rootCA);
+    boolean resumed();
+
+private:
+    int fail();
+
+    boolean _resumed;
+};
+
+#endif
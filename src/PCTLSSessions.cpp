@@ -0,0 +1,98 @@
+#include "PCTLSSessions.h"
+
+typedef struct
+{
+    uint32_t hostHash;
+    uint16_t port;
+    uint16_t length;
+    time_t saved;
+    uint8_t data[TLS_SESSION_MAX_BYTES];
+} PCTLSSession;
+
+RTC_DATA_ATTR static PCTLSSession sessions[TLS_SESSION_SLOTS];
+
+static uint32_t hashOfHost(String host)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261UL;
+    for (int i = 0; i < host.length(); i++)
+    {
+        hash ^= (uint8_t)tolower(host.charAt(i));
+        hash *= 16777619UL;
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+static PCTLSSession *find(String host, uint16_t port)
+{
+    uint32_t hostHash = hashOfHost(host);
+    for (int i = 0; i < TLS_SESSION_SLOTS; i++)
+    {
+        if (sessions[i].hostHash == hostHash && sessions[i].port == port && sessions[i].length > 0)
+            return &sessions[i];
+    }
+    return NULL;
+}
+
+// Length of the saved session copied to buffer, 0 when there is none or it
+// is too old to be worth offering
+size_t PCTLSSessions::load(String host, uint16_t port, uint8_t *buffer, size_t size)
+{
+    PCTLSSession *session = find(host, port);
+    if (session == NULL || session->length > size)
+        return 0;
+    time_t now = time(NULL);
+    if (now < session->saved || now - session->saved > TLS_SESSION_MAX_AGE)
+    {
+        session->length = 0;
+        return 0;
+    }
+    memcpy(buffer, session->data, session->length);
+    return session->length;
+}
+
+boolean PCTLSSessions::save(String host, uint16_t port, const uint8_t *data, size_t length)
+{
+    if (length == 0 || length > TLS_SESSION_MAX_BYTES)
+    {
+        log_printf("TLS session of %s not kept, %u bytes\n", host.c_str(), (unsigned int)length);
+        return false;
+    }
+    // The slot of the host, a free one, or the oldest session
+    PCTLSSession *session = find(host, port);
+    for (int i = 0; i < TLS_SESSION_SLOTS && session == NULL; i++)
+    {
+        if (sessions[i].length == 0)
+            session = &sessions[i];
+    }
+    if (session == NULL)
+    {
+        session = &sessions[0];
+        for (int i = 1; i < TLS_SESSION_SLOTS; i++)
+        {
+            if (sessions[i].saved < session->saved)
+                session = &sessions[i];
+        }
+    }
+    session->hostHash = hashOfHost(host);
+    session->port = port;
+    session->length = length;
+    session->saved = time(NULL);
+    memcpy(session->data, data, length);
+    return true;
+}
+
+void PCTLSSessions::forget(String host, uint16_t port)
+{
+    PCTLSSession *session = find(host, port);
+    if (session != NULL)
+        session->length = 0;
+}
+
+void PCTLSSessions::clear()
+{
+    for (int i = 0; i < TLS_SESSION_SLOTS; i++)
+    {
+        sessions[i].length = 0;
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef PCTLSSESSIONS_H_INCLUDE
+#define PCTLSSESSIONS_H_INCLUDE
+
+#include <Arduino.h>
+
+#define TLS_SESSION_SLOTS 2
+#define TLS_SESSION_MAX_BYTES 1536 // a saved mbedTLS session keeps the server certificate
+#define TLS_SESSION_MAX_AGE 86400  // seconds, servers keep tickets about a day
+
+// Serialized TLS sessions per host and port, kept in RTC memory so the first
+// connection of a timer wake can resume the session of the last wake.
+// The oldest session is replaced when every slot is taken.
+class PCTLSSessions
+{
+public:
+    static size_t load(String host, uint16_t port, uint8_t *buffer, size_t size);
+    static boolean save(String host, uint16_t port, const uint8_t *data, size_t length);
+    static void forget(String host, uint16_t port);
+    static void clear();
+};
+
+#endif
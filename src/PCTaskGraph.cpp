@@ -0,0 +1,213 @@
+#include "PCTaskGraph.h"
+#include "PCLog.h"
+
+PCGraphTask PCTaskGraph::_tasks[MAX_GRAPH_TASKS];
+int PCTaskGraph::_numberOfTasks = 0;
+unsigned long PCTaskGraph::_startMillis = 0;
+unsigned long PCTaskGraph::_endMillis = 0;
+QueueHandle_t PCTaskGraph::_finished = NULL;
+
+static const char *stateNames[] = {"pending", "running", "done", "failed", "skipped"};
+
+void PCTaskGraph::clear()
+{
+    _numberOfTasks = 0;
+    _startMillis = 0;
+    _endMillis = 0;
+}
+
+// Returns the task index, GRAPH_NO_TASK when the graph is full
+int PCTaskGraph::add(const char *name, PCTaskFunction function, uint32_t dependencies, BaseType_t core, uint32_t stackSize)
+{
+    if (_numberOfTasks >= MAX_GRAPH_TASKS)
+    {
+        log_printf("Task graph is full, %s not added\n", name);
+        return GRAPH_NO_TASK;
+    }
+    PCGraphTask &task = _tasks[_numberOfTasks];
+    task.name = name;
+    task.function = function;
+    // Only earlier tasks, so the graph has no cycles
+    task.dependencies = dependencies & ((1UL << _numberOfTasks) - 1);
+    task.core = core;
+    task.stackSize = stackSize;
+    task.state = GRAPH_PENDING;
+    task.predecessor = GRAPH_NO_TASK;
+    task.startMillis = 0;
+    task.endMillis = 0;
+    return _numberOfTasks++;
+}
+
+// Dependency bit of a task, none for GRAPH_NO_TASK
+uint32_t PCTaskGraph::bit(int task)
+{
+    return (task >= 0 && task < MAX_GRAPH_TASKS) ? (1UL << task) : 0;
+}
+
+// Returns true when every task is done
+boolean PCTaskGraph::run()
+{
+    if (_finished == NULL)
+    {
+        _finished = xQueueCreate(MAX_GRAPH_TASKS, sizeof(PCGraphMessage));
+    }
+    _startMillis = millis();
+    int running = 0;
+    while (true)
+    {
+        // Skipping a task may skip its dependents in turn
+        boolean changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (int i = 0; i < _numberOfTasks; i++)
+            {
+                PCGraphTask &task = _tasks[i];
+                if (task.state != GRAPH_PENDING)
+                    continue;
+                if ((task.dependencies & (tasksIn(GRAPH_FAILED) | tasksIn(GRAPH_SKIPPED))) != 0)
+                {
+                    task.state = GRAPH_SKIPPED;
+                    changed = true;
+                }
+                else if ((task.dependencies & tasksIn(GRAPH_DONE)) == task.dependencies)
+                {
+                    startTask(i);
+                    running++;
+                }
+            }
+        }
+        if (running == 0)
+            break;
+
+        // States change here only, the tasks report through the queue
+        PCGraphMessage message;
+        xQueueReceive(_finished, &message, portMAX_DELAY);
+        _tasks[message.task].state = message.succeeded ? GRAPH_DONE : GRAPH_FAILED;
+        running--;
+    }
+    _endMillis = millis();
+    return tasksIn(GRAPH_DONE) == (1UL << _numberOfTasks) - 1;
+}
+
+uint8_t PCTaskGraph::state(int task)
+{
+    return (task >= 0 && task < _numberOfTasks) ? _tasks[task].state : GRAPH_SKIPPED;
+}
+
+unsigned long PCTaskGraph::elapsedMillis()
+{
+    return _endMillis - _startMillis;
+}
+
+// Time of all tasks together, more than elapsedMillis() when they overlapped
+unsigned long PCTaskGraph::busyMillis()
+{
+    unsigned long total = 0;
+    for (int i = 0; i < _numberOfTasks; i++)
+    {
+        if (_tasks[i].state == GRAPH_DONE || _tasks[i].state == GRAPH_FAILED)
+            total += _tasks[i].endMillis - _tasks[i].startMillis;
+    }
+    return total;
+}
+
+unsigned long PCTaskGraph::criticalPathMillis()
+{
+    unsigned long total = 0;
+    for (int i = lastTask(); i != GRAPH_NO_TASK; i = _tasks[i].predecessor)
+    {
+        total += _tasks[i].endMillis - _tasks[i].startMillis;
+    }
+    return total;
+}
+
+// "connect>feeds>draw>display"
+String PCTaskGraph::criticalPath()
+{
+    String path = "";
+    for (int i = lastTask(); i != GRAPH_NO_TASK; i = _tasks[i].predecessor)
+    {
+        path = path.isEmpty() ? String(_tasks[i].name) : String(_tasks[i].name) + ">" + path;
+    }
+    return path;
+}
+
+void PCTaskGraph::report()
+{
+    log_printf("%-8s %4s %7s %7s %7s  %s\n", "task", "core", "start", "end", "ms", "state");
+    uint32_t path = 0;
+    for (int i = lastTask(); i != GRAPH_NO_TASK; i = _tasks[i].predecessor)
+    {
+        path |= bit(i);
+    }
+    for (int i = 0; i < _numberOfTasks; i++)
+    {
+        PCGraphTask &task = _tasks[i];
+        log_printf("%-8s %4d %7lu %7lu %7lu  %s%s\n", task.name, (int)task.core, task.startMillis, task.endMillis,
+                   task.endMillis - task.startMillis, stateNames[task.state], (path & bit(i)) ? ", critical" : "");
+    }
+    log_printf("Task graph: %lu ms for %lu ms of tasks, critical path %lu ms: %s\n", elapsedMillis(), busyMillis(), criticalPathMillis(), criticalPath().c_str());
+    PCLog::record(LOG_VERBOSE, LOG_GRAPH, elapsedMillis(), busyMillis(), criticalPathMillis(), path);
+}
+
+uint32_t PCTaskGraph::tasksIn(uint8_t state)
+{
+    uint32_t tasks = 0;
+    for (int i = 0; i < _numberOfTasks; i++)
+    {
+        if (_tasks[i].state == state)
+            tasks |= bit(i);
+    }
+    return tasks;
+}
+
+void PCTaskGraph::startTask(int index)
+{
+    PCGraphTask &task = _tasks[index];
+    // The dependency that finished last held this task back
+    for (int i = 0; i < index; i++)
+    {
+        if ((task.dependencies & bit(i)) && (task.predecessor == GRAPH_NO_TASK || (long)(_tasks[i].endMillis - _tasks[task.predecessor].endMillis) > 0))
+            task.predecessor = i;
+    }
+    task.state = GRAPH_RUNNING;
+    task.startMillis = millis();
+    if (xTaskCreatePinnedToCore(PCTaskGraph::runTask, task.name, task.stackSize, (void *)(intptr_t)index, GRAPH_PRIORITY, NULL, task.core) != pdPASS)
+    {
+        // Without memory for its stack the task runs here, in order
+        log_printf("Task %s runs inline\n", task.name);
+        execute(index);
+    }
+}
+
+void PCTaskGraph::runTask(void *parameter)
+{
+    execute((int)(intptr_t)parameter);
+    vTaskDelete(NULL);
+}
+
+void PCTaskGraph::execute(int index)
+{
+    PCGraphTask &task = _tasks[index];
+    PCGraphMessage message;
+    message.task = index;
+    message.succeeded = task.function();
+    task.endMillis = millis();
+    xQueueSend(_finished, &message, portMAX_DELAY);
+}
+
+// The task that ended last, GRAPH_NO_TASK when none ran
+int PCTaskGraph::lastTask()
+{
+    int last = GRAPH_NO_TASK;
+    for (int i = 0; i < _numberOfTasks; i++)
+    {
+        PCGraphTask &task = _tasks[i];
+        if (task.state != GRAPH_DONE && task.state != GRAPH_FAILED)
+            continue;
+        if (last == GRAPH_NO_TASK || (long)(task.endMillis - _tasks[last].endMillis) > 0)
+            last = i;
+    }
+    return last;
+}
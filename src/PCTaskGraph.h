@@ -0,0 +1,77 @@
+#ifndef PCTASKGRAPH_H_INCLUDE
+#define PCTASKGRAPH_H_INCLUDE
+
+#include <Arduino.h>
+
+#define MAX_GRAPH_TASKS 8
+#define GRAPH_STACK_SIZE 8192
+#define GRAPH_PRIORITY 1 // same as the loop task
+#define GRAPH_NO_TASK -1
+
+// Task states
+#define GRAPH_PENDING 0
+#define GRAPH_RUNNING 1
+#define GRAPH_DONE 2
+#define GRAPH_FAILED 3
+#define GRAPH_SKIPPED 4
+
+// Returns false to stop the tasks that depend on it
+typedef boolean (*PCTaskFunction)();
+
+typedef struct
+{
+    int task;
+    boolean succeeded;
+} PCGraphMessage;
+
+typedef struct
+{
+    const char *name;
+    PCTaskFunction function;
+    uint32_t dependencies; // bits of the tasks that must be done first
+    BaseType_t core;
+    uint32_t stackSize;
+    uint8_t state;
+    int predecessor; // the dependency that finished last, GRAPH_NO_TASK for none
+    unsigned long startMillis;
+    unsigned long endMillis;
+} PCGraphTask;
+
+// Steps of a wake as a graph of FreeRTOS tasks.
+// A task depends only on tasks added before it and starts on its core as
+// soon as those are done, so independent steps overlap. A task that fails
+// skips everything that depends on it, and run() returns once no task is
+// left running.
+// Tasks of one graph must not share state that is not safe to share, the
+// dependencies are the only ordering between them.
+// The critical path is the chain of last finished dependencies back from
+// the task that ended last, the wake can not be shorter than that chain.
+class PCTaskGraph
+{
+public:
+    static void clear();
+    static int add(const char *name, PCTaskFunction function, uint32_t dependencies, BaseType_t core, uint32_t stackSize = GRAPH_STACK_SIZE);
+    static uint32_t bit(int task);
+    static boolean run();
+    static uint8_t state(int task);
+    static unsigned long elapsedMillis();
+    static unsigned long busyMillis();
+    static unsigned long criticalPathMillis();
+    static String criticalPath();
+    static void report();
+
+private:
+    static uint32_t tasksIn(uint8_t state);
+    static void startTask(int index);
+    static void runTask(void *parameter);
+    static void execute(int index);
+    static int lastTask();
+
+    static PCGraphTask _tasks[MAX_GRAPH_TASKS];
+    static int _numberOfTasks;
+    static unsigned long _startMillis;
+    static unsigned long _endMillis;
+    static QueueHandle_t _finished;
+};
+
+#endif
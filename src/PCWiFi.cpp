@@ -0,0 +1,163 @@
+#include "PCWiFi.h"
+
+#define WIFI_CACHE_MAGIC 0x50435746
+
+// Association parameters kept across deep sleep
+typedef struct
+{
+    uint32_t magic;
+    uint8_t bssid[6];
+    int32_t channel;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+} PCWiFiCache;
+
+RTC_DATA_ATTR static PCWiFiCache wifiCache;
+
+static SemaphoreHandle_t connectSemaphore = NULL;
+static volatile boolean connectFailed = false;
+
+boolean PCWiFi::_hasStaticIP = false;
+IPAddress PCWiFi::_staticIP;
+IPAddress PCWiFi::_staticGateway;
+IPAddress PCWiFi::_staticSubnet;
+IPAddress PCWiFi::_staticDNS;
+unsigned long PCWiFi::_lastConnectMillis = 0;
+boolean PCWiFi::_lastConnectWasFast = false;
+
+void PCWiFi::setStaticIP(String ip, String gateway, String subnet, String dns)
+{
+    _hasStaticIP = _staticIP.fromString(ip) && _staticGateway.fromString(gateway) && _staticSubnet.fromString(subnet);
+    if (!_staticDNS.fromString(dns))
+    {
+        _staticDNS = _staticGateway;
+    }
+}
+
+// timeoutMillis covers both the fast path and the scan
+boolean PCWiFi::connect(String ssid, String password, boolean useCache, unsigned long timeoutMillis)
+{
+    unsigned long startMillis = millis();
+    timeoutMillis = min(timeoutMillis, (unsigned long)FULL_CONNECT_TIMEOUT_MS);
+    if (connectSemaphore == NULL)
+    {
+        connectSemaphore = xSemaphoreCreateBinary();
+        WiFi.onEvent(PCWiFi::onEvent, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+        WiFi.onEvent(PCWiFi::onEvent, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    }
+    WiFi.persistent(false);
+    WiFi.mode(WIFI_STA);
+
+    boolean connected = false;
+    _lastConnectWasFast = false;
+    if (useCache && isCacheValid())
+    {
+        // Connect directly to the known AP, reusing the last IP configuration
+        if (_hasStaticIP)
+        {
+            WiFi.config(_staticIP, _staticGateway, _staticSubnet, _staticDNS);
+        }
+        else
+        {
+            WiFi.config(IPAddress(wifiCache.ip), IPAddress(wifiCache.gateway), IPAddress(wifiCache.subnet), IPAddress(wifiCache.dns));
+        }
+        WiFi.begin(ssid.c_str(), password.c_str(), wifiCache.channel, wifiCache.bssid);
+        connected = waitForConnection(min(timeoutMillis, (unsigned long)FAST_CONNECT_TIMEOUT_MS), true);
+        _lastConnectWasFast = connected;
+        if (!connected)
+        {
+            log_printf("WiFi fast connect failed, scanning\n");
+            invalidateCache();
+            WiFi.disconnect();
+        }
+    }
+
+    unsigned long elapsed = millis() - startMillis;
+    if (!connected && elapsed < timeoutMillis)
+    {
+        // Full scan and DHCP unless a static IP is configured
+        if (_hasStaticIP)
+        {
+            WiFi.config(_staticIP, _staticGateway, _staticSubnet, _staticDNS);
+        }
+        else
+        {
+            WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+        }
+        WiFi.begin(ssid.c_str(), password.c_str());
+        connected = waitForConnection(timeoutMillis - elapsed, false);
+    }
+
+    _lastConnectMillis = millis() - startMillis;
+    if (connected)
+    {
+        saveCache();
+        log_printf("WiFi connected in %lu ms (%s)\n", _lastConnectMillis, _lastConnectWasFast ? "fast" : "scan");
+    }
+    else
+    {
+        log_printf("WiFi connection failed after %lu ms\n", _lastConnectMillis);
+    }
+    return connected;
+}
+
+void PCWiFi::invalidateCache()
+{
+    wifiCache.magic = 0;
+}
+
+boolean PCWiFi::isCacheValid()
+{
+    return wifiCache.magic == WIFI_CACHE_MAGIC && wifiCache.channel > 0;
+}
+
+unsigned long PCWiFi::lastConnectMillis()
+{
+    return _lastConnectMillis;
+}
+
+boolean PCWiFi::lastConnectWasFast()
+{
+    return _lastConnectWasFast;
+}
+
+boolean PCWiFi::waitForConnection(unsigned long timeoutMillis, boolean stopOnDisconnect)
+{
+    unsigned long startMillis = millis();
+    xSemaphoreTake(connectSemaphore, 0);
+    connectFailed = false;
+    while (WiFi.status() != WL_CONNECTED)
+    {
+        unsigned long elapsed = millis() - startMillis;
+        if (elapsed >= timeoutMillis)
+            return false;
+        // Woken by GOT_IP or DISCONNECTED instead of polling
+        xSemaphoreTake(connectSemaphore, pdMS_TO_TICKS(timeoutMillis - elapsed));
+        if (connectFailed && stopOnDisconnect)
+            return false;
+        connectFailed = false;
+    }
+    return true;
+}
+
+void PCWiFi::saveCache()
+{
+    memcpy(wifiCache.bssid, WiFi.BSSID(), sizeof(wifiCache.bssid));
+    wifiCache.channel = WiFi.channel();
+    wifiCache.ip = WiFi.localIP();
+    wifiCache.gateway = WiFi.gatewayIP();
+    wifiCache.subnet = WiFi.subnetMask();
+    wifiCache.dns = WiFi.dnsIP();
+    wifiCache.magic = WIFI_CACHE_MAGIC;
+}
+
+void PCWiFi::onEvent(arduino_event_id_t event, arduino_event_info_t info)
+{
+    if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED)
+    {
+        connectFailed = true;
+    }
+    xSemaphoreGive(connectSemaphore);
+}
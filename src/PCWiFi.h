@@ -0,0 +1,37 @@
+#ifndef PCWIFI_H_INCLUDE
+#define PCWIFI_H_INCLUDE
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#define FAST_CONNECT_TIMEOUT_MS 3000
+#define FULL_CONNECT_TIMEOUT_MS 60000
+
+// WiFi station connection with a fast path for timer wakes.
+// BSSID, channel and IP configuration of the last successful association are
+// kept in RTC memory, so the next wake can skip the scan and DHCP.
+class PCWiFi
+{
+public:
+    static void setStaticIP(String ip, String gateway, String subnet, String dns);
+    static boolean connect(String ssid, String password, boolean useCache, unsigned long timeoutMillis = FULL_CONNECT_TIMEOUT_MS);
+    static void invalidateCache();
+    static boolean isCacheValid();
+    static unsigned long lastConnectMillis();
+    static boolean lastConnectWasFast();
+
+private:
+    static boolean waitForConnection(unsigned long timeoutMillis, boolean stopOnDisconnect);
+    static void saveCache();
+    static void onEvent(arduino_event_id_t event, arduino_event_info_t info);
+
+    static boolean _hasStaticIP;
+    static IPAddress _staticIP;
+    static IPAddress _staticGateway;
+    static IPAddress _staticSubnet;
+    static IPAddress _staticDNS;
+    static unsigned long _lastConnectMillis;
+    static boolean _lastConnectWasFast;
+};
+
+#endif
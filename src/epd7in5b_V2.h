@@ -27,33 +27,57 @@
 #ifndef EPD7IN5B_H
 #define EPD7IN5B_H
 
-#include "epdif.h"
+#include "epdpanel.h"
 
 // Display resolution
 #define EPD_WIDTH       800
 #define EPD_HEIGHT      480
 
-class Epd : EpdIf {
-public:
-    unsigned long width;
-    unsigned long height;
-
-    Epd();
-    ~Epd();
-    int  Init(void);
-    void WaitUntilIdle(void);
-    void Reset(void);
-    void Displaypart(const unsigned char* pbuffer, unsigned long xStart, unsigned long yStart,unsigned long Picture_Width,unsigned long Picture_Height, unsigned char Block);
-    void SendCommand(unsigned char command);
-    void SendData(unsigned char data);
-    void Sleep(void);
-private:
-    unsigned int reset_pin;
-    unsigned int dc_pin;
-    unsigned int cs_pin;
-    unsigned int busy_pin;
+/**
+ *  @brief: 7.5inch e-Paper (B) V2, UC8179 controller with black and red planes.
+ */
+struct Epd7in5bV2 {
+    static const unsigned long width = EPD_WIDTH;
+    static const unsigned long height = EPD_HEIGHT;
+    static const int busyIdleLevel = HIGH;
+    static const unsigned char statusCommand = 0x71;   // GET STATUS, BUSY is valid after it
+
+    static constexpr EpdStep initSteps[] = {
+        {0x01, 0, 4, {0x07, 0x07, 0x3f, 0x3f}},        //POWER SETTING: VGH=20V,VGL=-20V, VDH=15V, VDL=-15V
+        {0x04, EPD_STEP_WAIT, 0, {}},                  //POWER ON
+        {0x00, 0, 1, {0x0F}},                          //PANNEL SETTING: KW-3f KWR-2F BWROTP 0f BWOTP 1f
+        {0x61, 0, 4, {EPD_WIDTH >> 8, EPD_WIDTH & 0xff, EPD_HEIGHT >> 8, EPD_HEIGHT & 0xff}},  //tres
+        {0x15, 0, 1, {0x00}},
+        {0x50, 0, 2, {0x11, 0x07}},                    //VCOM AND DATA INTERVAL SETTING
+        {0x60, 0, 1, {0x22}},                          //TCON SETTING
+        {0x65, 0, 4, {0x00, 0x00, 0x00, 0x00}},        //Resolution setting
+    };
+    static constexpr EpdStep refreshSteps[] = {
+        {0x12, EPD_STEP_WAIT, 0, {}},                  //DISPLAY REFRESH
+    };
+    static constexpr EpdStep sleepSteps[] = {
+        {0x02, EPD_STEP_WAIT, 0, {}},                  //POWER OFF
+        {0x07, 0, 1, {0xa5}},                          //DEEP SLEEP with check code
+    };
+};
+
+template <>
+struct EpdPlane<Epd7in5bV2, EPD_PLANE_BLACK> {
+    static const unsigned char command = 0x10;
+    static const bool inverted = false;
+    static const unsigned char blank = 0xff;
+};
+
+// Red is 0 in the controller and black in the framebuffer
+template <>
+struct EpdPlane<Epd7in5bV2, EPD_PLANE_RED> {
+    static const unsigned char command = 0x13;
+    static const bool inverted = true;
+    static const unsigned char blank = 0x00;
 };
 
+typedef EpdPanel<Epd7in5bV2> Epd;
+
 #endif /* EPD7IN5B_H */
 
 /* END OF FILE */
@@ -46,12 +46,115 @@ void EpdIf::DelayMs(unsigned int delaytime) {
     delay(delaytime);
 }
 
+bool EpdIf::lightSleep = true;
+volatile bool EpdIf::tasksRunning = false;
+EpdTimings EpdIf::timings = {10, 2, 10, 1, 0};
+unsigned long EpdIf::lastWaitMillis = 0;
+unsigned long EpdIf::totalWaitMillis = 0;
+int EpdIf::numberOfWaits = 0;
+
+static SemaphoreHandle_t levelSemaphore = NULL;
+
+static void IRAM_ATTR OnLevelChange() {
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(levelSemaphore, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/**
+ *  @brief: Wait until the pin reaches the level.
+ *          The CPU stays in light sleep and is woken by a GPIO level
+ *          interrupt on the pin, or by the RTC timer at the timeout.
+ *          While tasksRunning is set, light sleep would stop the other
+ *          core and the radio too, so the task blocks on a pin interrupt
+ *          instead. Returns false on timeout.
+ */
+bool EpdIf::WaitForLevel(int pin, int level, unsigned long timeout) {
+    if (tasksRunning) {
+        return WaitForInterrupt(pin, level, timeout);
+    }
+    unsigned long startMillis = millis();
+    while (digitalRead(pin) != level) {
+        unsigned long elapsed = millis() - startMillis;
+        if (elapsed >= timeout) {
+            return false;
+        }
+        if (!lightSleep) {
+            delay(1);
+            continue;
+        }
+        gpio_wakeup_enable((gpio_num_t)pin, level ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+        esp_sleep_enable_gpio_wakeup();
+        esp_sleep_enable_timer_wakeup((uint64_t)(timeout - elapsed) * 1000);
+        if (esp_light_sleep_start() != ESP_OK) {
+            // Light sleep was refused, poll instead
+            lightSleep = false;
+        }
+        gpio_wakeup_disable((gpio_num_t)pin);
+        esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_GPIO);
+        esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+    }
+    return true;
+}
+
+/**
+ *  @brief: Block the calling task until an edge to the level, the other
+ *          tasks keep running.
+ */
+bool EpdIf::WaitForInterrupt(int pin, int level, unsigned long timeout) {
+    if (levelSemaphore == NULL) {
+        levelSemaphore = xSemaphoreCreateBinary();
+    }
+    xSemaphoreTake(levelSemaphore, 0);
+    attachInterrupt(digitalPinToInterrupt(pin), OnLevelChange, level ? RISING : FALLING);
+    unsigned long startMillis = millis();
+    bool reached = true;
+    // The level is read again after each edge, and once after attaching
+    // in case it changed before the interrupt was set
+    while (digitalRead(pin) != level) {
+        unsigned long elapsed = millis() - startMillis;
+        if (elapsed >= timeout) {
+            reached = false;
+            break;
+        }
+        xSemaphoreTake(levelSemaphore, pdMS_TO_TICKS(timeout - elapsed));
+    }
+    detachInterrupt(digitalPinToInterrupt(pin));
+    return reached;
+}
+
 void EpdIf::SpiTransfer(unsigned char data) {
     digitalWrite(CS_PIN, LOW);
     SPI.transfer(data);
     digitalWrite(CS_PIN, HIGH);
 }
 
+/**
+ *  @brief: Data bytes in one transfer, CS stays low between them.
+ */
+void EpdIf::SpiWrite(const unsigned char* data, unsigned long length) {
+    digitalWrite(CS_PIN, LOW);
+    SPI.writeBytes(data, length);
+    digitalWrite(CS_PIN, HIGH);
+}
+
+void EpdIf::SpiFill(unsigned char value, unsigned long length) {
+    if (length == 0) {
+        return;
+    }
+    unsigned char block[64];
+    memset(block, value, sizeof(block));
+    digitalWrite(CS_PIN, LOW);
+    while (length > 0) {
+        unsigned long count = length < sizeof(block) ? length : sizeof(block);
+        SPI.writeBytes(block, count);
+        length -= count;
+    }
+    digitalWrite(CS_PIN, HIGH);
+}
+
 int EpdIf::IfInit(void) {
     pinMode(CS_PIN, OUTPUT);
     pinMode(RST_PIN, OUTPUT);
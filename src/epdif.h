@@ -37,6 +37,19 @@
 #define BUSY_PIN        17
 #define PWR_PIN         7
 
+// Busy wait timeout for a tri-color refresh, which takes about 16 s
+#define BUSY_TIMEOUT_MS 60000
+
+// Delays in ms. The defaults are the minimums of the UC8179 datasheet
+// with a small margin; the controller reports the rest on BUSY.
+typedef struct {
+    unsigned int resetHigh;      // before the reset pulse
+    unsigned int resetLow;       // reset pulse width, at least 10 us
+    unsigned int resetRecovery;  // after reset, before BUSY is valid
+    unsigned int commandSettle;  // after a command, before BUSY goes low
+    unsigned int idleSettle;     // after BUSY goes high
+} EpdTimings;
+
 class EpdIf {
 public:
     EpdIf(void);
@@ -47,6 +60,17 @@ public:
     static int  DigitalRead(int pin);
     static void DelayMs(unsigned int delaytime);
     static void SpiTransfer(unsigned char data);
+    static void SpiWrite(const unsigned char* data, unsigned long length);
+    static void SpiFill(unsigned char value, unsigned long length);
+    static bool WaitForLevel(int pin, int level, unsigned long timeout);
+    static bool WaitForInterrupt(int pin, int level, unsigned long timeout);
+
+    static bool lightSleep;
+    static volatile bool tasksRunning;
+    static EpdTimings timings;
+    static unsigned long lastWaitMillis;
+    static unsigned long totalWaitMillis;
+    static int numberOfWaits;
 };
 
 #endif
@@ -0,0 +1,216 @@
+/**
+ *  @filename   :   epdpanel.h
+ *  @brief      :   Panel driver templated on a panel description
+ *
+ *  A panel is a struct with its geometry, BUSY handling and command tables,
+ *  see Epd7in5bV2 in epd7in5b_V2.h. Each of its planes is an EpdPlane
+ *  specialization. Everything a panel differs in is known at compile time,
+ *  so a plane is streamed without per-byte checks, and a plane the panel
+ *  does not have fails to compile.
+ */
+
+#ifndef EPDPANEL_H
+#define EPDPANEL_H
+
+#include "epdif.h"
+#include "PCFrameKernels.h"
+
+#define EPD_STEP_MAX_DATA   4
+#define EPD_STEP_WAIT       0x01    // commandSettle, then wait for BUSY
+#define EPD_STREAM_ROWS     8       // rows inverted per SPI write
+
+// One command and its data bytes
+typedef struct {
+    unsigned char command;
+    unsigned char flags;
+    unsigned char length;
+    unsigned char data[EPD_STEP_MAX_DATA];
+} EpdStep;
+
+typedef enum {
+    EPD_PLANE_BLACK,
+    EPD_PLANE_RED
+} EpdPlaneKind;
+
+// command: starts the plane, inverted: framebuffer bits are sent inverted,
+// blank: byte sent outside a window
+template <typename Panel, EpdPlaneKind Kind>
+struct EpdPlane;
+
+template <typename Panel>
+class EpdPanel : public EpdIf {
+public:
+    static const unsigned long rowBytes = Panel::width / 8;
+
+    int Init(void) {
+        if (IfInit() != 0) {
+            return -1;
+        }
+        Reset();
+        SendSteps(Panel::initSteps, sizeof(Panel::initSteps) / sizeof(EpdStep));
+        return 0;
+    }
+
+    void SendCommand(unsigned char command) {
+        DigitalWrite(DC_PIN, LOW);
+        SpiTransfer(command);
+    }
+
+    void SendData(unsigned char data) {
+        DigitalWrite(DC_PIN, HIGH);
+        SpiTransfer(data);
+    }
+
+    void SendSteps(const EpdStep* steps, unsigned int count) {
+        for (unsigned int i = 0; i < count; i++) {
+            SendCommand(steps[i].command);
+            if (steps[i].length > 0) {
+                DigitalWrite(DC_PIN, HIGH);
+                SpiWrite(steps[i].data, steps[i].length);
+            }
+            if (steps[i].flags & EPD_STEP_WAIT) {
+                DelayMs(timings.commandSettle);
+                WaitUntilIdle();
+            }
+        }
+    }
+
+    /**
+     *  @brief: Wait until BUSY reaches the idle level of the panel.
+     *          The CPU sleeps until the BUSY interrupt instead of polling.
+     */
+    void WaitUntilIdle(void) {
+        unsigned long startMillis = millis();
+        if (Panel::statusCommand != 0) {
+            SendCommand(Panel::statusCommand);
+        }
+        if (!WaitForLevel(BUSY_PIN, Panel::busyIdleLevel, BUSY_TIMEOUT_MS)) {
+            log_printf("e-Paper busy timeout\n");
+        }
+        DelayMs(timings.idleSettle);
+        lastWaitMillis = millis() - startMillis;
+        totalWaitMillis += lastWaitMillis;
+        numberOfWaits++;
+        log_printf("e-Paper busy for %lu ms\n", lastWaitMillis);
+    }
+
+    /**
+     *  @brief: module reset.
+     *          often used to awaken the module in deep sleep,
+     *          see Sleep();
+     */
+    void Reset(void) {
+        DigitalWrite(RST_PIN, HIGH);
+        DelayMs(timings.resetHigh);
+        DigitalWrite(RST_PIN, LOW);
+        DelayMs(timings.resetLow);
+        DigitalWrite(RST_PIN, HIGH);
+        DelayMs(timings.resetRecovery);
+        WaitForLevel(BUSY_PIN, Panel::busyIdleLevel, BUSY_TIMEOUT_MS);
+    }
+
+    /**
+     *  @brief: Whole plane, width x height bits.
+     */
+    template <EpdPlaneKind Kind>
+    void WritePlane(const unsigned char* buffer) {
+        SendCommand(EpdPlane<Panel, Kind>::command);
+        StreamRows<Kind>(buffer, Panel::height);
+    }
+
+    /**
+     *  @brief: Full-width rows from yStart, the other rows are blank.
+     */
+    template <EpdPlaneKind Kind>
+    void WriteRows(const unsigned char* buffer, unsigned long yStart, unsigned long rows) {
+        SendCommand(EpdPlane<Panel, Kind>::command);
+        DigitalWrite(DC_PIN, HIGH);
+        SpiFill(EpdPlane<Panel, Kind>::blank, yStart * rowBytes);
+        StreamRows<Kind>(buffer, rows);
+        SpiFill(EpdPlane<Panel, Kind>::blank, (Panel::height - yStart - rows) * rowBytes);
+    }
+
+    /**
+     *  @brief: A window of Picture_Width x Picture_Height bits at xStart, yStart.
+     *          xStart and Picture_Width are multiples of 8. Each row of the
+     *          window is put into a blank row and written with one transfer.
+     */
+    template <EpdPlaneKind Kind>
+    void WriteWindow(const unsigned char* pbuffer, unsigned long xStart, unsigned long yStart,
+                     unsigned long Picture_Width, unsigned long Picture_Height) {
+        if (xStart % 8 != 0 || Picture_Width % 8 != 0 || xStart + Picture_Width > Panel::width || yStart + Picture_Height > Panel::height) {
+            log_printf("e-Paper window out of the panel\n");
+            return;
+        }
+        if (xStart == 0 && Picture_Width == Panel::width) {
+            WriteRows<Kind>(pbuffer, yStart, Picture_Height);
+            return;
+        }
+        SendCommand(EpdPlane<Panel, Kind>::command);
+        DigitalWrite(DC_PIN, HIGH);
+        SpiFill(EpdPlane<Panel, Kind>::blank, yStart * rowBytes);
+        unsigned char row[Panel::width / 8];
+        memset(row, EpdPlane<Panel, Kind>::blank, sizeof(row));
+        unsigned long windowBytes = Picture_Width / 8;
+        for (unsigned long j = 0; j < Picture_Height; j++) {
+            CopyRow<Kind>(row + xStart / 8, pbuffer + j * windowBytes, windowBytes);
+            SpiWrite(row, sizeof(row));
+        }
+        SpiFill(EpdPlane<Panel, Kind>::blank, (Panel::height - yStart - Picture_Height) * rowBytes);
+    }
+
+    void Refresh(void) {
+        SendSteps(Panel::refreshSteps, sizeof(Panel::refreshSteps) / sizeof(EpdStep));
+    }
+
+    /**
+     *  @brief: Waveshare interface. Block 0 is the black plane, block 1 the
+     *          red plane, which also starts the refresh.
+     */
+    void Displaypart(const unsigned char* pbuffer, unsigned long xStart, unsigned long yStart,
+                     unsigned long Picture_Width, unsigned long Picture_Height, unsigned char Block) {
+        if (Block == 0) {
+            WriteWindow<EPD_PLANE_BLACK>(pbuffer, xStart, yStart, Picture_Width, Picture_Height);
+        } else {
+            WriteWindow<EPD_PLANE_RED>(pbuffer, xStart, yStart, Picture_Width, Picture_Height);
+            Refresh();
+        }
+    }
+
+    /**
+     *  @brief: After this the chip is in deep sleep until a hardware reset,
+     *          see Reset();
+     */
+    void Sleep(void) {
+        SendSteps(Panel::sleepSteps, sizeof(Panel::sleepSteps) / sizeof(EpdStep));
+    }
+
+private:
+    template <EpdPlaneKind Kind>
+    void StreamRows(const unsigned char* buffer, unsigned long rows) {
+        DigitalWrite(DC_PIN, HIGH);
+        if (!EpdPlane<Panel, Kind>::inverted) {
+            SpiWrite(buffer, rows * rowBytes);
+            return;
+        }
+        unsigned char block[EPD_STREAM_ROWS * Panel::width / 8];
+        for (unsigned long j = 0; j < rows; j += EPD_STREAM_ROWS) {
+            unsigned long length = (rows - j < EPD_STREAM_ROWS ? rows - j : EPD_STREAM_ROWS) * rowBytes;
+            PCFrameKernels::invert(block, buffer + j * rowBytes, length);
+            SpiWrite(block, length);
+        }
+    }
+
+    template <EpdPlaneKind Kind>
+    void CopyRow(unsigned char* destination, const unsigned char* source, unsigned long length) {
+        if (EpdPlane<Panel, Kind>::inverted) {
+            PCFrameKernels::invert(destination, source, length);
+        } else {
+            memcpy(destination, source, length);
+        }
+    }
+};
+
+#endif /* EPDPANEL_H */
+
+/* END OF FILE */
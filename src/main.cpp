@@ -6,6 +6,7 @@
 #include "SD_MMC.h"
 
 #include <vector>
+#include <algorithm>
 #include <map>
 #include <time.h>
 #include <WiFi.h>
@@ -16,6 +17,20 @@
 #include <LovyanGFX.hpp>
 
 #include "PCEvent.h"
+#include "PCWiFi.h"
+#include "PCConnection.h"
+#include "PCSettings.h"
+#include "PCScheduler.h"
+#include "PCArena.h"
+#include "PCMetrics.h"
+#include "PCBudget.h"
+#include "PCFrameStore.h"
+#include "PCLog.h"
+#include "PCMemoryPhase.h"
+#include "PCHoliday.h"
+#include "PCFrameKernels.h"
+#include "PCClock.h"
+#include "PCTaskGraph.h"
 #include "epd7in5b_V2.h"
 
 
@@ -36,6 +51,16 @@
 #define FOOTER_HEIGHT 20
 #define COLUMN_WIDTH 114
 #define DAY_HEIGHT 34
+#define EVENT_HEIGHT 13
+#define AGENDA_DAYS 14
+#define AGENDA_COLUMN_WIDTH 400
+#define MONTH_EVENTS_PER_DAY 3
+#define SECONDS_IN_DAY 86400
+#define OFFLINE_MIDNIGHT_MARGIN 60
+#define UNKNOWN_TIME_SLEEP_SECONDS 3600 // retry after a failure before the clock was ever set
+#define FRAMEBUFFER_MARGIN 16384 // heap left for drawing and the SPI driver
+#define NETWORK_CORE 0 // WiFi and lwIP run on this core
+#define APP_CORE 1
 
 #define WHITE 255
 #define BLACK 0
@@ -43,19 +68,21 @@
 #define LARGE_FONT FreeSansBold18pt7b
 #define SMALL_FONT efontJA_12
 
-#define uS_TO_S_FACTOR 1000000ULL
-
 #define prefName "PaperCal"
 #define holidayCacheKey "Holiday"
-#define bootCountKey "Boot"
 
-String pemFileName = "/root_ca.pem";
-std::vector<String> iCalendarURLs;
-String iCalendarHolidayURL;
-String rootCA = "";
+PCSettings settings;
+boolean sdMounted = false;
 boolean loaded = false;
 boolean loginScreen = false;
-float timezone = 0;
+boolean wokeByTimer = false;
+boolean needsSD = false;
+boolean needsWiFi = false;
+boolean panelAwake = false;
+boolean drawingSkipped = false;
+boolean holidaysLoaded = false;
+int sleepSeconds = 0;
+String footerStatus = "";
 
 int currentYear = 0;
 int currentMonth = 0;
@@ -64,134 +91,224 @@ int nextMonth = 0;
 String dateString = "";
 
 Preferences pref;
-int bootCount;
+String holidayCache = "";
+RTC_DATA_ATTR int bootCount = 0;
+RTC_DATA_ATTR uint32_t lastRenderedDate = 0;
+RTC_DATA_ATTR uint32_t wakeCount = 0;
+RTC_DATA_ATTR uint32_t skippedWakeCount = 0;
+RTC_DATA_ATTR time_t lastOnlineTime = 0;
+RTC_DATA_ATTR uint32_t offlineWakeCount = 0;
+RTC_DATA_ATTR uint64_t lastFrameHash = 0;
 
 LGFX_Sprite blackSprite;
 LGFX_Sprite redSprite;
+Epd epd;
+int epdInitResult = 0;
 
+boolean mountSD();
+boolean loadSettings(boolean timerWake);
 void showCalendar();
-void loadICalendar(String urlString, boolean holiday);
+boolean startSD();
+boolean startWiFi();
+boolean startPanel();
+boolean initPanel();
+boolean loadFeeds();
+boolean drawCalendar();
+boolean showFrame();
+void renderCalendar(int year, int month, int day, String footer);
+boolean createFramebuffers();
+boolean displayFrame();
+boolean showStoredFrame(boolean timerWake);
+void prerenderFrames(int year, int month, int day, String footer);
+void drawMonth(int year, int month, int day);
+void drawWeek(int year, int month, int day);
+void drawAgenda(int year, int month, int day);
+int eventsShownPerDay();
+std::vector<PCEvent> eventsForDay(time_t dayStart);
+void drawEvent(PCEvent &event, time_t dayStart, int x, int y, int width, boolean isFirstColumn);
 uint32_t readVoltage();
-void logLine(String line);
 void shutdown(int wakeUpSeconds);
 
 void setup()
 {
   // put your setup code here, to run once:
-  blackSprite.setColorDepth(1);
-  blackSprite.createSprite(EPD_WIDTH, EPD_HEIGHT);
-  blackSprite.setTextWrap(false);
+  PCMetrics::mark("boot");
+  PCMemoryPhase::enter(PHASE_BOOT);
 
-  redSprite.setColorDepth(1);
-  redSprite.createSprite(EPD_WIDTH, EPD_HEIGHT);
-  redSprite.setTextWrap(false);
+  // Framebuffers are created after the network phase, see createFramebuffers()
+  size_t frameSize = EPD_WIDTH * EPD_HEIGHT / 8;
+  if (psramFound())
+    PCMemoryPhase::setBudget(PHASE_RENDER, frameSize * 2, frameSize, true);
+  else
+    PCMemoryPhase::setBudget(PHASE_RENDER, frameSize * 2 + FRAMEBUFFER_MARGIN, frameSize, false);
 
-  // SD Card
-  SD_MMC.setPins(SD_MMC_CLK, SD_MMC_CMD, SD_MMC_D0);
-  if (!SD_MMC.begin("/sdcard", true, true, SDMMC_FREQ_DEFAULT, 5))
+  // Parse-time data goes to one block. Internal RAM is taken after the
+  // network phase, see drawCalendar(), so TLS does not run without it
+  if (psramFound())
   {
-    log_printf("Card Mount Failed\n");
+    PCArena::begin();
+    PCMetrics::mark("arena");
+  }
+
+  esp_sleep_wakeup_cause_t wakeupCause = esp_sleep_get_wakeup_cause();
+  boolean timerWake = (wakeupCause == ESP_SLEEP_WAKEUP_TIMER);
+  wokeByTimer = timerWake;
+  PCLog::begin();
+
+  pref.begin(prefName, false);
+  PCClock::begin(pref, timerWake);
+  if (!loadSettings(timerWake))
+  {
+    log_printf("Settings not found\n");
+    PCLog::record(LOG_ERROR, LOG_NO_SETTINGS);
     return;
   }
-  uint8_t cardType = SD_MMC.cardType();
-  if (cardType == CARD_NONE)
+  PCLog::setLevel(PCLog::levelFromString(settings.logLevel));
+  PCLog::record(LOG_INFO, LOG_BOOT, wakeupCause, wakeCount);
+  PCEvent::defaultTimezone = settings.timezone;
+  PCEvent::setRootCA(settings.rootCA);
+  PCEvent::setDuplicatePolicy(settings.duplicatePolicy);
+  PCEvent::setEventsPerDay(settings.eventsPerDay > 0 ? settings.eventsPerDay : eventsShownPerDay());
+  PCConnection::setDNSTTL(settings.dnsTTL);
+  EpdIf::lightSleep = (settings.epdLightSleep != "off");
+  Epd::timings.resetHigh = settings.epdResetMs;
+  Epd::timings.resetRecovery = settings.epdResetMs;
+  Epd::timings.idleSettle = settings.epdSettleMs;
+  PCScheduler::configure(PCScheduler::policyFromString(settings.wakePolicy), settings.wakeInterval, settings.maxBackoff, settings.batteryFloor);
+  PCBudget::begin(settings.wakeBudget);
+
+  // Push a frame rendered on an earlier wake without using WiFi
+  if (showStoredFrame(timerWake))
   {
-    log_printf("No SD_MMC card attached\n");
     return;
   }
 
-  // Load settings from "settings.txt" in SD card
-  String wifiIDString = "wifiID";
-  String wifiPWString = "wifiPW";
+  // Holidays cache is applied once the current month is known, a cached month needs no WiFi
+  holidayCache = timerWake ? pref.getString(holidayCacheKey, "") : "";
 
-  File settingFile = SD_MMC.open("/settings.txt");
-  if (settingFile)
+  // "file:" sources are read from SD card, the others need WiFi when they are due.
+  // Holidays computed from rules or cached for this month need no source at all.
+  time_t now = PCClock::now();
+  boolean clockIsSet = (now >= MIN_VALID_TIME);
+  uint32_t month = PCFeedCache::monthOfTime(now + (time_t)(settings.timezone * 3600));
+  String holidayURL = PCHoliday::setRules(settings.holidayRules) ? "" : settings.holidayURL;
+  if (clockIsSet && holidayCache.startsWith(String(month)))
+  {
+    holidayURL = "";
+  }
+  boolean hasFileSource = PCEvent::isFileURL(holidayURL);
+  boolean hasRemoteSource = !holidayURL.isEmpty() && !hasFileSource;
+  for (auto &feed : settings.feeds)
   {
-    while (settingFile.available() > 0)
+    if (PCEvent::isFileURL(feed.url))
     {
-      String line = settingFile.readStringUntil('\n');
-      if (line.startsWith("//"))
-        continue;
-      int separatorLocation = line.indexOf(":");
-      if (separatorLocation > -1)
-      {
-        String key = line.substring(0, separatorLocation);
-        String content = line.substring(separatorLocation + 1);
-
-        // WiFi SSID and paassword
-        if (key == "SSID")
-          wifiIDString = content;
-
-        else if (key == "PASS")
-          wifiPWString = content;
-
-        // HTTPS access
-        else if (key == "pemFileName")
-          pemFileName = content;
-
-        else if (key == "iCalendarURL")
-          iCalendarURLs.push_back(content);
-
-        else if (key == "holidayURL")
-          iCalendarHolidayURL = content;
-
-        else if (key == "timezone")
-          timezone = content.toFloat();
-          PCEvent::defaultTimezone = timezone;
-      }
+      hasFileSource = true;
+      continue;
     }
-    settingFile.close();
+    // Due feeds may write their copy, the others read it
+    boolean due = !clockIsSet || PCFeedCache::isDue(feed, now, month);
+    if (due)
+      hasRemoteSource = true;
+    if (due ? PCFeedCache::needsCopy(feed, now, month) : PCFeedCache::hasCopy(feed, month))
+      hasFileSource = true;
+  }
+  // SD card and WiFi start together in showCalendar(), a feed that falls
+  // back on its copy mounts SD card then
+  PCEvent::setMountFunction(mountSD);
+  needsSD = hasFileSource;
+  needsWiFi = hasRemoteSource;
 
-    // Start Wifi connection
-    WiFi.begin(wifiIDString.c_str(), wifiPWString.c_str());
-    // Wait until wifi connected
-    int i = 0;
-    while (WiFi.status() != WL_CONNECTED)
-    {
-      delay(500);
-      log_printf(".");
-      i++;
-      if (i > 120)
-        break;
-    }
-    log_printf("\n");
+  // Boot count
+  bootCount = timerWake ? bootCount + 1 : 0;
 
+  pinMode(LED_BUILTIN, OUTPUT);
+  pinMode(VOLTAGE_TEST, OUTPUT);
+  pinMode(VOLTAGE_READ, ANALOG);
+}
 
-    // Load PEM file in SD card
-    File pemFile = SD_MMC.open(pemFileName.c_str());
-    if (pemFile)
-    {
-      PCEvent::setRootCA(pemFile.readString());
-      pemFile.close();
-      log_printf("pem file loaded:%s\n", pemFileName.c_str());
-    }
+boolean mountSD()
+{
+  if (sdMounted)
+    return true;
+  SD_MMC.setPins(SD_MMC_CLK, SD_MMC_CMD, SD_MMC_D0);
+  if (!SD_MMC.begin("/sdcard", true, true, SDMMC_FREQ_DEFAULT, 5))
+  {
+    log_printf("Card Mount Failed\n");
+    return false;
+  }
+  uint8_t cardType = SD_MMC.cardType();
+  if (cardType == CARD_NONE)
+  {
+    log_printf("No SD_MMC card attached\n");
+    return false;
+  }
+  sdMounted = true;
+  return true;
+}
 
-        // Load Holidays cache for this month
-    pref.begin(prefName, false);
-    PCEvent::setHolidayCacheString(pref.getString(holidayCacheKey, ""));
-    bootCount = pref.getInt(bootCountKey, 0);
-    pref.end();
+boolean loadSettings(boolean timerWake)
+{
+  // Timer wakes use the compiled snapshot only
+  if (timerWake && settings.loadSnapshot(pref))
+  {
+    log_printf("Settings loaded from snapshot\n");
+    return true;
+  }
+  if (!mountSD())
+  {
+    return settings.loadSnapshot(pref);
+  }
 
-    // Boot count
-    esp_sleep_wakeup_cause_t wakeupCause = esp_sleep_get_wakeup_cause();
-    switch (wakeupCause)
-    {
-    case ESP_SLEEP_WAKEUP_TIMER:
-    {
-      bootCount++;
-      break;
-    }
-    default:
-    {
-      bootCount = 0;
-    PCEvent::setHolidayCacheString("");
-    }
-    }
+  // Load settings from "settings.txt" in SD card unless the snapshot is up to date
+  PCSettings snapshot;
+  boolean hasSnapshot = snapshot.loadSnapshot(pref);
+  File settingFile = SD_MMC.open("/settings.txt");
+  if (!settingFile)
+  {
+    settings = snapshot;
+    return hasSnapshot;
+  }
+  File pemFile = SD_MMC.open(hasSnapshot ? snapshot.pemFileName.c_str() : settings.pemFileName.c_str());
+  File holidayFile = SD_MMC.exists(HOLIDAY_OVERRIDE_FILE) ? SD_MMC.open(HOLIDAY_OVERRIDE_FILE) : File();
+  if (hasSnapshot && snapshot.fingerprint == PCSettings::fingerprintOfFiles(settingFile, pemFile, holidayFile))
+  {
+    settingFile.close();
+    pemFile.close();
+    holidayFile.close();
+    settings = snapshot;
+    log_printf("Settings snapshot is up to date\n");
+    return true;
+  }
 
-    pinMode(LED_BUILTIN, OUTPUT);
-    pinMode(VOLTAGE_TEST, OUTPUT);
-    pinMode(VOLTAGE_READ, ANALOG);
+  settings.loadFromFile(settingFile);
+  if (hasSnapshot && snapshot.pemFileName != settings.pemFileName)
+  {
+    pemFile.close();
+    pemFile = SD_MMC.open(settings.pemFileName.c_str());
+  }
+
+  // Load PEM file in SD card
+  if (pemFile)
+  {
+    pemFile.seek(0);
+    settings.loadRootCA(pemFile);
+    log_printf("pem file loaded:%s\n", settings.pemFileName.c_str());
   }
+  else
+  {
+    log_printf("pem file not found:%s, https feeds are not fetched\n", settings.pemFileName.c_str());
+  }
+  // Load one-off holiday changes in SD card
+  if (holidayFile)
+  {
+    settings.loadHolidayOverrides(holidayFile);
+  }
+  settings.fingerprint = PCSettings::fingerprintOfFiles(settingFile, pemFile, holidayFile);
+  settingFile.close();
+  pemFile.close();
+  holidayFile.close();
+  settings.saveSnapshot(pref);
+  return true;
 }
 
 void loop()
@@ -201,7 +318,8 @@ void loop()
   {
     digitalWrite(LED_BUILTIN, HIGH);
     showCalendar();
-    log_printf("Free heap size: %d bytes\n", esp_get_free_heap_size());
+    PCMetrics::mark("end");
+    PCMetrics::report();
     loaded = true;
     delay(1000);
     digitalWrite(LED_BUILTIN, LOW);
@@ -209,39 +327,448 @@ void loop()
 }
 
 void showCalendar()
+{
+  // A new day always changes the frame, so the panel can power up while feeds load
+  time_t now = PCClock::now();
+  time_t localNow = now + (time_t)(settings.timezone * 3600);
+  tm today;
+  gmtime_r(&localNow, &today);
+  uint32_t todayDate = (today.tm_year + 1900) * 10000 + (today.tm_mon + 1) * 100 + today.tm_mday;
+  boolean newDay = (now >= MIN_VALID_TIME && todayDate != lastRenderedDate);
+
+  // Every failure below sleeps until this wake, drawCalendar() replaces it
+  // with the scheduled one
+  uint32_t fallbackVoltage = settings.batteryFloor > 0 ? readVoltage() : 0;
+  sleepSeconds = (now >= MIN_VALID_TIME) ? PCScheduler::fallbackWakeSeconds(today, fallbackVoltage) : UNKNOWN_TIME_SLEEP_SECONDS;
+
+  // Steps of the wake and what each waits for
+  PCTaskGraph::clear();
+  int sdTask = needsSD ? PCTaskGraph::add("sd", startSD, 0, APP_CORE) : GRAPH_NO_TASK;
+  int wifiTask = needsWiFi ? PCTaskGraph::add("connect", startWiFi, 0, NETWORK_CORE) : GRAPH_NO_TASK;
+  int feedsTask = PCTaskGraph::add("feeds", loadFeeds, PCTaskGraph::bit(sdTask) | PCTaskGraph::bit(wifiTask), APP_CORE);
+  int panelTask = PCTaskGraph::add("panel", startPanel, newDay ? 0 : PCTaskGraph::bit(feedsTask), NETWORK_CORE);
+  int drawTask = PCTaskGraph::add("draw", drawCalendar, PCTaskGraph::bit(feedsTask), APP_CORE);
+  int displayTask = PCTaskGraph::add("display", showFrame, PCTaskGraph::bit(drawTask) | PCTaskGraph::bit(panelTask), APP_CORE);
+  PCTaskGraph::run();
+  PCTaskGraph::report();
+
+  // A panel started for a frame that was not shown sleeps again
+  if (panelAwake)
+  {
+    epd.Sleep();
+    panelAwake = false;
+  }
+
+  // Skip parsing and drawing when no feed changed since this day was drawn
+  struct tm timeinfo = PCEvent::currentTimeinfo;
+  int year = PCEvent::currentYear;
+  int month = PCEvent::currentMonth;
+  int day = PCEvent::currentDay;
+  if (drawingSkipped)
+  {
+    log_printf("Feeds unchanged, drawing skipped (%u of %u wakes)\n", skippedWakeCount, wakeCount);
+    PCLog::record(LOG_INFO, LOG_SKIP, skippedWakeCount, wakeCount);
+    uint32_t voltage = settings.batteryFloor > 0 ? readVoltage() : 0;
+    lastOnlineTime = PCClock::now();
+    PCEvent::releaseEvents();
+    PCArena::release();
+    loaded = true;
+    shutdown(PCScheduler::nextWakeSeconds(timeinfo, false, voltage));
+    return;
+  }
+  if (PCTaskGraph::state(drawTask) != GRAPH_DONE)
+  {
+    PCEvent::releaseEvents();
+    PCArena::release();
+    loaded = true;
+    shutdown(sleepSeconds);
+    return;
+  }
+  if (PCTaskGraph::state(displayTask) != GRAPH_DONE)
+  {
+    if (PCTaskGraph::state(panelTask) == GRAPH_FAILED)
+    {
+      PCLog::record(LOG_ERROR, LOG_EPD_FAILED, epdInitResult);
+      Serial.print("e-Paper init failed");
+    }
+    // The panel is tried again on the next wake instead of staying awake
+    PCEvent::releaseEvents();
+    PCArena::release();
+    loaded = true;
+    shutdown(sleepSeconds);
+    return;
+  }
+  lastRenderedDate = year * 10000 + month * 100 + day;
+  lastOnlineTime = PCClock::now();
+
+  // Later days are rendered now, so their wakes can skip WiFi
+  if (settings.prerenderDays > 0 && mountSD())
+  {
+    char footerBuffer[48];
+    sprintf(footerBuffer, "Rendered %d/%d/%d %02d:%02d", year, month, day, timeinfo.tm_hour, timeinfo.tm_min);
+    prerenderFrames(year, month, day, String(footerBuffer));
+    PCMetrics::mark("prerender");
+  }
+
+  // Events are no longer needed once they are drawn
+  log_printf("Arena: peak %u of %u bytes (%u over all wakes), %d allocations, %u bytes overflowed\n",
+             (unsigned int)PCArena::highWaterMark(), (unsigned int)PCArena::capacity(), (unsigned int)PCArena::highWaterMarkOfAllWakes(),
+             PCArena::numberOfAllocations(), (unsigned int)PCArena::overflowBytes());
+  PCLog::record(LOG_VERBOSE, LOG_ARENA, PCArena::highWaterMark(), PCArena::capacity(), PCArena::numberOfAllocations(), PCArena::overflowBytes());
+  PCEvent::releaseEvents();
+  PCArena::release();
+
+  // Deep sleep
+  loaded = true;
+  digitalWrite(LED_BUILTIN, LOW);
+  delay(1000);
+  shutdown(sleepSeconds);
+}
+
+// The steps below run as tasks of the graph in showCalendar().
+// Steps that may overlap (sd, wifi, panel and then feeds, draw with panel)
+// touch separate hardware and state, the others are ordered by dependencies.
+
+boolean startSD()
+{
+  // Remote feeds still load without their copies
+  mountSD();
+  return true;
+}
+
+boolean startWiFi()
+{
+  PCMemoryPhase::enter(PHASE_NETWORK);
+  if (!settings.staticIP.isEmpty())
+  {
+    PCWiFi::setStaticIP(settings.staticIP, settings.gateway, settings.subnet, settings.dns);
+  }
+  PCBudget::startPhase(BUDGET_PHASE_WIFI, 0, settings.wifiBudget);
+  boolean connected = PCWiFi::connect(settings.wifiID, settings.wifiPW, wokeByTimer, PCBudget::remainingMillis());
+  PCBudget::endPhase(0);
+  if (connected)
+  {
+    PCClock::startSNTP(settings.ntpServer);
+  }
+  PCMetrics::mark("wifi");
+  PCLog::record(LOG_INFO, LOG_WIFI, PCWiFi::lastConnectMillis(), PCWiFi::lastConnectWasFast(), connected);
+  // Feeds that can not be fetched fall back to their copies
+  return true;
+}
+
+// Runs beside the network tasks, so BUSY is waited for without light sleep,
+// which would stop the other core and the radio as well
+boolean startPanel()
+{
+  EpdIf::tasksRunning = true;
+  boolean started = initPanel();
+  EpdIf::tasksRunning = false;
+  return started;
+}
+
+// Reset and power settings take 400 ms and more before the first plane can be sent
+boolean initPanel()
+{
+  epdInitResult = epd.Init();
+  if (epdInitResult != 0)
+  {
+    log_printf("e-Paper init failed: %d", epdInitResult);
+    return false;
+  }
+  panelAwake = true;
+  return true;
+}
+
+// Returns false when drawing can be skipped
+boolean loadFeeds()
 {
   // Load iCalendar
-  for (auto &urlString : iCalendarURLs)
+  int feedIndex = 0;
+  for (auto &feed : settings.feeds)
   {
-    PCEvent::loadICalendar(urlString, false);
+    unsigned long feedStart = millis();
+    PCBudget::startPhase(BUDGET_PHASE_FEED, feedIndex, feed.budgetSeconds > 0 ? feed.budgetSeconds : settings.feedBudget);
+    boolean feedLoaded = PCEvent::loadFeed(feed);
+    PCBudget::endPhase(PCEvent::lastFeedBytes());
+    PCMetrics::mark("feed");
+    PCLog::record(LOG_VERBOSE, LOG_FEED, feedIndex++, feedLoaded, millis() - feedStart);
   }
   // Load iCalendar for holidays
-  if (!PCEvent::isCacheValid() && !iCalendarHolidayURL.isEmpty())
+  holidaysLoaded = false;
+  if (PCHoliday::setRules(settings.holidayRules))
   {
-    PCEvent::loadICalendar(iCalendarHolidayURL, true);
-    pref.begin(prefName, false);
-    pref.putString(holidayCacheKey, PCEvent::holidayCacheString());
-    pref.end();
+    PCHoliday::setOverrides(settings.holidayOverrides);
+    PCEvent::addRuleHolidays();
+  }
+  else
+  {
+    PCEvent::setHolidayCacheString(holidayCache);
+  }
+  if (!PCEvent::isCacheValid() && !settings.holidayURL.isEmpty())
+  {
+    PCBudget::startPhase(BUDGET_PHASE_HOLIDAYS, 0, settings.feedBudget);
+    holidaysLoaded = PCEvent::loadICalendar(settings.holidayURL, true);
+    PCBudget::endPhase(PCEvent::lastFeedBytes());
+    PCMetrics::mark("holidays");
   }
 
+  PCConnection::closeAll();
+  log_printf("TLS handshakes: %d (%lu ms), resumed: %d (%lu ms), reused connections: %d, DNS cache hits: %d\n", PCConnection::numberOfHandshakes(), PCConnection::totalHandshakeMillis(), PCConnection::numberOfResumedHandshakes(), PCConnection::totalResumedHandshakeMillis(), PCConnection::numberOfReusedConnections(), PCConnection::numberOfDNSCacheHits());
   WiFi.disconnect(true);
+  PCMetrics::mark("offline");
 
+  uint32_t displayedDate = PCEvent::currentYear * 10000 + PCEvent::currentMonth * 100 + PCEvent::currentDay;
+  wakeCount++;
+  if (PCEvent::feedsUnchanged() && displayedDate == lastRenderedDate)
+  {
+    skippedWakeCount++;
+    drawingSkipped = true;
+    return false;
+  }
+  return true;
+}
 
-  // Get local time
+// Returns false when the framebuffers can not be allocated
+boolean drawCalendar()
+{
   struct tm timeinfo = PCEvent::currentTimeinfo;
   int year = PCEvent::currentYear;
   int month = PCEvent::currentMonth;
   int day = PCEvent::currentDay;
 
+  PCMemoryPhase::enter(PHASE_PARSE);
+  PCArena::begin();
+  PCEvent::buildEvents();
+  PCMetrics::mark("build");
+  PCLog::record(LOG_INFO, LOG_BUILD, PCEvent::numberOfEventsInThisMonth(), PCEvent::numberOfDuplicates(), PCEvent::numberOfChangedFeeds(), PCEvent::numberOfOverflowEvents());
+  if (holidaysLoaded)
+  {
+    String newHolidayCache = PCEvent::holidayCacheString();
+    if (newHolidayCache != holidayCache)
+    {
+      pref.putString(holidayCacheKey, newHolidayCache);
+    }
+  }
+
+  // Log date
+  char logBuffer[32];
+  sprintf(logBuffer, "%d/%d/%d %02d:%02d:%02d", year, month, day, timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+  String logString = String(logBuffer);
+
+  // Log events
+  logString += ", Events:";
+  logString += String(PCEvent::numberOfEventsInThisMonth());
+
+  // Log boot count
+  logString += ", Boot:";
+  logString += String(bootCount);
+
+  // Log skipped wakes
+  logString += ", Skip:";
+  logString += String(skippedWakeCount) + "/" + String(wakeCount);
+
+  // Feeds shown from their copy after a failed or overrun fetch
+  if (PCEvent::numberOfStaleFeeds() > 0)
+  {
+    logString += ", Stale:";
+    logString += String(PCEvent::numberOfStaleFeeds());
+  }
+
+  // Schedule next wake from today's events and feed changes
+  PCScheduler::clearBoundaries();
+  for (auto &event : PCEvent::eventsInDayOfThisMonth(day))
+  {
+    if (!event.isDayEvent() && event.getDay() == day && event.getMonth() == month)
+    {
+      int startSeconds = event.getHour() * 3600 + event.getMinute() * 60;
+      PCScheduler::addBoundary(startSeconds);
+      PCScheduler::addBoundary(startSeconds + (int)event.duration());
+    }
+  }
+  uint32_t voltage = settings.batteryFloor > 0 ? readVoltage() : 0;
+  sleepSeconds = PCScheduler::nextWakeSeconds(timeinfo, !PCEvent::feedsUnchanged(), voltage);
+  logString += ", Next:";
+  logString += PCScheduler::reason();
+  footerStatus = String(PCEvent::numberOfStaleFeeds()) + "/" + PCScheduler::reason();
+
+  // Memory use so far
+  if (settings.metrics == "footer")
+  {
+    logString += ", ";
+    logString += PCMetrics::summary();
+    logString += ", Clock:" + String(PCClock::driftPPM()) + "ppm/" + String(PCClock::lastWakeErrorMillis()) + "ms";
+  }
+
   // Draw calendar
+  if (!createFramebuffers())
+  {
+    return false;
+  }
+  renderCalendar(year, month, day, logString);
+  PCMetrics::mark("draw");
+  if (settings.metrics == "kernels")
+  {
+    PCFrameKernels::benchmark((uint8_t *)blackSprite.getBuffer(), (uint8_t *)redSprite.getBuffer(), EPD_WIDTH / 8, EPD_HEIGHT);
+  }
+  return true;
+}
+
+boolean showFrame()
+{
+  if (!displayFrame())
+  {
+    return false;
+  }
+  PCMetrics::mark("display");
+  return true;
+}
+
+void renderCalendar(int year, int month, int day, String footer)
+{
+  blackSprite.fillScreen(WHITE);
+  redSprite.fillScreen(WHITE);
+  if (settings.layout == "week")
+  {
+    drawWeek(year, month, day);
+  }
+  else if (settings.layout == "agenda")
+  {
+    drawAgenda(year, month, day);
+  }
+  else
+  {
+    drawMonth(year, month, day);
+  }
+
+  // Footer
+  blackSprite.setFont(&fonts::SMALL_FONT);
+  blackSprite.setTextColor(BLACK);
+  blackSprite.setCursor(8, EPD_HEIGHT - FOOTER_HEIGHT);
+  blackSprite.print(footer);
+}
+
+boolean createFramebuffers()
+{
+  if (blackSprite.getBuffer() != NULL)
+    return true;
+  PCMemoryPhase::enter(PHASE_RENDER);
+
+  // Both 1-bit planes take 96 KB, in PSRAM when the module has it
+  boolean inPSRAM = psramFound();
+  blackSprite.setColorDepth(1);
+  blackSprite.setPsram(inPSRAM);
+  redSprite.setColorDepth(1);
+  redSprite.setPsram(inPSRAM);
+  if (blackSprite.createSprite(EPD_WIDTH, EPD_HEIGHT) == NULL || redSprite.createSprite(EPD_WIDTH, EPD_HEIGHT) == NULL)
+  {
+    log_printf("Framebuffers: allocation failed in %s\n", inPSRAM ? "PSRAM" : "internal RAM");
+    blackSprite.deleteSprite();
+    redSprite.deleteSprite();
+    return false;
+  }
+  blackSprite.setTextWrap(false);
+  redSprite.setTextWrap(false);
+  PCMetrics::mark("sprites");
+  return true;
+}
+
+boolean displayFrame()
+{
+  // The time and counters in the footer change on every wake, a refresh is needed
+  // when the body, the stale feed count or the next wake reason does.
+  // Metrics in the footer are shown on every wake.
+  size_t bodyLength = EPD_WIDTH / 8 * (settings.metrics == "footer" ? EPD_HEIGHT : EPD_HEIGHT - FOOTER_HEIGHT);
+  uint64_t frameHash = PCFrameKernels::hash64((uint8_t *)redSprite.getBuffer(), bodyLength);
+  frameHash = PCFrameKernels::hash64((uint8_t *)blackSprite.getBuffer(), bodyLength, frameHash);
+  frameHash = PCFrameKernels::hash64((const uint8_t *)footerStatus.c_str(), footerStatus.length(), frameHash);
+  if (frameHash == lastFrameHash)
+  {
+    log_printf("Frame unchanged, refresh skipped\n");
+    return true;
+  }
+
+  PCMemoryPhase::enter(PHASE_DISPLAY);
+  if (!panelAwake && !initPanel())
+  {
+    PCLog::record(LOG_ERROR, LOG_EPD_FAILED, epdInitResult);
+    Serial.print("e-Paper init failed");
+    return false;
+  }
+  epd.WritePlane<EPD_PLANE_BLACK>((unsigned char *)(blackSprite.getBuffer()));
+  epd.WritePlane<EPD_PLANE_RED>((unsigned char *)(redSprite.getBuffer()));
+  epd.Refresh();
+  epd.Sleep();
+  panelAwake = false;
+  lastFrameHash = frameHash;
+  log_printf("e-Paper waits: %d, %lu ms on BUSY\n", Epd::numberOfWaits, Epd::totalWaitMillis);
+  PCLog::record(LOG_INFO, LOG_DISPLAY, Epd::numberOfWaits, Epd::totalWaitMillis);
+  return true;
+}
+
+boolean showStoredFrame(boolean timerWake)
+{
+  // Offline wakes need the clock kept since the last online wake
+  time_t now = PCClock::now();
+  if (!timerWake || settings.prerenderDays == 0 || lastOnlineTime == 0 || now < MIN_VALID_TIME)
+    return false;
+  if (now - lastOnlineTime >= (time_t)settings.maxStaleness * 3600)
+  {
+    log_printf("Frames are stale, refreshing online\n");
+    return false;
+  }
+  time_t localNow = now + (time_t)(settings.timezone * 3600);
+  tm timeinfo;
+  gmtime_r(&localNow, &timeinfo);
+  uint32_t date = (timeinfo.tm_year + 1900) * 10000 + (timeinfo.tm_mon + 1) * 100 + timeinfo.tm_mday;
+  if (date != lastRenderedDate)
+  {
+    if (!mountSD() || !createFramebuffers() || !PCFrameStore::load(SD_MMC, date, EPD_WIDTH, EPD_HEIGHT, (uint8_t *)blackSprite.getBuffer(), (uint8_t *)redSprite.getBuffer()))
+    {
+      log_printf("No stored frame for %u\n", date);
+      return false;
+    }
+    if (!displayFrame())
+      return false;
+    lastRenderedDate = date;
+    log_printf("Stored frame shown for %u\n", date);
+    PCLog::record(LOG_INFO, LOG_FRAME, date, offlineWakeCount + 1);
+  }
+
+  // Sleep to the next day or until the frames become stale
+  offlineWakeCount++;
+  wakeCount++;
+  int sleepSeconds = SECONDS_IN_DAY - (timeinfo.tm_hour * 3600 + timeinfo.tm_min * 60 + timeinfo.tm_sec) + OFFLINE_MIDNIGHT_MARGIN;
+  sleepSeconds = min(sleepSeconds, (int)(lastOnlineTime + settings.maxStaleness * 3600 - now) + 1);
+  log_printf("Offline wake %u, next in %d s\n", offlineWakeCount, sleepSeconds);
+  loaded = true;
+  shutdown(max(sleepSeconds, 60));
+  return true;
+}
+
+void prerenderFrames(int year, int month, int day, String footer)
+{
+  time_t today = timeFromDate(year, month, day);
+  PCFrameStore::removeBefore(SD_MMC, year * 10000 + month * 100 + day);
+  for (int i = 1; i <= (int)settings.prerenderDays; i++)
+  {
+    time_t dayTime = today + i * SECONDS_IN_DAY;
+    tm date;
+    gmtime_r(&dayTime, &date);
+    char dateBuffer[16];
+    sprintf(dateBuffer, "%d/%d/%d, ", date.tm_year + 1900, date.tm_mon + 1, date.tm_mday);
+    renderCalendar(date.tm_year + 1900, date.tm_mon + 1, date.tm_mday, String(dateBuffer) + footer);
+    PCFrameStore::save(SD_MMC, (date.tm_year + 1900) * 10000 + (date.tm_mon + 1) * 100 + date.tm_mday, time(NULL), EPD_WIDTH, EPD_HEIGHT,
+                       (uint8_t *)blackSprite.getBuffer(), (uint8_t *)redSprite.getBuffer());
+  }
+}
+
+void drawMonth(int year, int month, int day)
+{
   int firstDayOfWeek = dayOfWeek(year, month, 1);
   int numberOfDays = numberOfDaysInMonth(year, month);
   int numberOfRows = (firstDayOfWeek + numberOfDays - 1) / 7 + 1;
   int rowHeight = (EPD_HEIGHT - FOOTER_HEIGHT) / numberOfRows;
 
-  blackSprite.fillScreen(WHITE);
-  redSprite.fillScreen(WHITE);
-
   // draw horizontal lines
   for (int i = 1; i <= numberOfRows; i++)
   {
@@ -262,7 +789,8 @@ void showCalendar()
   {
     int row = (firstDayOfWeek + i - 1) / 7;
     int column = (6 + firstDayOfWeek + i) % 7;
-    boolean holiday = (column == 0 || column == 6 || (PCEvent::numberOfHolidaysInDayOfThisMonth(i) > 0)) ? true : false;
+    time_t dayStart = timeFromDate(year, month, i);
+    boolean holiday = (column == 0 || column == 6 || (PCEvent::holidaysInRange(dayStart, dayStart + SECONDS_IN_DAY).size() > 0)) ? true : false;
     selectedSprite = holiday ? &redSprite : &blackSprite;
 
     // invert color if it is today
@@ -282,81 +810,192 @@ void showCalendar()
     selectedSprite->printf("%d", i);
 
     // draw events
-    std::vector<PCEvent> eventsInToday;
-    auto holidaysInDay = PCEvent::holidaysInDayOfThisMonth(i);
-    eventsInToday.insert(eventsInToday.end(), holidaysInDay.begin(), holidaysInDay.end());
-    auto eventsInDay = PCEvent::eventsInDayOfThisMonth(i);
-    eventsInToday.insert(eventsInToday.end(), eventsInDay.begin(), eventsInDay.end());
-    
-    blackSprite.setFont(&fonts::SMALL_FONT);
-    redSprite.setFont(&fonts::SMALL_FONT);
-    blackSprite.setTextColor(BLACK);
-    redSprite.setTextColor(BLACK);
+    std::vector<PCEvent> eventsInToday = eventsForDay(dayStart);
+
     blackSprite.setClipRect(column * COLUMN_WIDTH, row * rowHeight + DAY_HEIGHT, COLUMN_WIDTH, rowHeight - DAY_HEIGHT);
     redSprite.setClipRect(column * COLUMN_WIDTH, row * rowHeight + DAY_HEIGHT, COLUMN_WIDTH, rowHeight - DAY_HEIGHT);
-    if (eventsInToday.size() > 0)
+    int j = 0;
+    for (auto &event : eventsInToday)
     {
-      int i = 0;
-      for (auto &event : eventsInToday)
-      {
-        selectedSprite = event.isHolidayEvent ? &redSprite : &blackSprite;
-        selectedSprite->setCursor(column * COLUMN_WIDTH + 2, row * rowHeight + DAY_HEIGHT + 13 * i);
-        selectedSprite->print("・" + event.getTitle());
-        i++;
-        if (i >= 3)
-          break;
-      }
+      drawEvent(event, dayStart, column * COLUMN_WIDTH, row * rowHeight + DAY_HEIGHT + EVENT_HEIGHT * j, COLUMN_WIDTH, column == 0);
+      j++;
+      if (j >= MONTH_EVENTS_PER_DAY)
+        break;
     }
     blackSprite.clearClipRect();
     redSprite.clearClipRect();
 
+    // Count of events that did not fit, including those not kept while parsing
+    int hidden = (int)eventsInToday.size() - j + PCEvent::numberOfOverflowEvents(dayStart);
+    if (hidden > 0)
+    {
+      char more[8];
+      sprintf(more, "+%d", hidden);
+      selectedSprite->setFont(&fonts::SMALL_FONT);
+      selectedSprite->setTextColor(dayColor);
+      selectedSprite->setCursor((column + 1) * COLUMN_WIDTH - selectedSprite->textWidth(more) - 3, row * rowHeight + 2);
+      selectedSprite->print(more);
+    }
   }
+}
 
+void drawWeek(int year, int month, int day)
+{
+  const char *weekdayNames[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+  time_t today = timeFromDate(year, month, day);
+  time_t weekStart = today - dayOfWeek(year, month, day) * SECONDS_IN_DAY;
+  int bodyHeight = EPD_HEIGHT - FOOTER_HEIGHT;
 
-  // Log date
-  char logBuffer[32];
-  sprintf(logBuffer, "%d/%d/%d %02d:%02d:%02d", year, month, day, timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
-  String logString = String(logBuffer);
+  blackSprite.drawFastHLine(0, DAY_HEIGHT, EPD_WIDTH, BLACK);
+  blackSprite.drawFastHLine(0, bodyHeight, EPD_WIDTH, BLACK);
+  for (int i = 1; i < 7; i++)
+  {
+    blackSprite.drawFastVLine(i * COLUMN_WIDTH, 0, bodyHeight, BLACK);
+  }
 
-  // Log events
-  logString += ", Events:";
-  logString += String(PCEvent::numberOfEventsInThisMonth());
+  for (int column = 0; column < 7; column++)
+  {
+    time_t dayStart = weekStart + column * SECONDS_IN_DAY;
+    time_t dayTime = dayStart;
+    tm date;
+    gmtime_r(&dayTime, &date);
+    boolean holiday = (column == 0 || column == 6 || PCEvent::holidaysInRange(dayStart, dayStart + SECONDS_IN_DAY).size() > 0);
+    LGFX_Sprite *selectedSprite = holiday ? &redSprite : &blackSprite;
 
-  // Log boot count
-  logString += ", Boot:";
-  logString += String(bootCount);
+    // invert color if it is today
+    uint16_t dayColor = BLACK;
+    if (dayStart == today)
+    {
+      selectedSprite->fillRect(column * COLUMN_WIDTH, 0, COLUMN_WIDTH, DAY_HEIGHT, BLACK);
+      dayColor = WHITE;
+    }
+    char header[16];
+    sprintf(header, "%d/%d %s", date.tm_mon + 1, date.tm_mday, weekdayNames[column]);
+    selectedSprite->setFont(&fonts::SMALL_FONT);
+    selectedSprite->setTextColor(dayColor);
+    selectedSprite->setCursor(column * COLUMN_WIDTH + (COLUMN_WIDTH - selectedSprite->textWidth(header)) / 2, (DAY_HEIGHT - EVENT_HEIGHT) / 2);
+    selectedSprite->print(header);
 
-  // Save boot count
-  pref.begin(prefName, false);
-  pref.putInt(bootCountKey, bootCount);
-  pref.end();
+    // draw events
+    int maxEvents = (bodyHeight - DAY_HEIGHT) / EVENT_HEIGHT;
+    blackSprite.setClipRect(column * COLUMN_WIDTH, DAY_HEIGHT, COLUMN_WIDTH, bodyHeight - DAY_HEIGHT);
+    redSprite.setClipRect(column * COLUMN_WIDTH, DAY_HEIGHT, COLUMN_WIDTH, bodyHeight - DAY_HEIGHT);
+    int j = 0;
+    for (auto &event : eventsForDay(dayStart))
+    {
+      drawEvent(event, dayStart, column * COLUMN_WIDTH, DAY_HEIGHT + 2 + EVENT_HEIGHT * j, COLUMN_WIDTH, column == 0);
+      j++;
+      if (j >= maxEvents)
+        break;
+    }
+    blackSprite.clearClipRect();
+    redSprite.clearClipRect();
+  }
+}
 
-  // Footer
-  // uint32_t voltage = readVoltage();
-  blackSprite.setFont(&fonts::SMALL_FONT);
-  blackSprite.setCursor(8, EPD_HEIGHT - FOOTER_HEIGHT);
-  blackSprite.print(logString);
+void drawAgenda(int year, int month, int day)
+{
+  const char *weekdayNames[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+  time_t today = timeFromDate(year, month, day);
+  int bodyHeight = EPD_HEIGHT - FOOTER_HEIGHT;
+  int linesInColumn = bodyHeight / EVENT_HEIGHT;
+  int line = 0;
 
-  Epd epd;
-  int initResult = epd.Init();
-  if (initResult != 0)
+  blackSprite.drawFastVLine(AGENDA_COLUMN_WIDTH, 0, bodyHeight, BLACK);
+  blackSprite.drawFastHLine(0, bodyHeight, EPD_WIDTH, BLACK);
+  for (int i = 0; i < AGENDA_DAYS; i++)
   {
-    log_printf("e-Paper init failed: %d", initResult);
-    Serial.print("e-Paper init failed");
-    return;
+    time_t dayStart = today + i * SECONDS_IN_DAY;
+    std::vector<PCEvent> events = eventsForDay(dayStart);
+    if (events.empty() && i > 0)
+      continue;
+    if (line % linesInColumn == linesInColumn - 1)
+      line++; // keep a day header with its first event
+    if (line >= linesInColumn * 2)
+      break;
+
+    // draw day header
+    time_t dayTime = dayStart;
+    tm date;
+    gmtime_r(&dayTime, &date);
+    boolean holiday = (date.tm_wday == 0 || date.tm_wday == 6 || PCEvent::holidaysInRange(dayStart, dayStart + SECONDS_IN_DAY).size() > 0);
+    LGFX_Sprite *selectedSprite = holiday ? &redSprite : &blackSprite;
+    int x = (line / linesInColumn) * AGENDA_COLUMN_WIDTH;
+    int y = (line % linesInColumn) * EVENT_HEIGHT;
+    char header[16];
+    sprintf(header, "%d/%d %s", date.tm_mon + 1, date.tm_mday, weekdayNames[date.tm_wday]);
+    selectedSprite->fillRect(x, y, AGENDA_COLUMN_WIDTH, EVENT_HEIGHT, BLACK);
+    selectedSprite->setFont(&fonts::SMALL_FONT);
+    selectedSprite->setTextColor(WHITE);
+    selectedSprite->setCursor(x + 4, y);
+    selectedSprite->print(header);
+    line++;
+
+    // draw events
+    for (auto &event : events)
+    {
+      if (line >= linesInColumn * 2)
+        break;
+      x = (line / linesInColumn) * AGENDA_COLUMN_WIDTH;
+      y = (line % linesInColumn) * EVENT_HEIGHT;
+      drawEvent(event, dayStart, x, y, AGENDA_COLUMN_WIDTH, true);
+      line++;
+    }
   }
-  epd.Displaypart((unsigned char *)(blackSprite.getBuffer()), 0, 0, EPD_WIDTH, EPD_HEIGHT, 0);
-  epd.Displaypart((unsigned char *)(redSprite.getBuffer()), 0, 0, EPD_WIDTH, EPD_HEIGHT, 1);
-  epd.Sleep();
-  
+}
 
-  // Deep sleep
-  loaded = true;
-  digitalWrite(LED_BUILTIN, LOW);
-  delay(1000);
-  shutdown(24 * 3600 - (timeinfo.tm_hour * 3600 + timeinfo.tm_min * 60 + timeinfo.tm_sec) + 300);
+// Events one day can show in the current layout
+int eventsShownPerDay()
+{
+  int bodyHeight = EPD_HEIGHT - FOOTER_HEIGHT;
+  if (settings.layout == "week")
+    return (bodyHeight - DAY_HEIGHT) / EVENT_HEIGHT;
+  if (settings.layout == "agenda")
+    return bodyHeight / EVENT_HEIGHT * 2;
+  return MONTH_EVENTS_PER_DAY;
 }
 
+// Holidays first, then events spanning several days, then by start time
+std::vector<PCEvent> eventsForDay(time_t dayStart)
+{
+  std::vector<PCEvent> eventsInDay = PCEvent::holidaysInRange(dayStart, dayStart + SECONDS_IN_DAY);
+  std::vector<PCEvent> events = PCEvent::eventsInRange(dayStart, dayStart + SECONDS_IN_DAY);
+  std::stable_partition(events.begin(), events.end(), [](const PCEvent &event)
+                        { return event.getEndTime() - event.getStartTime() > SECONDS_IN_DAY; });
+  eventsInDay.insert(eventsInDay.end(), events.begin(), events.end());
+  return eventsInDay;
+}
+
+void drawEvent(PCEvent &event, time_t dayStart, int x, int y, int width, boolean isFirstColumn)
+{
+  LGFX_Sprite *selectedSprite = (event.isHolidayEvent || event.color == FEED_COLOR_RED) ? &redSprite : &blackSprite;
+  selectedSprite->setFont(&fonts::SMALL_FONT);
+  boolean spanning = (event.getEndTime() - event.getStartTime() > SECONDS_IN_DAY);
+  if (spanning)
+  {
+    // Bars fill the whole cell, so they join across days.
+    // The title is repeated at the start of each week row.
+    selectedSprite->fillRect(x, y + 1, width, EVENT_HEIGHT - 1, BLACK);
+    if (event.getStartTime() >= dayStart || isFirstColumn)
+    {
+      selectedSprite->setTextColor(WHITE);
+      selectedSprite->setCursor(x + 2, y);
+      selectedSprite->print(event.getTitle());
+    }
+    selectedSprite->setTextColor(BLACK);
+    return;
+  }
+  selectedSprite->setTextColor(BLACK);
+  selectedSprite->setCursor(x + 2, y);
+  if (!event.isDayEvent() && event.getStartTime() >= dayStart && width > COLUMN_WIDTH)
+  {
+    selectedSprite->print(event.descriptionForDay(true) + " " + event.getTitle());
+  }
+  else
+  {
+    selectedSprite->print("・" + event.getTitle());
+  }
+}
 
 uint32_t readVoltage()
 {
@@ -374,17 +1013,21 @@ uint32_t readVoltage()
   return 0;
 }
 
-void logLine(String line) {
-  File logFile = SD_MMC.open("/log.txt", FILE_APPEND, true);
-  if (logFile)
+void shutdown(int wakeUpSeconds)
+{
+  PCMetrics::mark("sleep");
+  PCLog::record(LOG_INFO, LOG_SLEEP, wakeUpSeconds, millis());
+
+  // One batch per wake, SD card is mounted only when the buffer fills up
+  if (sdMounted || (PCLog::needsFlush() && mountSD()))
   {
-    logFile.println(line);
+    PCLog::flush(SD_MMC);
   }
-  logFile.close();
-}
+  PCMetrics::report();
+  PCClock::save(pref);
+  pref.end();
 
-void shutdown(int wakeUpSeconds)
-{
-  esp_sleep_enable_timer_wakeup(wakeUpSeconds * uS_TO_S_FACTOR);
+  // Counted from the current time info, corrected for the measured drift
+  esp_sleep_enable_timer_wakeup(PCClock::sleepMicros(wakeUpSeconds));
   esp_deep_sleep_start();
 }
\ No newline at end of file
@@ -0,0 +1,312 @@
+#ifndef HOST_ARDUINO_H_INCLUDE
+#define HOST_ARDUINO_H_INCLUDE
+
+// Just enough of Arduino-ESP32 for the host tests of the native environment.
+// Pins, SPI and files live in memory, see HostState, SPI.h and FS.h.
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <sys/time.h>
+#include <vector>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define ANALOG 3
+#define RISING 1
+#define FALLING 2
+#define DEC 10
+#define HEX 16
+
+#define RTC_DATA_ATTR
+#define IRAM_ATTR
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define digitalPinToInterrupt(p) (p)
+
+#define log_printf(...) HostState::log(__VA_ARGS__)
+#define log_i(...) HostState::log(__VA_ARGS__)
+#define log_d(...) HostState::log(__VA_ARGS__)
+#define log_w(...) HostState::log(__VA_ARGS__)
+#define log_e(...) HostState::log(__VA_ARGS__)
+
+using std::max;
+using std::min;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode);
+void detachInterrupt(uint8_t pin);
+bool psramFound();
+
+class String
+{
+public:
+    String() {}
+    String(const char *value) : _value(value != NULL ? value : "") {}
+    String(const std::string &value) : _value(value) {}
+    String(char value) : _value(1, value) {}
+    String(int value, unsigned char base = DEC) : _value(format(base == HEX ? "%x" : "%d", value)) {}
+    String(unsigned int value, unsigned char base = DEC) : _value(format(base == HEX ? "%x" : "%u", value)) {}
+    String(long value, unsigned char base = DEC) : _value(format(base == HEX ? "%lx" : "%ld", value)) {}
+    String(unsigned long value, unsigned char base = DEC) : _value(format(base == HEX ? "%lx" : "%lu", value)) {}
+    String(long long value) : _value(std::to_string(value)) {}
+    String(unsigned long long value) : _value(std::to_string(value)) {}
+    String(float value, unsigned int decimals = 2) : _value(format("%.*f", decimals, value)) {}
+    String(double value, unsigned int decimals = 2) : _value(format("%.*f", decimals, value)) {}
+
+    unsigned int length() const { return _value.size(); }
+    const char *c_str() const { return _value.c_str(); }
+    bool isEmpty() const { return _value.empty(); }
+    bool reserve(unsigned int size)
+    {
+        _value.reserve(size);
+        return true;
+    }
+    char charAt(unsigned int index) const { return index < _value.size() ? _value[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char &operator[](unsigned int index) { return _value[index]; }
+    int indexOf(char c, unsigned int from = 0) const { return position(_value.find(c, from)); }
+    int indexOf(const String &text, unsigned int from = 0) const { return from > _value.size() ? -1 : position(_value.find(text._value, from)); }
+    int lastIndexOf(char c) const { return position(_value.rfind(c)); }
+    String substring(unsigned int begin) const { return begin > _value.size() ? String() : String(_value.substr(begin)); }
+    String substring(unsigned int begin, unsigned int end) const
+    {
+        if (begin > end)
+            std::swap(begin, end);
+        if (begin > _value.size())
+            return String();
+        return String(_value.substr(begin, std::min<size_t>(end, _value.size()) - begin));
+    }
+    bool startsWith(const String &prefix) const { return _value.compare(0, prefix._value.size(), prefix._value) == 0 && _value.size() >= prefix._value.size(); }
+    bool endsWith(const String &suffix) const { return _value.size() >= suffix._value.size() && _value.compare(_value.size() - suffix._value.size(), suffix._value.size(), suffix._value) == 0; }
+    void trim()
+    {
+        size_t begin = 0;
+        size_t end = _value.size();
+        while (begin < end && isspace((unsigned char)_value[begin]))
+            begin++;
+        while (end > begin && isspace((unsigned char)_value[end - 1]))
+            end--;
+        _value = _value.substr(begin, end - begin);
+    }
+    void toUpperCase()
+    {
+        for (auto &c : _value)
+            c = toupper(c);
+    }
+    void toLowerCase()
+    {
+        for (auto &c : _value)
+            c = tolower(c);
+    }
+    long toInt() const { return atol(_value.c_str()); }
+    float toFloat() const { return atof(_value.c_str()); }
+    void replace(const String &from, const String &to)
+    {
+        if (from._value.empty())
+            return;
+        for (size_t at = 0; (at = _value.find(from._value, at)) != std::string::npos; at += to._value.size())
+            _value.replace(at, from._value.size(), to._value);
+    }
+    void remove(unsigned int index, unsigned int count = (unsigned int)-1)
+    {
+        if (index < _value.size())
+            _value.erase(index, count);
+    }
+    bool concat(const char *data, unsigned int length)
+    {
+        _value.append(data, length);
+        return true;
+    }
+    bool concat(const String &other) { return concat(other.c_str(), other.length()); }
+    bool concat(char c) { return concat(&c, 1); }
+    String &operator+=(const String &other)
+    {
+        _value += other._value;
+        return *this;
+    }
+    String &operator+=(const char *other)
+    {
+        _value += other;
+        return *this;
+    }
+    String &operator+=(char other)
+    {
+        _value += other;
+        return *this;
+    }
+    String &operator+=(int other) { return *this += String(other); }
+    String &operator+=(unsigned int other) { return *this += String(other); }
+    String &operator+=(long other) { return *this += String(other); }
+    String &operator+=(unsigned long other) { return *this += String(other); }
+    bool operator==(const String &other) const { return _value == other._value; }
+    bool operator==(const char *other) const { return _value == other; }
+    bool operator!=(const String &other) const { return _value != other._value; }
+    bool operator!=(const char *other) const { return _value != other; }
+    bool operator<(const String &other) const { return _value < other._value; }
+    bool equals(const String &other) const { return _value == other._value; }
+
+private:
+    static int position(size_t at) { return at == std::string::npos ? -1 : (int)at; }
+    static std::string format(const char *format, ...)
+    {
+        char buffer[48];
+        va_list arguments;
+        va_start(arguments, format);
+        vsnprintf(buffer, sizeof(buffer), format, arguments);
+        va_end(arguments);
+        return buffer;
+    }
+
+    std::string _value;
+};
+
+inline String operator+(const String &left, const String &right) { return String(std::string(left.c_str()) + right.c_str()); }
+inline String operator+(const String &left, const char *right) { return left + String(right); }
+inline String operator+(const char *left, const String &right) { return String(left) + right; }
+inline String operator+(const String &left, char right) { return left + String(right); }
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+        size_t written = 0;
+        while (size--)
+            written += write(*buffer++);
+        return written;
+    }
+    size_t print(const String &text) { return write((const uint8_t *)text.c_str(), text.length()); }
+    size_t print(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+    size_t print(int value) { return print(String(value)); }
+    size_t println(const String &text) { return print(text) + print("\n"); }
+    size_t println() { return print("\n"); }
+    size_t printf(const char *format, ...);
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+    unsigned long getTimeout() { return _timeout; }
+    virtual size_t readBytes(uint8_t *buffer, size_t length)
+    {
+        size_t count = 0;
+        for (int c; count < length && (c = read()) >= 0;)
+            buffer[count++] = c;
+        return count;
+    }
+    size_t readBytes(char *buffer, size_t length) { return readBytes((uint8_t *)buffer, length); }
+    String readStringUntil(char terminator);
+    String readString();
+
+private:
+    unsigned long _timeout = 1000;
+};
+
+class HardwareSerial : public Stream
+{
+public:
+    void begin(long) {}
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    size_t write(uint8_t) override { return 1; }
+};
+extern HardwareSerial Serial;
+
+// ESP-IDF and FreeRTOS parts that Arduino.h brings in on ESP32
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef enum
+{
+    ESP_SLEEP_WAKEUP_UNDEFINED,
+    ESP_SLEEP_WAKEUP_TIMER = 4,
+    ESP_SLEEP_WAKEUP_GPIO = 7
+} esp_sleep_source_t;
+typedef enum
+{
+    GPIO_INTR_LOW_LEVEL = 4,
+    GPIO_INTR_HIGH_LEVEL = 5
+} gpio_int_type_t;
+typedef int gpio_num_t;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t microseconds);
+esp_err_t esp_sleep_enable_gpio_wakeup();
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t source);
+esp_err_t esp_light_sleep_start();
+esp_err_t gpio_wakeup_enable(gpio_num_t pin, gpio_int_type_t type);
+esp_err_t gpio_wakeup_disable(gpio_num_t pin);
+
+#define MALLOC_CAP_8BIT 1
+#define MALLOC_CAP_INTERNAL 2
+#define MALLOC_CAP_SPIRAM 4
+void *heap_caps_malloc(size_t size, uint32_t caps);
+void heap_caps_free(void *block);
+void *ps_malloc(size_t size);
+
+typedef void *SemaphoreHandle_t;
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xffffffff
+#define pdMS_TO_TICKS(ms) (ms)
+#define portYIELD_FROM_ISR()
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) (void)(mux)
+#define portEXIT_CRITICAL(mux) (void)(mux)
+SemaphoreHandle_t xSemaphoreCreateBinary();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t *woken);
+
+typedef enum
+{
+    SNTP_SYNC_STATUS_RESET,
+    SNTP_SYNC_STATUS_COMPLETED,
+    SNTP_SYNC_STATUS_IN_PROGRESS
+} sntp_sync_status_t;
+void configTime(long gmtOffset, int daylightOffset, const char *server1, const char *server2 = NULL, const char *server3 = NULL);
+void sntp_set_sync_status(sntp_sync_status_t status);
+int64_t esp_timer_get_time();
+
+// What the tests control and observe
+class HostState
+{
+public:
+    static void reset();
+    static int log(const char *format, ...);
+
+    static bool hasPSRAM;
+    static bool quiet; // drops log_printf output
+    static int pins[64]; // levels written and read, all HIGH after reset()
+};
+
+#endif
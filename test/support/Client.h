@@ -0,0 +1,18 @@
+#ifndef HOST_CLIENT_H_INCLUDE
+#define HOST_CLIENT_H_INCLUDE
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+class Client : public Stream
+{
+public:
+    using Stream::read;
+    virtual int connect(IPAddress address, uint16_t port) = 0;
+    virtual int connect(const char *host, uint16_t port) = 0;
+    virtual int read(uint8_t *buffer, size_t size) = 0;
+    virtual uint8_t connected() = 0;
+    virtual void stop() = 0;
+};
+
+#endif
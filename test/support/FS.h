@@ -0,0 +1,104 @@
+#ifndef HOST_FS_H_INCLUDE
+#define HOST_FS_H_INCLUDE
+
+#include <Arduino.h>
+#include <map>
+#include <memory>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+enum SeekMode
+{
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+namespace fs
+{
+    // Files are shared byte vectors, so a file written and then reopened
+    // reads back what was written
+    class File : public Stream
+    {
+    public:
+        File() {}
+        File(std::shared_ptr<std::vector<uint8_t>> data, const String &path, bool append)
+            : _data(data), _path(path), _position(append ? data->size() : 0) {}
+
+        size_t write(uint8_t c) override { return write(&c, 1); }
+        size_t write(const uint8_t *buffer, size_t size) override
+        {
+            if (!_data)
+                return 0;
+            if (_data->size() < _position + size)
+                _data->resize(_position + size);
+            memcpy(_data->data() + _position, buffer, size);
+            _position += size;
+            return size;
+        }
+        int available() override { return _data ? (int)(_data->size() - _position) : 0; }
+        int read() override { return available() > 0 ? (*_data)[_position++] : -1; }
+        size_t read(uint8_t *buffer, size_t size) { return readBytes(buffer, size); }
+        int peek() override { return available() > 0 ? (*_data)[_position] : -1; }
+        bool seek(uint32_t position, SeekMode mode = SeekSet)
+        {
+            size_t base = mode == SeekSet ? 0 : mode == SeekCur ? _position : size();
+            if (!_data || base + position > _data->size())
+                return false;
+            _position = base + position;
+            return true;
+        }
+        size_t position() const { return _position; }
+        size_t size() const { return _data ? _data->size() : 0; }
+        void close() { _data.reset(); }
+        operator bool() const { return (bool)_data; }
+        const char *path() const { return _path.c_str(); }
+        const char *name() const { return _path.c_str() + _path.lastIndexOf('/') + 1; }
+        time_t getLastWrite() { return 0; }
+        bool isDirectory() { return false; }
+        File openNextFile(const char * = FILE_READ) { return File(); }
+        bool setBufferSize(size_t) { return true; }
+
+    private:
+        std::shared_ptr<std::vector<uint8_t>> _data;
+        String _path;
+        size_t _position = 0;
+    };
+
+    class FS
+    {
+    public:
+        File open(const String &path, const char *mode = FILE_READ, bool create = false)
+        {
+            auto found = _files.find(path.c_str());
+            if (mode[0] == 'r')
+                return found == _files.end() ? File() : File(found->second, path, false);
+            if (found == _files.end() || mode[0] == 'w')
+                found = _files.insert_or_assign(path.c_str(), std::make_shared<std::vector<uint8_t>>()).first;
+            return File(found->second, path, mode[0] == 'a');
+        }
+        bool exists(const String &path) { return _files.count(path.c_str()) > 0; }
+        bool remove(const String &path) { return _files.erase(path.c_str()) > 0; }
+        bool rename(const String &from, const String &to)
+        {
+            auto found = _files.find(from.c_str());
+            if (found == _files.end())
+                return false;
+            _files[to.c_str()] = found->second;
+            _files.erase(found);
+            return true;
+        }
+        bool mkdir(const String &) { return true; }
+        void clear() { _files.clear(); }
+
+    private:
+        std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> _files;
+    };
+}
+
+using fs::File;
+using fs::FS;
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef HOST_IPADDRESS_H_INCLUDE
+#define HOST_IPADDRESS_H_INCLUDE
+
+#include <Arduino.h>
+
+class IPAddress
+{
+public:
+    IPAddress() {}
+    IPAddress(uint32_t address) : _address(address) {}
+    IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth)
+        : _address(first | (second << 8) | (third << 16) | ((uint32_t)fourth << 24)) {}
+    operator uint32_t() const { return _address; }
+    uint8_t operator[](int index) const { return (_address >> (8 * index)) & 0xff; }
+    bool fromString(const String &text)
+    {
+        unsigned int part[4];
+        if (sscanf(text.c_str(), "%u.%u.%u.%u", &part[0], &part[1], &part[2], &part[3]) != 4)
+            return false;
+        _address = part[0] | (part[1] << 8) | (part[2] << 16) | (part[3] << 24);
+        return true;
+    }
+    String toString() const { return String((*this)[0]) + "." + String((*this)[1]) + "." + String((*this)[2]) + "." + String((*this)[3]); }
+
+private:
+    uint32_t _address = 0;
+};
+extern IPAddress INADDR_NONE;
+
+#endif
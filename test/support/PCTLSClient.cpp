@@ -0,0 +1,60 @@
+// PCTLSClient of the native tests, the steps of src/PCTLSClient.cpp taken
+// with the OpenSSL client of WiFiClientSecure.h
+
+#include <openssl/ssl.h>
+
+#include "PCTLSClient.h"
+#include "PCTLSSessions.h"
+
+static uint8_t sessionBuffer[TLS_SESSION_MAX_BYTES];
+
+PCTLSClient::PCTLSClient()
+{
+    _resumed = false;
+}
+
+int PCTLSClient::connect(IPAddress address, uint16_t port, const char *host, const char *rootCA)
+{
+    _resumed = false;
+    setCACert(rootCA);
+    if (!startTLS(address, port, host, rootCA))
+        return fail();
+
+    size_t length = PCTLSSessions::load(host, port, sessionBuffer, sizeof(sessionBuffer));
+    if (length > 0)
+    {
+        const uint8_t *data = sessionBuffer;
+        SSL_SESSION *session = d2i_SSL_SESSION(NULL, &data, length);
+        if (session == NULL || SSL_set_session(_ssl, session) != 1)
+            PCTLSSessions::forget(host, port);
+        SSL_SESSION_free(session);
+    }
+
+    if (!handshake())
+    {
+        PCTLSSessions::forget(host, port);
+        return fail();
+    }
+    _resumed = SSL_session_reused(_ssl);
+
+    SSL_SESSION *session = SSL_get1_session(_ssl);
+    int savedLength = session != NULL ? i2d_SSL_SESSION(session, NULL) : 0;
+    uint8_t *data = sessionBuffer;
+    if (savedLength > 0 && savedLength <= (int)sizeof(sessionBuffer) && i2d_SSL_SESSION(session, &data) == savedLength)
+        PCTLSSessions::save(host, port, sessionBuffer, savedLength);
+    else
+        log_printf("TLS session of %s not saved, %d bytes\n", host, savedLength);
+    SSL_SESSION_free(session);
+    return 1;
+}
+
+int PCTLSClient::fail()
+{
+    stop();
+    return 0;
+}
+
+boolean PCTLSClient::resumed()
+{
+    return _resumed;
+}
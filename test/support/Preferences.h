@@ -0,0 +1,54 @@
+#ifndef HOST_PREFERENCES_H_INCLUDE
+#define HOST_PREFERENCES_H_INCLUDE
+
+#include <Arduino.h>
+#include <map>
+
+// Keys of all namespaces live in one map for the life of the test
+class Preferences
+{
+public:
+    bool begin(const char *, bool = false) { return true; }
+    void end() {}
+    bool isKey(const char *key) { return _values.count(key) > 0; }
+    bool remove(const char *key) { return _values.erase(key) > 0; }
+    bool clear()
+    {
+        _values.clear();
+        return true;
+    }
+    String getString(const char *key, String value = String()) { return isKey(key) ? String(std::string(_values[key].begin(), _values[key].end())) : value; }
+    size_t putString(const char *key, const String &value) { return putBytes(key, value.c_str(), value.length()); }
+    int32_t getInt(const char *key, int32_t value = 0) { return get(key, value); }
+    size_t putInt(const char *key, int32_t value) { return putBytes(key, &value, sizeof(value)); }
+    uint32_t getUInt(const char *key, uint32_t value = 0) { return get(key, value); }
+    size_t putUInt(const char *key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+    float getFloat(const char *key, float value = 0) { return get(key, value); }
+    size_t putFloat(const char *key, float value) { return putBytes(key, &value, sizeof(value)); }
+    size_t getBytesLength(const char *key) { return isKey(key) ? _values[key].size() : 0; }
+    size_t getBytes(const char *key, void *buffer, size_t size)
+    {
+        if (!isKey(key) || _values[key].size() > size)
+            return 0;
+        memcpy(buffer, _values[key].data(), _values[key].size());
+        return _values[key].size();
+    }
+    size_t putBytes(const char *key, const void *buffer, size_t size)
+    {
+        _values[key].assign((const uint8_t *)buffer, (const uint8_t *)buffer + size);
+        return size;
+    }
+
+private:
+    template <typename T>
+    T get(const char *key, T value)
+    {
+        if (getBytesLength(key) == sizeof(value))
+            getBytes(key, &value, sizeof(value));
+        return value;
+    }
+
+    std::map<std::string, std::vector<uint8_t>> _values;
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef HOST_SD_MMC_H_INCLUDE
+#define HOST_SD_MMC_H_INCLUDE
+
+#include <FS.h>
+
+#define SDMMC_FREQ_DEFAULT 20000
+
+typedef enum
+{
+    CARD_NONE,
+    CARD_MMC,
+    CARD_SD,
+    CARD_SDHC
+} sdcard_type_t;
+
+class SDMMCFS : public fs::FS
+{
+public:
+    bool setPins(int, int, int) { return true; }
+    bool begin(const char *, bool, bool, int, uint8_t) { return true; }
+    void end() {}
+    sdcard_type_t cardType() { return CARD_SD; }
+    uint64_t cardSize() { return 0; }
+};
+extern SDMMCFS SD_MMC;
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef HOST_SPI_H_INCLUDE
+#define HOST_SPI_H_INCLUDE
+
+#include <Arduino.h>
+
+#define MSBFIRST 1
+#define SPI_MODE0 0
+#define SPI_COMMAND 0x100 // set on bytes sent while the command pin is LOW
+
+struct SPISettings
+{
+    SPISettings(uint32_t, uint8_t, uint8_t) {}
+};
+
+// Records every byte sent, so the stream of a driver can be compared
+class SPIClass
+{
+public:
+    void begin() {}
+    void beginTransaction(SPISettings) {}
+    void endTransaction() {}
+    uint8_t transfer(uint8_t data)
+    {
+        sent.push_back(data | (commandPin >= 0 && digitalRead(commandPin) == LOW ? SPI_COMMAND : 0));
+        return data;
+    }
+    void writeBytes(const uint8_t *data, uint32_t size)
+    {
+        for (uint32_t i = 0; i < size; i++)
+            transfer(data[i]);
+    }
+    void transferBytes(const uint8_t *data, uint8_t *, uint32_t size) { writeBytes(data, size); }
+
+    int commandPin = -1;
+    std::vector<uint16_t> sent;
+};
+extern SPIClass SPI;
+
+#endif
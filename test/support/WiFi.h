@@ -0,0 +1,62 @@
+#ifndef HOST_WIFI_H_INCLUDE
+#define HOST_WIFI_H_INCLUDE
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <WiFiClient.h>
+#include <WiFiClientSecure.h>
+
+typedef enum
+{
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL,
+    WL_SCAN_COMPLETED,
+    WL_CONNECTED,
+    WL_CONNECT_FAILED,
+    WL_CONNECTION_LOST,
+    WL_DISCONNECTED
+} wl_status_t;
+
+typedef enum
+{
+    WIFI_OFF,
+    WIFI_STA
+} wifi_mode_t;
+
+// Host names resolve to the addresses the test puts in hosts, lookups and
+// connections are counted
+class WiFiClass
+{
+public:
+    wl_status_t begin(const char *, const char * = NULL, int32_t = 0, const uint8_t * = NULL, bool = true) { return WL_CONNECTED; }
+    bool config(IPAddress, IPAddress, IPAddress, IPAddress = (uint32_t)0, IPAddress = (uint32_t)0) { return true; }
+    wl_status_t status() { return isConnected() ? WL_CONNECTED : WL_DISCONNECTED; }
+    bool isConnected() { return connected; }
+    bool disconnect(bool = false, bool = false)
+    {
+        connected = false;
+        return true;
+    }
+    bool mode(wifi_mode_t) { return true; }
+    int hostByName(const char *host, IPAddress &address)
+    {
+        numberOfLookups++;
+        auto found = hosts.find(host);
+        if (found == hosts.end())
+            return 0;
+        address = found->second;
+        return 1;
+    }
+
+    bool connected = false;
+    std::map<std::string, uint32_t> hosts;
+    int numberOfLookups = 0;
+    int numberOfConnections = 0;
+    std::vector<uint32_t> refusedAddresses; // connections to these fail
+    // Bytes the server sends on each new connection to an address, in order
+    std::map<uint32_t, std::deque<std::string>> responses;
+};
+extern WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef HOST_WIFICLIENT_H_INCLUDE
+#define HOST_WIFICLIENT_H_INCLUDE
+
+#include <Client.h>
+
+// Connects to nothing, WiFi counts the attempts and refuses refusedAddresses.
+// A connection receives the next canned stream queued for its address,
+// and stays open after the last byte as a keep-alive server would.
+class WiFiClient : public Client
+{
+public:
+    virtual ~WiFiClient() {}
+    int connect(IPAddress address, uint16_t port) override;
+    int connect(const char *host, uint16_t port) override;
+    int connect(IPAddress address, uint16_t port, int32_t) { return connect(address, port); }
+    uint8_t connected() override { return _connected; }
+    void stop() override { _connected = false; }
+    int available() override { return _input.size() - _position; }
+    int read() override { return _position < _input.size() ? (uint8_t)_input[_position++] : -1; }
+    int read(uint8_t *buffer, size_t size) override
+    {
+        size = std::min(size, _input.size() - _position);
+        memcpy(buffer, _input.data() + _position, size);
+        _position += size;
+        return size;
+    }
+    int peek() override { return _position < _input.size() ? (uint8_t)_input[_position] : -1; }
+    size_t write(uint8_t c) override
+    {
+        sent += (char)c;
+        return 1;
+    }
+    void setNoDelay(bool) {}
+    int setTimeout(uint32_t) { return 0; }
+
+    std::string sent;
+
+protected:
+    bool _connected = false;
+    std::string _input; // what the server sends, see WiFiClass::responses
+    size_t _position = 0;
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+int WiFiClientSecure::connect(IPAddress address, uint16_t port, const char *host, const char *rootCA, const char *,
+                              const char *)
+{
+    if (!startTLS(address, port, host, rootCA) || !handshake())
+    {
+        stop();
+        return 0;
+    }
+    return 1;
+}
+
+bool WiFiClientSecure::startTLS(IPAddress address, uint16_t port, const char *host, const char *rootCA)
+{
+    stop();
+    WiFi.numberOfConnections++;
+    _socket = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in server = {};
+    server.sin_family = AF_INET;
+    server.sin_addr.s_addr = (uint32_t)address;
+    server.sin_port = htons(port);
+    if (_socket < 0 || ::connect(_socket, (struct sockaddr *)&server, sizeof(server)) != 0)
+    {
+        log_printf("TCP connection failed: %s\n", host);
+        return false;
+    }
+    int enable = 1;
+    setsockopt(_socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+    _context = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_max_proto_version(_context, TLS1_2_VERSION);
+    SSL_CTX_set_verify(_context, SSL_VERIFY_PEER, NULL);
+    BIO *pem = BIO_new_mem_buf(rootCA, -1);
+    X509 *certificate = PEM_read_bio_X509(pem, NULL, NULL, NULL);
+    BIO_free(pem);
+    if (certificate == NULL || X509_STORE_add_cert(SSL_CTX_get_cert_store(_context), certificate) != 1)
+    {
+        X509_free(certificate);
+        log_printf("Root certificate not parsed\n");
+        return false;
+    }
+    X509_free(certificate);
+    _ssl = SSL_new(_context);
+    SSL_set_fd(_ssl, _socket);
+    SSL_set_tlsext_host_name(_ssl, host);
+    SSL_set1_host(_ssl, host);
+    return true;
+}
+
+bool WiFiClientSecure::handshake()
+{
+    struct timeval timeout = {(time_t)(_handshakeTimeout / 1000), (suseconds_t)(_handshakeTimeout % 1000 * 1000)};
+    setsockopt(_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    if (SSL_connect(_ssl) != 1)
+    {
+        char error[120];
+        ERR_error_string_n(ERR_get_error(), error, sizeof(error));
+        log_printf("TLS handshake failed: %s\n", error);
+        return false;
+    }
+    _input.clear();
+    _position = 0;
+    _connected = true;
+    return true;
+}
+
+void WiFiClientSecure::receive(unsigned long timeoutMillis)
+{
+    if (_ssl == NULL || _position < _input.size())
+        return;
+    struct pollfd socket = {_socket, POLLIN, 0};
+    if (SSL_pending(_ssl) == 0 && poll(&socket, 1, timeoutMillis) <= 0)
+        return;
+    char buffer[4096];
+    int received = SSL_read(_ssl, buffer, sizeof(buffer));
+    if (received > 0)
+    {
+        _input.assign(buffer, received);
+        _position = 0;
+    }
+    else if (SSL_get_error(_ssl, received) != SSL_ERROR_WANT_READ)
+        _connected = false;
+}
+
+uint8_t WiFiClientSecure::connected()
+{
+    receive(0);
+    return _connected;
+}
+
+void WiFiClientSecure::stop()
+{
+    if (_ssl != NULL)
+        SSL_free(_ssl);
+    if (_context != NULL)
+        SSL_CTX_free(_context);
+    if (_socket >= 0)
+        close(_socket);
+    _ssl = NULL;
+    _context = NULL;
+    _socket = -1;
+    WiFiClient::stop();
+}
+
+int WiFiClientSecure::available()
+{
+    receive(0);
+    return WiFiClient::available();
+}
+
+// Waits for the next byte as long as the stream timeout, as the device
+// waits in Stream::timedRead()
+int WiFiClientSecure::read()
+{
+    receive(getTimeout());
+    return WiFiClient::read();
+}
+
+int WiFiClientSecure::read(uint8_t *buffer, size_t size)
+{
+    receive(getTimeout());
+    return WiFiClient::read(buffer, size);
+}
+
+int WiFiClientSecure::peek()
+{
+    receive(0);
+    return WiFiClient::peek();
+}
+
+size_t WiFiClientSecure::write(const uint8_t *buffer, size_t size)
+{
+    if (_ssl == NULL)
+        return 0;
+    int written = SSL_write(_ssl, buffer, size);
+    return written > 0 ? written : 0;
+}
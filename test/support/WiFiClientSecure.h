@@ -0,0 +1,50 @@
+#ifndef HOST_WIFICLIENTSECURE_H_INCLUDE
+#define HOST_WIFICLIENTSECURE_H_INCLUDE
+
+#include <WiFiClient.h>
+
+typedef struct ssl_st SSL;
+typedef struct ssl_ctx_st SSL_CTX;
+
+// TLS 1.2 over a host socket, with OpenSSL in place of mbedTLS, so the tests
+// handshake with a server of their own on 127.0.0.1. The received records
+// are decrypted into the stream of WiFiClient.
+class WiFiClientSecure : public WiFiClient
+{
+public:
+    ~WiFiClientSecure() override { stop(); }
+    void setCACert(const char *rootCA) { _CA_cert = rootCA; }
+    void setInsecure() { _CA_cert = NULL; }
+    void setHandshakeTimeout(unsigned long seconds) { _handshakeTimeout = seconds * 1000; }
+    int connect(IPAddress address, uint16_t port, const char *host, const char *rootCA, const char *, const char *);
+    using WiFiClient::connect;
+    int lastError(char *, const size_t) { return 0; }
+
+    uint8_t connected() override;
+    void stop() override;
+    int available() override;
+    int read() override;
+    int read(uint8_t *buffer, size_t size) override;
+    int peek() override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override;
+
+protected:
+    // The TCP connection and an SSL of _context verifying host against
+    // rootCA, false when either fails
+    bool startTLS(IPAddress address, uint16_t port, const char *host, const char *rootCA);
+    // The handshake of _ssl within _handshakeTimeout
+    bool handshake();
+
+    SSL_CTX *_context = NULL;
+    SSL *_ssl = NULL;
+    int _socket = -1;
+    const char *_CA_cert = NULL;
+    unsigned long _handshakeTimeout = 120000;
+
+private:
+    // Decrypts what has arrived within timeoutMillis
+    void receive(unsigned long timeoutMillis);
+};
+
+#endif
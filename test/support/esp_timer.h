@@ -0,0 +1,6 @@
+#ifndef HOST_ESP_TIMER_H_INCLUDE
+#define HOST_ESP_TIMER_H_INCLUDE
+
+#include <Arduino.h>
+
+#endif
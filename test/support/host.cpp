@@ -0,0 +1,177 @@
+#include <Arduino.h>
+#include <chrono>
+#include <thread>
+
+#include <SD_MMC.h>
+#include <SPI.h>
+#include <WiFi.h>
+
+bool HostState::hasPSRAM = false;
+bool HostState::quiet = true;
+int HostState::pins[64];
+
+HardwareSerial Serial;
+SDMMCFS SD_MMC;
+SPIClass SPI;
+WiFiClass WiFi;
+IPAddress INADDR_NONE;
+
+static const auto startTime = std::chrono::steady_clock::now();
+
+void HostState::reset()
+{
+    hasPSRAM = false;
+    quiet = true;
+    for (int &level : pins)
+        level = HIGH;
+    SD_MMC.clear();
+    SPI.commandPin = -1;
+    SPI.sent.clear();
+    WiFi = WiFiClass();
+}
+
+int HostState::log(const char *format, ...)
+{
+    if (quiet)
+        return 0;
+    va_list arguments;
+    va_start(arguments, format);
+    int length = vprintf(format, arguments);
+    va_end(arguments);
+    return length;
+}
+
+unsigned long millis()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+unsigned long micros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void delay(unsigned long ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void yield() {}
+
+void pinMode(int, int) {}
+
+void digitalWrite(int pin, int value)
+{
+    HostState::pins[pin] = value;
+}
+
+int digitalRead(int pin)
+{
+    return HostState::pins[pin];
+}
+
+// Levels only change when the test sets them, so no edge ever comes
+void attachInterrupt(uint8_t, void (*)(), int) {}
+void detachInterrupt(uint8_t) {}
+
+bool psramFound()
+{
+    return HostState::hasPSRAM;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t)
+{
+    return malloc(size);
+}
+
+void heap_caps_free(void *block)
+{
+    free(block);
+}
+
+void *ps_malloc(size_t size)
+{
+    return HostState::hasPSRAM ? malloc(size) : NULL;
+}
+
+// Light sleep is refused, so waits poll
+esp_err_t esp_light_sleep_start() { return ESP_FAIL; }
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t) { return ESP_OK; }
+esp_err_t esp_sleep_enable_gpio_wakeup() { return ESP_OK; }
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t) { return ESP_OK; }
+esp_err_t gpio_wakeup_enable(gpio_num_t, gpio_int_type_t) { return ESP_OK; }
+esp_err_t gpio_wakeup_disable(gpio_num_t) { return ESP_OK; }
+
+// Single threaded, so a semaphore is only a count
+SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return new int(0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t)
+{
+    int &count = *(int *)semaphore;
+    if (count == 0)
+        return pdFALSE;
+    count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t *woken)
+{
+    *(int *)semaphore = 1;
+    *woken = pdFALSE;
+    return pdTRUE;
+}
+
+void configTime(long, int, const char *, const char *, const char *) {}
+void sntp_set_sync_status(sntp_sync_status_t) {}
+
+int64_t esp_timer_get_time()
+{
+    return micros();
+}
+
+size_t Print::printf(const char *format, ...)
+{
+    char buffer[512];
+    va_list arguments;
+    va_start(arguments, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, arguments);
+    va_end(arguments);
+    return write((const uint8_t *)buffer, min(length, (int)sizeof(buffer) - 1));
+}
+
+String Stream::readStringUntil(char terminator)
+{
+    String text;
+    for (int c; (c = read()) >= 0 && c != terminator;)
+        text += (char)c;
+    return text;
+}
+
+String Stream::readString()
+{
+    return readStringUntil('\0');
+}
+
+int WiFiClient::connect(IPAddress address, uint16_t)
+{
+    WiFi.numberOfConnections++;
+    auto &refused = WiFi.refusedAddresses;
+    _connected = std::find(refused.begin(), refused.end(), (uint32_t)address) == refused.end();
+    auto &queued = WiFi.responses[(uint32_t)address];
+    if (_connected && !queued.empty())
+    {
+        _input = queued.front();
+        _position = 0;
+        queued.pop_front();
+    }
+    return _connected;
+}
+
+int WiFiClient::connect(const char *host, uint16_t port)
+{
+    IPAddress address;
+    return WiFi.hostByName(host, address) == 1 && connect(address, port);
+}
@@ -0,0 +1,132 @@
+#include <Arduino.h>
+#include <SD_MMC.h>
+#include <unity.h>
+#include <climits>
+#include <fstream>
+#include <sstream>
+#include <tuple>
+
+#include "PCArena.h"
+#include "PCCompact.h"
+#include "PCEvent.h"
+
+#define FIXTURE_NAME "recurrence.ics"
+#define FIXTURE_TIMEZONE 9
+
+typedef std::tuple<time_t, time_t, std::string> ExpandedEvent;
+
+void setUp()
+{
+    HostState::reset();
+    HostState::hasPSRAM = true;
+    PCArena::begin();
+    PCEvent::defaultTimezone = FIXTURE_TIMEZONE;
+    tm today = {};
+    today.tm_year = 2026 - 1900;
+    today.tm_mon = 2;
+    today.tm_mday = 15;
+    PCEvent::setTimeinfo(today);
+}
+
+void tearDown()
+{
+    PCEvent::releaseEvents();
+    PCArena::end();
+}
+
+static std::string readFile(const char *path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+// The fixture sits next to this file, wherever the tests are run from
+static std::string fixturePath()
+{
+    std::string path = __FILE__;
+    return path.substr(0, path.find_last_of('/') + 1) + FIXTURE_NAME;
+}
+
+// The payload tools/pcal builds from the fixture, as a device would fetch it
+static std::string compileFixture()
+{
+    File file = SD_MMC.open("/source.ics", FILE_WRITE, true);
+    std::string content = readFile(fixturePath().c_str());
+    file.write((const uint8_t *)content.data(), content.size());
+    file.close();
+    TEST_ASSERT_TRUE(PCEvent::loadICalendarFile("file:/source.ics", false));
+    PCEvent::buildEvents();
+    std::vector<uint8_t> payload = PCCompactWriter::build();
+    PCEvent::releaseEvents();
+    return std::string(payload.begin(), payload.end());
+}
+
+// Events of one feed after parsing and buildEvents(), sorted by start and title
+static std::vector<ExpandedEvent> expand(const char *path, const std::string &content)
+{
+    File file = SD_MMC.open(path, FILE_WRITE, true);
+    file.write((const uint8_t *)content.data(), content.size());
+    file.close();
+    TEST_ASSERT_TRUE(PCEvent::loadICalendarFile(String("file:") + path, false));
+    PCEvent::buildEvents();
+    std::vector<ExpandedEvent> events;
+    for (auto &event : PCEvent::eventsInRange(0, LONG_MAX))
+    {
+        events.push_back(ExpandedEvent(event.getStartTime(), event.getEndTime(), event.getTitle().c_str()));
+    }
+    std::sort(events.begin(), events.end());
+    PCEvent::releaseEvents();
+    return events;
+}
+
+static String describe(const ExpandedEvent &event)
+{
+    time_t start = std::get<0>(event);
+    tm startTM;
+    gmtime_r(&start, &startTM);
+    char text[80];
+    snprintf(text, sizeof(text), "%04d-%02d-%02d %02d:%02d +%ld min %s", startTM.tm_year + 1900, startTM.tm_mon + 1, startTM.tm_mday,
+             startTM.tm_hour, startTM.tm_min, (long)(std::get<1>(event) - start) / 60, std::get<2>(event).c_str());
+    return String(text);
+}
+
+// The same fixture read as iCalendar and as a PCAL payload gives the same events
+void test_icalendar_and_payload_agree()
+{
+    std::vector<ExpandedEvent> fromICalendar = expand("/fixture.ics", readFile(fixturePath().c_str()));
+    std::vector<ExpandedEvent> fromPayload = expand("/fixture.pcal", compileFixture());
+    TEST_ASSERT_GREATER_THAN(50, fromPayload.size());
+    for (size_t i = 0; i < min(fromICalendar.size(), fromPayload.size()); i++)
+    {
+        if (fromICalendar[i] != fromPayload[i])
+        {
+            String message = "iCalendar " + describe(fromICalendar[i]) + ", payload " + describe(fromPayload[i]);
+            TEST_ASSERT_TRUE_MESSAGE(false, message.c_str());
+        }
+    }
+    TEST_ASSERT_EQUAL(fromPayload.size(), fromICalendar.size());
+}
+
+// BYDAY and BYMONTHDAY together keep only the days both pick
+void test_friday_the_13th()
+{
+    std::vector<ExpandedEvent> events = expand("/fixture.ics", readFile(fixturePath().c_str()));
+    std::vector<String> fridays;
+    for (auto &event : events)
+    {
+        if (std::get<2>(event) == "Friday the 13th")
+            fridays.push_back(describe(event));
+    }
+    TEST_ASSERT_EQUAL(1, fridays.size());
+    TEST_ASSERT_EQUAL_STRING("2026-03-13 10:00 +60 min Friday the 13th", fridays[0].c_str());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_icalendar_and_payload_agree);
+    RUN_TEST(test_friday_the_13th);
+    return UNITY_END();
+}
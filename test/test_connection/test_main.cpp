@@ -0,0 +1,296 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <unity.h>
+#include <climits>
+
+#include "PCArena.h"
+#include "PCBodyReader.h"
+#include "PCConnection.h"
+#include "PCEvent.h"
+
+#define FEED_ADDRESS 0x0A000001
+#define MOVED_ADDRESS 0x0A000002
+#define ROOT_CA "-----BEGIN CERTIFICATE-----\n"
+
+void setUp()
+{
+    HostState::reset();
+    WiFi.connected = true;
+    PCConnection::setDNSTTL(3600);
+}
+
+void tearDown()
+{
+    PCConnection::closeAll();
+    PCEvent::releaseEvents();
+    PCArena::end();
+}
+
+void test_parse_url()
+{
+    String host;
+    String path;
+    uint16_t port;
+    boolean secure;
+    TEST_ASSERT_TRUE(parseURL("https://user@calendar.example.com:8443/a/b.ics", host, port, path, secure));
+    TEST_ASSERT_EQUAL_STRING("calendar.example.com", host.c_str());
+    TEST_ASSERT_EQUAL(8443, port);
+    TEST_ASSERT_EQUAL_STRING("/a/b.ics", path.c_str());
+    TEST_ASSERT_TRUE(secure);
+    TEST_ASSERT_TRUE(parseURL("http://192.168.1.10", host, port, path, secure));
+    TEST_ASSERT_EQUAL(80, port);
+    TEST_ASSERT_EQUAL_STRING("/", path.c_str());
+    TEST_ASSERT_FALSE(secure);
+    TEST_ASSERT_FALSE(parseURL("calendar.example.com/a.ics", host, port, path, secure));
+}
+
+// The cache is in RTC memory, so a later wake finds the address as a
+// second lookup of the same wake does
+void test_resolved_addresses_are_cached()
+{
+    WiFi.hosts["cached.example.com"] = FEED_ADDRESS;
+    int hits = PCConnection::numberOfDNSCacheHits();
+    IPAddress address;
+    TEST_ASSERT_TRUE(PCConnection::resolve("cached.example.com", address));
+    TEST_ASSERT_EQUAL(FEED_ADDRESS, (uint32_t)address);
+    TEST_ASSERT_TRUE(PCConnection::resolve("Cached.Example.com", address));
+    TEST_ASSERT_EQUAL(FEED_ADDRESS, (uint32_t)address);
+    TEST_ASSERT_EQUAL(1, WiFi.numberOfLookups);
+    TEST_ASSERT_EQUAL(hits + 1, PCConnection::numberOfDNSCacheHits());
+    TEST_ASSERT_EQUAL(0, PCConnection::lastDNSMillis());
+}
+
+void test_expired_addresses_are_resolved_again()
+{
+    WiFi.hosts["expired.example.com"] = FEED_ADDRESS;
+    PCConnection::setDNSTTL(0);
+    IPAddress address;
+    TEST_ASSERT_TRUE(PCConnection::resolve("expired.example.com", address));
+    TEST_ASSERT_TRUE(PCConnection::resolve("expired.example.com", address));
+    TEST_ASSERT_EQUAL(2, WiFi.numberOfLookups);
+}
+
+void test_unknown_hosts_are_not_cached()
+{
+    IPAddress address;
+    TEST_ASSERT_FALSE(PCConnection::resolve("unknown.example.com", address));
+    TEST_ASSERT_FALSE(PCConnection::resolve("unknown.example.com", address));
+    TEST_ASSERT_EQUAL(2, WiFi.numberOfLookups);
+    TEST_ASSERT_NULL(PCConnection::open("https://unknown.example.com/feed.ics", ROOT_CA));
+    TEST_ASSERT_EQUAL(0, WiFi.numberOfConnections);
+}
+
+// A missing root certificate fails closed, before any lookup
+void test_https_without_root_ca_is_refused()
+{
+    WiFi.hosts["secure.example.com"] = FEED_ADDRESS;
+    TEST_ASSERT_NULL(PCConnection::open("https://secure.example.com/feed.ics", NULL));
+    TEST_ASSERT_NULL(PCConnection::open("https://secure.example.com/feed.ics", ""));
+    TEST_ASSERT_EQUAL(0, WiFi.numberOfLookups);
+    TEST_ASSERT_EQUAL(0, WiFi.numberOfConnections);
+    // Plain HTTP, as for a pcal.py server on the LAN, needs none
+    WiFiClient *client = PCConnection::open("http://secure.example.com/work.pcal", NULL);
+    TEST_ASSERT_NOT_NULL(client);
+    PCConnection::release(client, false);
+}
+
+// A server that moved refuses the cached address, the host is looked up
+// again and the new address is connected and cached
+void test_refused_cached_address_is_resolved_again()
+{
+    WiFi.hosts["moved.example.com"] = FEED_ADDRESS;
+    IPAddress address;
+    TEST_ASSERT_TRUE(PCConnection::resolve("moved.example.com", address));
+    WiFi.hosts["moved.example.com"] = MOVED_ADDRESS;
+    WiFi.refusedAddresses.push_back(FEED_ADDRESS);
+
+    WiFiClient *client = PCConnection::open("http://moved.example.com/feed.ics", NULL);
+    TEST_ASSERT_NOT_NULL(client);
+    TEST_ASSERT_EQUAL(2, WiFi.numberOfLookups);
+    TEST_ASSERT_EQUAL(2, WiFi.numberOfConnections);
+    PCConnection::release(client, false);
+
+    TEST_ASSERT_TRUE(PCConnection::resolve("moved.example.com", address));
+    TEST_ASSERT_EQUAL(MOVED_ADDRESS, (uint32_t)address);
+    TEST_ASSERT_EQUAL(2, WiFi.numberOfLookups);
+}
+
+void test_released_connections_are_reused()
+{
+    WiFi.hosts["pooled.example.com"] = FEED_ADDRESS;
+    int handshakes = PCConnection::numberOfHandshakes();
+    WiFiClient *client = PCConnection::open("http://pooled.example.com/a.ics", NULL);
+    TEST_ASSERT_NOT_NULL(client);
+    TEST_ASSERT_FALSE(PCConnection::lastOpenWasReused());
+    PCConnection::release(client, true);
+
+    TEST_ASSERT_TRUE(client == PCConnection::open("http://pooled.example.com/b.ics", NULL));
+    TEST_ASSERT_TRUE(PCConnection::lastOpenWasReused());
+    PCConnection::release(client, false);
+    // Another port is another origin
+    client = PCConnection::open("http://pooled.example.com:8443/a.ics", NULL);
+    TEST_ASSERT_FALSE(PCConnection::lastOpenWasReused());
+    PCConnection::release(client, false);
+
+    TEST_ASSERT_EQUAL(2, WiFi.numberOfConnections);
+    TEST_ASSERT_EQUAL(handshakes + 2, PCConnection::numberOfHandshakes());
+    TEST_ASSERT_EQUAL(1, WiFi.numberOfLookups);
+}
+
+// Canned responses of the server at FEED_ADDRESS, sent on one connection
+static WiFiClient *openWith(const std::string &responses)
+{
+    WiFi.hosts["framing.example.com"] = FEED_ADDRESS;
+    WiFi.responses[FEED_ADDRESS].push_back(responses);
+    WiFiClient *client = PCConnection::open("http://framing.example.com/feed.ics", NULL);
+    TEST_ASSERT_NOT_NULL(client);
+    return client;
+}
+
+// The body of one response as read by a feed, and whether it was framed
+static std::string readBody(WiFiClient *client, boolean &complete, boolean &error)
+{
+    PCHTTPResponse response;
+    TEST_ASSERT_TRUE(PCConnection::get(client, "http://framing.example.com/feed.ics", response));
+    TEST_ASSERT_EQUAL(HTTP_STATUS_OK, response.statusCode);
+    PCBodyReader reader(client, response.contentLength, response.chunked);
+    std::string body;
+    uint8_t buffer[16];
+    for (int length; (length = reader.read(buffer, sizeof(buffer))) > 0;)
+        body.append((const char *)buffer, length);
+    complete = reader.drain();
+    error = reader.hasError();
+    return body;
+}
+
+static void assertBody(const char *expected, WiFiClient *client)
+{
+    boolean complete;
+    boolean error;
+    TEST_ASSERT_EQUAL_STRING(expected, readBody(client, complete, error).c_str());
+    TEST_ASSERT_TRUE(complete);
+    TEST_ASSERT_FALSE(error);
+}
+
+static void assertBroken(WiFiClient *client)
+{
+    boolean complete;
+    boolean error;
+    readBody(client, complete, error);
+    TEST_ASSERT_FALSE(complete);
+    TEST_ASSERT_TRUE(error);
+}
+
+// Each body ends at its last byte, so the next response on the connection
+// is read from its status line
+void test_content_length_then_chunked_on_one_connection()
+{
+    WiFiClient *client = openWith("HTTP/1.1 200 OK\r\nContent-Length: 11\r\n\r\nfirst feed\n"
+                                  "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n7\r\nsecond\n\r\n0\r\n\r\n"
+                                  "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+    assertBody("first feed\n", client);
+    assertBody("second\n", client);
+    assertBody("", client);
+    TEST_ASSERT_EQUAL(0, client->available());
+    PCConnection::release(client, false);
+}
+
+void test_chunks_with_extensions_and_trailers()
+{
+    WiFiClient *client = openWith("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                                  "4;name=value\r\nWiki\r\n5\r\npedia\r\nE ; last=\"yes\"\r\n in\r\n\r\nchunks.\r\n"
+                                  "0;done\r\nExpires: never\r\nX-Checksum: 1\r\n\r\n"
+                                  "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\nnext");
+    assertBody("Wikipedia in\r\n\r\nchunks.", client);
+    assertBody("next", client);
+    PCConnection::release(client, false);
+}
+
+// An empty, non-hex or 0x size line is not the last chunk
+void test_malformed_chunk_size_lines()
+{
+    const char *sizeLines[] = {"\r\n", "zz\r\n", "0x5\r\n", "-5\r\n", "5 five\r\n", " \r\n"};
+    for (const char *sizeLine : sizeLines)
+    {
+        WiFiClient *client = openWith(std::string("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n") + sizeLine +
+                                      "hello\r\n0\r\n\r\n");
+        assertBroken(client);
+        PCConnection::release(client, false);
+    }
+}
+
+void test_chunk_without_its_crlf()
+{
+    WiFiClient *client = openWith("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabcdef\r\n0\r\n\r\n");
+    assertBroken(client);
+    PCConnection::release(client, false);
+}
+
+static String feedWithEvent(const char *title)
+{
+    return String("BEGIN:VCALENDAR\r\nBEGIN:VEVENT\r\nUID:") + title + "\r\nDTSTART:20260315T010000Z\r\nSUMMARY:" + title +
+           "\r\nEND:VEVENT\r\nEND:VCALENDAR\r\n";
+}
+
+static std::string chunkedResponse(String body, const char *sizeLine = NULL)
+{
+    char size[16];
+    snprintf(size, sizeof(size), "%x;feed", body.length());
+    return std::string("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n") + (sizeLine ? sizeLine : size) + "\r\n" +
+           body.c_str() + "\r\n0\r\n\r\n";
+}
+
+static int loadFeeds(const std::string &firstResponse)
+{
+    HostState::hasPSRAM = true;
+    PCArena::begin();
+    tm today = {};
+    today.tm_year = 2026 - 1900;
+    today.tm_mon = 2;
+    today.tm_mday = 15;
+    PCEvent::setTimeinfo(today);
+    String second = feedWithEvent("Second");
+    WiFi.hosts["framing.example.com"] = FEED_ADDRESS;
+    WiFi.responses[FEED_ADDRESS].push_back(firstResponse + "HTTP/1.1 200 OK\r\nContent-Length: " + String(second.length()).c_str() + "\r\n\r\n" + second.c_str());
+    WiFi.responses[FEED_ADDRESS].push_back(std::string("HTTP/1.1 200 OK\r\nContent-Length: ") + String(second.length()).c_str() + "\r\n\r\n" + second.c_str());
+    TEST_ASSERT_TRUE(PCEvent::loadICalendar("http://framing.example.com/first.ics", false));
+    TEST_ASSERT_TRUE(PCEvent::loadICalendar("http://framing.example.com/second.ics", false));
+    PCEvent::buildEvents();
+    return PCEvent::numberOfEventsInRange(0, LONG_MAX);
+}
+
+// Two feeds of one host over one connection
+void test_feeds_share_a_framed_connection()
+{
+    int reused = PCConnection::numberOfReusedConnections();
+    TEST_ASSERT_EQUAL(2, loadFeeds(chunkedResponse(feedWithEvent("First"))));
+    TEST_ASSERT_EQUAL(1, WiFi.numberOfConnections);
+    TEST_ASSERT_EQUAL(reused + 1, PCConnection::numberOfReusedConnections());
+}
+
+// A feed whose framing is lost closes its connection, the next feed does
+// not read the rest of it as its own response
+void test_broken_framing_closes_the_connection()
+{
+    TEST_ASSERT_EQUAL(1, loadFeeds(chunkedResponse(feedWithEvent("First"), "")));
+    TEST_ASSERT_EQUAL(2, WiFi.numberOfConnections);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_url);
+    RUN_TEST(test_resolved_addresses_are_cached);
+    RUN_TEST(test_expired_addresses_are_resolved_again);
+    RUN_TEST(test_unknown_hosts_are_not_cached);
+    RUN_TEST(test_https_without_root_ca_is_refused);
+    RUN_TEST(test_refused_cached_address_is_resolved_again);
+    RUN_TEST(test_released_connections_are_reused);
+    RUN_TEST(test_content_length_then_chunked_on_one_connection);
+    RUN_TEST(test_chunks_with_extensions_and_trailers);
+    RUN_TEST(test_malformed_chunk_size_lines);
+    RUN_TEST(test_chunk_without_its_crlf);
+    RUN_TEST(test_feeds_share_a_framed_connection);
+    RUN_TEST(test_broken_framing_closes_the_connection);
+    return UNITY_END();
+}
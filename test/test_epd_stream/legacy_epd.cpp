@@ -0,0 +1,204 @@
+/**
+ *  @filename   :   legacy_epd.cpp
+ *  @brief      :   Implements for e-paper library
+ *  @author     :   Yehui from Waveshare
+ *
+ *  Copyright (C) Waveshare     Nov 30 2020
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documnetation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to  whom the Software is
+ * furished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS OR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// The Waveshare driver as it was before the EpdPanel template, kept to
+// check that the template sends the same bytes.
+
+#include <stdlib.h>
+#include "legacy_epd.h"
+#include "PCFrameKernels.h"
+
+LegacyEpd::~LegacyEpd() {
+};
+
+LegacyEpd::LegacyEpd() {
+    reset_pin = RST_PIN;
+    dc_pin = DC_PIN;
+    cs_pin = CS_PIN;
+    busy_pin = BUSY_PIN;
+    width = EPD_WIDTH;
+    height = EPD_HEIGHT;
+};
+
+int LegacyEpd::Init(void) {
+    if (IfInit() != 0) {
+        return -1;
+    }
+    Reset();
+
+    SendCommand(0x01);			//POWER SETTING
+    SendData(0x07);
+    SendData(0x07);    //VGH=20V,VGL=-20V
+    SendData(0x3f);		//VDH=15V
+    SendData(0x3f);		//VDL=-15V
+
+    SendCommand(0x04); //POWER ON
+    DelayMs(timings.commandSettle);
+    WaitUntilIdle();
+
+    SendCommand(0X00);			//PANNEL SETTING
+    SendData(0x0F);   //KW-3f   KWR-2F	BWROTP 0f	BWOTP 1f
+
+    SendCommand(0x61);        	//tres
+    SendData(0x03);		//source 800
+    SendData(0x20);
+    SendData(0x01);		//gate 480
+    SendData(0xE0);
+
+    SendCommand(0X15);
+    SendData(0x00);
+
+    SendCommand(0X50);			//VCOM AND DATA INTERVAL SETTING
+    SendData(0x11);
+    SendData(0x07);
+
+    SendCommand(0X60);			//TCON SETTING
+    SendData(0x22);
+
+    SendCommand(0x65);  // Resolution setting
+    SendData(0x00);
+    SendData(0x00);//800*480
+    SendData(0x00);
+    SendData(0x00);
+	
+    return 0;
+}
+
+/**
+ *  @brief: basic function for sending commands
+ */
+void LegacyEpd::SendCommand(unsigned char command) {
+    DigitalWrite(dc_pin, LOW);
+    SpiTransfer(command);
+}
+
+/**
+ *  @brief: basic function for sending data
+ */
+void LegacyEpd::SendData(unsigned char data) {
+    DigitalWrite(dc_pin, HIGH);
+    SpiTransfer(data);
+}
+
+/**
+ *  @brief: Wait until the busy_pin goes HIGH
+ *          The CPU sleeps until the BUSY interrupt instead of polling.
+ */
+void LegacyEpd::WaitUntilIdle(void) {
+    unsigned long startMillis = millis();
+    SendCommand(0x71);
+    if (!WaitForLevel(busy_pin, HIGH, BUSY_TIMEOUT_MS)) {
+        log_printf("e-Paper busy timeout\n");
+    }
+    DelayMs(timings.idleSettle);
+    lastWaitMillis = millis() - startMillis;
+    totalWaitMillis += lastWaitMillis;
+    numberOfWaits++;
+    log_printf("e-Paper busy for %lu ms\n", lastWaitMillis);
+}
+
+/**
+ *  @brief: module reset.
+ *          often used to awaken the module in deep sleep,
+ *          see LegacyEpd::Sleep();
+ */
+void LegacyEpd::Reset(void) {
+    DigitalWrite(reset_pin, HIGH);
+    DelayMs(timings.resetHigh);
+    DigitalWrite(reset_pin, LOW);                //module reset    
+    DelayMs(timings.resetLow);
+    DigitalWrite(reset_pin, HIGH);
+    DelayMs(timings.resetRecovery);
+    WaitForLevel(busy_pin, HIGH, BUSY_TIMEOUT_MS);
+}
+
+void LegacyEpd::Displaypart(const unsigned char* pbuffer, unsigned long xStart,         unsigned long yStart,\
+                      unsigned long Picture_Width,  unsigned long Picture_Height, unsigned char Block) {
+    if(Block == 0){
+        SendCommand(0x10);
+    }else if(Block == 1){
+        SendCommand(0x13);
+    }
+    if (xStart == 0 && yStart == 0 && Picture_Width == width && Picture_Height == height) {
+        // Whole panel: no bounds checks, the red plane is inverted a row at a time
+        unsigned char row[EPD_WIDTH / 8];
+        for (unsigned long j = 0; j < height; j++) {
+            const unsigned char* line = pbuffer + j * (width / 8);
+            if (Block == 1) {
+                PCFrameKernels::invert(row, line, width / 8);
+                line = row;
+            }
+            for (unsigned long i = 0; i < width / 8; i++) {
+                SendData(line[i]);
+            }
+        }
+    } else {
+        for (unsigned long j = 0; j < height; j++) {
+            for (unsigned long i = 0; i < width/8; i++) {
+                if( (j>=yStart) && (j<yStart+Picture_Height) && (i*8>=xStart) && (i*8<xStart+Picture_Width)){
+                    if(Block == 0){
+                        SendData((pgm_read_byte(&(pbuffer[i-xStart/8 + (Picture_Width)/8*(j-yStart)]))) );
+                    }else{
+                        SendData(~(pgm_read_byte(&(pbuffer[i-xStart/8 + (Picture_Width)/8*(j-yStart)]))) );
+                    }
+                }else {
+                  if(Block == 0){
+                    SendData(0xff);
+                  }else {
+                    SendData(0x00);
+                  }
+                
+                }
+            }
+        }
+    }
+    if(Block == 1){
+        SendCommand(0x12);
+        DelayMs(timings.commandSettle);
+        WaitUntilIdle();
+    }
+
+}
+
+/**
+ *  @brief: After this command is transmitted, the chip would enter the 
+ *          deep-sleep mode to save power. 
+ *          The deep sleep mode would return to standby by hardware reset. 
+ *          The only one parameter is a check code, the command would be
+ *          executed if check code = 0xA5. 
+ *          You can use EPD_Reset() to awaken
+ */
+void LegacyEpd::Sleep(void) {
+    SendCommand(0X02);
+    DelayMs(timings.commandSettle);
+    WaitUntilIdle();
+    SendCommand(0X07);
+    SendData(0xa5);
+}
+
+/* END OF FILE */
+
+
@@ -0,0 +1,118 @@
+#include <Arduino.h>
+#include <SPI.h>
+#include <unity.h>
+
+#include "epd7in5b_V2.h"
+#include "legacy_epd.h"
+
+#define FRAME_BYTES (EPD_WIDTH * EPD_HEIGHT / 8)
+
+static unsigned char frame[FRAME_BYTES];
+
+void setUp()
+{
+    HostState::reset();
+    SPI.commandPin = DC_PIN;
+    // No delays, BUSY is always idle
+    EpdTimings noDelays = {0, 0, 0, 0, 0};
+    EpdIf::timings = noDelays;
+    EpdIf::lightSleep = false;
+    srand(3);
+    for (auto &b : frame)
+        b = rand();
+}
+
+void tearDown() {}
+
+// SPI bytes of one call on each driver, commands marked with SPI_COMMAND
+template <typename Call>
+static std::vector<uint16_t> sentBy(Call call)
+{
+    SPI.sent.clear();
+    call();
+    return SPI.sent;
+}
+
+static void assertSameStream(const std::vector<uint16_t> &legacy, const std::vector<uint16_t> &panel)
+{
+    for (size_t i = 0; i < min(legacy.size(), panel.size()); i++)
+    {
+        if (legacy[i] != panel[i])
+        {
+            char message[64];
+            snprintf(message, sizeof(message), "byte %u: %03x instead of %03x", (unsigned int)i, panel[i], legacy[i]);
+            TEST_ASSERT_TRUE_MESSAGE(false, message);
+        }
+    }
+    TEST_ASSERT_EQUAL(legacy.size(), panel.size());
+}
+
+void test_init_and_sleep()
+{
+    LegacyEpd legacy;
+    Epd panel;
+    assertSameStream(sentBy([&]
+                            { legacy.Init(); }),
+                     sentBy([&]
+                            { panel.Init(); }));
+    assertSameStream(sentBy([&]
+                            { legacy.Sleep(); }),
+                     sentBy([&]
+                            { panel.Sleep(); }));
+}
+
+// One whole frame: black plane, then red plane and refresh
+void test_whole_frame()
+{
+    LegacyEpd legacy;
+    Epd panel;
+    std::vector<uint16_t> expected = sentBy([&]
+                                            { legacy.Displaypart(frame, 0, 0, EPD_WIDTH, EPD_HEIGHT, 0);
+                                              legacy.Displaypart(frame, 0, 0, EPD_WIDTH, EPD_HEIGHT, 1); });
+    TEST_ASSERT_EQUAL(2 * FRAME_BYTES + 4, expected.size());
+    assertSameStream(expected, sentBy([&]
+                                      { panel.Displaypart(frame, 0, 0, EPD_WIDTH, EPD_HEIGHT, 0);
+                                        panel.Displaypart(frame, 0, 0, EPD_WIDTH, EPD_HEIGHT, 1); }));
+}
+
+// Full-width bands, as the calendar body and the footer are sent
+void test_rows()
+{
+    LegacyEpd legacy;
+    Epd panel;
+    for (unsigned char block = 0; block < 2; block++)
+    {
+        assertSameStream(sentBy([&]
+                                { legacy.Displaypart(frame, 0, 100, EPD_WIDTH, 37, block); }),
+                         sentBy([&]
+                                { panel.Displaypart(frame, 0, 100, EPD_WIDTH, 37, block); }));
+    }
+}
+
+void test_windows()
+{
+    LegacyEpd legacy;
+    Epd panel;
+    for (int i = 0; i < 50; i++)
+    {
+        unsigned long x = (rand() % (EPD_WIDTH / 8)) * 8;
+        unsigned long width = (rand() % ((EPD_WIDTH - x) / 8) + 1) * 8;
+        unsigned long y = rand() % EPD_HEIGHT;
+        unsigned long height = rand() % (EPD_HEIGHT - y) + 1;
+        unsigned char block = i % 2;
+        assertSameStream(sentBy([&]
+                                { legacy.Displaypart(frame, x, y, width, height, block); }),
+                         sentBy([&]
+                                { panel.Displaypart(frame, x, y, width, height, block); }));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_init_and_sleep);
+    RUN_TEST(test_whole_frame);
+    RUN_TEST(test_rows);
+    RUN_TEST(test_windows);
+    return UNITY_END();
+}
@@ -0,0 +1,141 @@
+#include <Arduino.h>
+#include <SD_MMC.h>
+#include <unity.h>
+#include <climits>
+#include <random>
+
+#include "PCArena.h"
+#include "PCEvent.h"
+#include "PCEventIndex.h"
+
+#define NUMBER_OF_EVENTS 10000
+#define NUMBER_OF_QUERIES 2000
+#define SECONDS_IN_DAY 86400
+#define PARSED_EVENT_BYTES 64
+
+static std::mt19937 randomNumbers;
+
+void setUp()
+{
+    HostState::reset();
+    HostState::hasPSRAM = true;
+    PCArena::begin();
+    randomNumbers.seed(1);
+}
+
+void tearDown()
+{
+    PCEvent::releaseEvents();
+    PCArena::end();
+}
+
+static String eventBlock(int number)
+{
+    char block[160];
+    int month = 1 + randomNumbers() % 12;
+    int day = 1 + randomNumbers() % 28;
+    if (randomNumbers() % 2)
+    {
+        int days = randomNumbers() % 5;
+        snprintf(block, sizeof(block), "DTSTART;VALUE=DATE:2024%02d%02d\r\nDTEND;VALUE=DATE:2024%02d%02d\r\nSUMMARY:Event %d\r\n",
+                 month, day, month, day + days, number);
+    }
+    else
+    {
+        snprintf(block, sizeof(block), "DTSTART:2024%02d%02dT%02d%02d00Z\r\nSUMMARY:Event %d\r\n",
+                 month, day, (int)(randomNumbers() % 24), (int)(randomNumbers() % 60), number);
+    }
+    return String(block);
+}
+
+// Range queries of 10k events give what a scan of all of them gives
+void test_range_queries_match_a_scan()
+{
+    PCEventIndex index;
+    std::vector<std::pair<time_t, time_t>> ranges;
+    index.reserve(NUMBER_OF_EVENTS);
+    for (int i = 0; i < NUMBER_OF_EVENTS; i++)
+    {
+        PCEvent event(eventBlock(i), 9.0f);
+        index.add(event);
+        ranges.push_back(std::make_pair(event.getStartTime(), event.getEndTime()));
+    }
+
+    unsigned long indexMicros = 0;
+    unsigned long scanMicros = 0;
+    for (int i = 0; i < NUMBER_OF_QUERIES; i++)
+    {
+        time_t start = timeFromDate(2024, 1 + randomNumbers() % 12, 1 + randomNumbers() % 28);
+        time_t end = start + (1 + randomNumbers() % 7) * SECONDS_IN_DAY;
+        unsigned long startMicros = micros();
+        int found = index.numberOfEventsInRange(start, end);
+        indexMicros += micros() - startMicros;
+
+        startMicros = micros();
+        int scanned = 0;
+        for (auto &range : ranges)
+        {
+            scanned += (range.first < end && range.second > start) ? 1 : 0;
+        }
+        scanMicros += micros() - startMicros;
+        TEST_ASSERT_EQUAL(scanned, found);
+    }
+    char message[80];
+    snprintf(message, sizeof(message), "%d events: %.1f us per query, %.1f us per scan", NUMBER_OF_EVENTS,
+             (double)indexMicros / NUMBER_OF_QUERIES, (double)scanMicros / NUMBER_OF_QUERIES);
+    TEST_MESSAGE(message);
+}
+
+void test_events_across_the_range_edges()
+{
+    PCEventIndex index;
+    PCEvent event(String("DTSTART:20240510T100000Z\r\nDTEND:20240510T110000Z\r\nSUMMARY:Edge\r\n"), 0.0f);
+    index.add(event);
+    TEST_ASSERT_EQUAL(0, index.numberOfEventsInRange(event.getEndTime(), event.getEndTime() + 60));
+    TEST_ASSERT_EQUAL(0, index.numberOfEventsInRange(event.getStartTime() - 60, event.getStartTime()));
+    TEST_ASSERT_EQUAL(1, index.numberOfEventsInRange(event.getEndTime() - 1, event.getEndTime()));
+    TEST_ASSERT_EQUAL(1, index.numberOfEventsInRange(event.getStartTime() - 60, event.getStartTime() + 1));
+}
+
+// Occurrences of recurring events are counted before the index is sized,
+// so its array is allocated once and no old copy is left in the arena
+void test_recurring_events_do_not_grow_the_index()
+{
+    String feed = "BEGIN:VCALENDAR\r\n";
+    for (int i = 0; i < 40; i++)
+    {
+        feed += "BEGIN:VEVENT\r\nUID:daily" + String(i) + "\r\nDTSTART:20241001T" + String(10 + i % 10) + "0000Z\r\nRRULE:FREQ=DAILY\r\nSUMMARY:Daily " + String(i) + "\r\nEND:VEVENT\r\n";
+    }
+    for (int i = 0; i < 20; i++)
+    {
+        feed += "BEGIN:VEVENT\r\nUID:single" + String(i) + "\r\nDTSTART:202410" + String(10 + i) + "T120000Z\r\nSUMMARY:Single " + String(i) + "\r\nEND:VEVENT\r\n";
+    }
+    feed += "END:VCALENDAR\r\n";
+    File file = SD_MMC.open("/feed.ics", FILE_WRITE, true);
+    file.print(feed);
+    file.close();
+
+    tm today = {};
+    today.tm_year = 2024 - 1900;
+    today.tm_mon = 9;
+    today.tm_mday = 15;
+    PCEvent::setTimeinfo(today);
+    TEST_ASSERT_TRUE(PCEvent::loadICalendarFile("file:/feed.ics", false));
+    size_t usedBefore = PCArena::bytesUsed() + PCArena::overflowBytes();
+    PCEvent::buildEvents();
+    size_t added = PCArena::bytesUsed() + PCArena::overflowBytes() - usedBefore;
+
+    int numberOfEvents = PCEvent::numberOfEventsInRange(0, LONG_MAX);
+    TEST_ASSERT_GREATER_THAN(40 * 30, numberOfEvents);
+    // One array of events, and what parsing the 60 events keeps
+    TEST_ASSERT_LESS_OR_EQUAL(numberOfEvents * sizeof(PCEvent) + 60 * PARSED_EVENT_BYTES, added);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_range_queries_match_a_scan);
+    RUN_TEST(test_events_across_the_range_edges);
+    RUN_TEST(test_recurring_events_do_not_grow_the_index);
+    return UNITY_END();
+}
@@ -0,0 +1,124 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <random>
+
+#include "PCFrameKernels.h"
+
+#define NUMBER_OF_PLANES 60
+#define PANEL_ROW_BYTES 100
+#define PANEL_ROWS 480
+
+static std::mt19937 randomNumbers;
+
+void setUp()
+{
+    HostState::reset();
+    randomNumbers.seed(3);
+}
+
+void tearDown() {}
+
+// Mostly white with some ink, as a rendered calendar is, so there are runs
+// and literals for PackBits. The second plane differs in a few bits.
+static void fillPlanes(std::vector<uint8_t> &first, std::vector<uint8_t> &second)
+{
+    for (size_t i = 0; i < first.size(); i++)
+    {
+        first[i] = (randomNumbers() % 20 == 0) ? randomNumbers() : 0xFF;
+        second[i] = first[i];
+        if (randomNumbers() % 300 == 0)
+            second[i] ^= 1 << (randomNumbers() % 8);
+    }
+}
+
+void test_panel_planes_agree()
+{
+    std::vector<uint8_t> first(PANEL_ROW_BYTES * PANEL_ROWS);
+    std::vector<uint8_t> second(first.size());
+    fillPlanes(first, second);
+    HostState::quiet = false;
+    TEST_ASSERT_TRUE(PCFrameKernels::benchmark(first.data(), second.data(), PANEL_ROW_BYTES, PANEL_ROWS));
+}
+
+// Odd row widths and planes at each offset from a word boundary take the
+// byte heads and tails and the scalar fallback of xorDiff
+void test_unaligned_planes_agree()
+{
+    for (int i = 0; i < NUMBER_OF_PLANES; i++)
+    {
+        size_t rowBytes = (i % 3 == 0) ? PANEL_ROW_BYTES : 1 + randomNumbers() % 120;
+        int rows = 1 + randomNumbers() % PANEL_ROWS;
+        size_t offset = i % 4;
+        std::vector<uint8_t> first(rowBytes * rows + offset);
+        std::vector<uint8_t> second(first.size());
+        fillPlanes(first, second);
+        char message[48];
+        snprintf(message, sizeof(message), "%u x %d at offset %u", (unsigned int)rowBytes, rows, (unsigned int)offset);
+        TEST_ASSERT_TRUE_MESSAGE(PCFrameKernels::benchmark(first.data() + offset, second.data() + offset, rowBytes, rows), message);
+    }
+}
+
+void test_hash_of_odd_lengths()
+{
+    std::vector<uint8_t> data(64 + 4);
+    for (auto &b : data)
+        b = randomNumbers();
+    for (size_t offset = 0; offset < 4; offset++)
+    {
+        for (size_t length = 0; length <= 64; length++)
+        {
+            TEST_ASSERT_TRUE(PCFrameKernels::hash64(data.data() + offset, length) == PCFrameKernels::hash64Scalar(data.data() + offset, length));
+        }
+    }
+    // The length is mixed in, so trailing zeros change the hash
+    uint8_t zeros[9] = {};
+    TEST_ASSERT_TRUE(PCFrameKernels::hash64(zeros, 8) != PCFrameKernels::hash64(zeros, 9));
+}
+
+void test_runs_round_trip()
+{
+    std::vector<uint8_t> plane(1000);
+    for (size_t i = 0; i < plane.size(); i++)
+        plane[i] = (i / 200 % 2) ? randomNumbers() : 0xFF;
+    std::vector<uint8_t> encoded(PCFrameKernels::maxEncodedLength(plane.size()));
+    size_t size = PCFrameKernels::encodeRuns(plane.data(), plane.size(), encoded.data());
+    std::vector<uint8_t> decoded(plane.size());
+    TEST_ASSERT_TRUE(PCFrameKernels::decodeRuns(encoded.data(), size, decoded.data(), decoded.size()));
+    TEST_ASSERT_EQUAL_MEMORY(plane.data(), decoded.data(), plane.size());
+    // Truncated input fails instead of leaving part of the plane stale
+    TEST_ASSERT_FALSE(PCFrameKernels::decodeRuns(encoded.data(), size - 1, decoded.data(), decoded.size()));
+}
+
+// Runs of every length up to past the 128 byte limit, at each offset from
+// a word boundary, end inside and at the edges of the words skipped whole
+void test_runs_agree_with_scalar()
+{
+    std::vector<uint8_t> plane(4000 + 4);
+    for (size_t i = 0; i < plane.size();)
+    {
+        size_t run = 1 + randomNumbers() % 300;
+        uint8_t value = (randomNumbers() % 2) ? 0xFF : randomNumbers();
+        for (; run > 0 && i < plane.size(); run--)
+            plane[i++] = value;
+    }
+    std::vector<uint8_t> encoded(PCFrameKernels::maxEncodedLength(plane.size()));
+    std::vector<uint8_t> reference(encoded.size());
+    for (size_t offset = 0; offset < 4; offset++)
+    {
+        size_t length = plane.size() - offset;
+        size_t size = PCFrameKernels::encodeRuns(plane.data() + offset, length, encoded.data());
+        TEST_ASSERT_EQUAL(PCFrameKernels::encodeRunsScalar(plane.data() + offset, length, reference.data()), size);
+        TEST_ASSERT_EQUAL_MEMORY(reference.data(), encoded.data(), size);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_panel_planes_agree);
+    RUN_TEST(test_unaligned_planes_agree);
+    RUN_TEST(test_hash_of_odd_lengths);
+    RUN_TEST(test_runs_round_trip);
+    RUN_TEST(test_runs_agree_with_scalar);
+    return UNITY_END();
+}
@@ -0,0 +1,908 @@
+#ifndef HOLIDAYS_2000_2050_H_INCLUDE
+#define HOLIDAYS_2000_2050_H_INCLUDE
+
+// Japanese public holidays from 2000 to 2050, "YYYYMMDD Name", generated
+// with the Python holidays package 0.106, independent of PCHoliday:
+//   holidays.country_holidays('JP', years=range(2000, 2051), language='ja')
+// Later years follow the current law and the equinox approximation of the
+// package. The special days of 2019 to 2021 and the citizens' holidays are
+// also checked one by one in test_main.cpp.
+static const char *expectedHolidays[] = {
+    "20000101 元日",
+    "20000110 成人の日",
+    "20000211 建国記念の日",
+    "20000320 春分の日",
+    "20000429 みどりの日",
+    "20000503 憲法記念日",
+    "20000504 国民の休日",
+    "20000505 こどもの日",
+    "20000720 海の日",
+    "20000915 敬老の日",
+    "20000923 秋分の日",
+    "20001009 体育の日",
+    "20001103 文化の日",
+    "20001123 勤労感謝の日",
+    "20001223 天皇誕生日",
+    "20010101 元日",
+    "20010108 成人の日",
+    "20010211 建国記念の日",
+    "20010212 振替休日",
+    "20010320 春分の日",
+    "20010429 みどりの日",
+    "20010430 振替休日",
+    "20010503 憲法記念日",
+    "20010504 国民の休日",
+    "20010505 こどもの日",
+    "20010720 海の日",
+    "20010915 敬老の日",
+    "20010923 秋分の日",
+    "20010924 振替休日",
+    "20011008 体育の日",
+    "20011103 文化の日",
+    "20011123 勤労感謝の日",
+    "20011223 天皇誕生日",
+    "20011224 振替休日",
+    "20020101 元日",
+    "20020114 成人の日",
+    "20020211 建国記念の日",
+    "20020321 春分の日",
+    "20020429 みどりの日",
+    "20020503 憲法記念日",
+    "20020504 国民の休日",
+    "20020505 こどもの日",
+    "20020506 振替休日",
+    "20020720 海の日",
+    "20020915 敬老の日",
+    "20020916 振替休日",
+    "20020923 秋分の日",
+    "20021014 体育の日",
+    "20021103 文化の日",
+    "20021104 振替休日",
+    "20021123 勤労感謝の日",
+    "20021223 天皇誕生日",
+    "20030101 元日",
+    "20030113 成人の日",
+    "20030211 建国記念の日",
+    "20030321 春分の日",
+    "20030429 みどりの日",
+    "20030503 憲法記念日",
+    "20030505 こどもの日",
+    "20030721 海の日",
+    "20030915 敬老の日",
+    "20030923 秋分の日",
+    "20031013 体育の日",
+    "20031103 文化の日",
+    "20031123 勤労感謝の日",
+    "20031124 振替休日",
+    "20031223 天皇誕生日",
+    "20040101 元日",
+    "20040112 成人の日",
+    "20040211 建国記念の日",
+    "20040320 春分の日",
+    "20040429 みどりの日",
+    "20040503 憲法記念日",
+    "20040504 国民の休日",
+    "20040505 こどもの日",
+    "20040719 海の日",
+    "20040920 敬老の日",
+    "20040923 秋分の日",
+    "20041011 体育の日",
+    "20041103 文化の日",
+    "20041123 勤労感謝の日",
+    "20041223 天皇誕生日",
+    "20050101 元日",
+    "20050110 成人の日",
+    "20050211 建国記念の日",
+    "20050320 春分の日",
+    "20050321 振替休日",
+    "20050429 みどりの日",
+    "20050503 憲法記念日",
+    "20050504 国民の休日",
+    "20050505 こどもの日",
+    "20050718 海の日",
+    "20050919 敬老の日",
+    "20050923 秋分の日",
+    "20051010 体育の日",
+    "20051103 文化の日",
+    "20051123 勤労感謝の日",
+    "20051223 天皇誕生日",
+    "20060101 元日",
+    "20060102 振替休日",
+    "20060109 成人の日",
+    "20060211 建国記念の日",
+    "20060321 春分の日",
+    "20060429 みどりの日",
+    "20060503 憲法記念日",
+    "20060504 国民の休日",
+    "20060505 こどもの日",
+    "20060717 海の日",
+    "20060918 敬老の日",
+    "20060923 秋分の日",
+    "20061009 体育の日",
+    "20061103 文化の日",
+    "20061123 勤労感謝の日",
+    "20061223 天皇誕生日",
+    "20070101 元日",
+    "20070108 成人の日",
+    "20070211 建国記念の日",
+    "20070212 振替休日",
+    "20070321 春分の日",
+    "20070429 昭和の日",
+    "20070430 振替休日",
+    "20070503 憲法記念日",
+    "20070504 みどりの日",
+    "20070505 こどもの日",
+    "20070716 海の日",
+    "20070917 敬老の日",
+    "20070923 秋分の日",
+    "20070924 振替休日",
+    "20071008 体育の日",
+    "20071103 文化の日",
+    "20071123 勤労感謝の日",
+    "20071223 天皇誕生日",
+    "20071224 振替休日",
+    "20080101 元日",
+    "20080114 成人の日",
+    "20080211 建国記念の日",
+    "20080320 春分の日",
+    "20080429 昭和の日",
+    "20080503 憲法記念日",
+    "20080504 みどりの日",
+    "20080505 こどもの日",
+    "20080506 振替休日",
+    "20080721 海の日",
+    "20080915 敬老の日",
+    "20080923 秋分の日",
+    "20081013 体育の日",
+    "20081103 文化の日",
+    "20081123 勤労感謝の日",
+    "20081124 振替休日",
+    "20081223 天皇誕生日",
+    "20090101 元日",
+    "20090112 成人の日",
+    "20090211 建国記念の日",
+    "20090320 春分の日",
+    "20090429 昭和の日",
+    "20090503 憲法記念日",
+    "20090504 みどりの日",
+    "20090505 こどもの日",
+    "20090506 振替休日",
+    "20090720 海の日",
+    "20090921 敬老の日",
+    "20090922 国民の休日",
+    "20090923 秋分の日",
+    "20091012 体育の日",
+    "20091103 文化の日",
+    "20091123 勤労感謝の日",
+    "20091223 天皇誕生日",
+    "20100101 元日",
+    "20100111 成人の日",
+    "20100211 建国記念の日",
+    "20100321 春分の日",
+    "20100322 振替休日",
+    "20100429 昭和の日",
+    "20100503 憲法記念日",
+    "20100504 みどりの日",
+    "20100505 こどもの日",
+    "20100719 海の日",
+    "20100920 敬老の日",
+    "20100923 秋分の日",
+    "20101011 体育の日",
+    "20101103 文化の日",
+    "20101123 勤労感謝の日",
+    "20101223 天皇誕生日",
+    "20110101 元日",
+    "20110110 成人の日",
+    "20110211 建国記念の日",
+    "20110321 春分の日",
+    "20110429 昭和の日",
+    "20110503 憲法記念日",
+    "20110504 みどりの日",
+    "20110505 こどもの日",
+    "20110718 海の日",
+    "20110919 敬老の日",
+    "20110923 秋分の日",
+    "20111010 体育の日",
+    "20111103 文化の日",
+    "20111123 勤労感謝の日",
+    "20111223 天皇誕生日",
+    "20120101 元日",
+    "20120102 振替休日",
+    "20120109 成人の日",
+    "20120211 建国記念の日",
+    "20120320 春分の日",
+    "20120429 昭和の日",
+    "20120430 振替休日",
+    "20120503 憲法記念日",
+    "20120504 みどりの日",
+    "20120505 こどもの日",
+    "20120716 海の日",
+    "20120917 敬老の日",
+    "20120922 秋分の日",
+    "20121008 体育の日",
+    "20121103 文化の日",
+    "20121123 勤労感謝の日",
+    "20121223 天皇誕生日",
+    "20121224 振替休日",
+    "20130101 元日",
+    "20130114 成人の日",
+    "20130211 建国記念の日",
+    "20130320 春分の日",
+    "20130429 昭和の日",
+    "20130503 憲法記念日",
+    "20130504 みどりの日",
+    "20130505 こどもの日",
+    "20130506 振替休日",
+    "20130715 海の日",
+    "20130916 敬老の日",
+    "20130923 秋分の日",
+    "20131014 体育の日",
+    "20131103 文化の日",
+    "20131104 振替休日",
+    "20131123 勤労感謝の日",
+    "20131223 天皇誕生日",
+    "20140101 元日",
+    "20140113 成人の日",
+    "20140211 建国記念の日",
+    "20140321 春分の日",
+    "20140429 昭和の日",
+    "20140503 憲法記念日",
+    "20140504 みどりの日",
+    "20140505 こどもの日",
+    "20140506 振替休日",
+    "20140721 海の日",
+    "20140915 敬老の日",
+    "20140923 秋分の日",
+    "20141013 体育の日",
+    "20141103 文化の日",
+    "20141123 勤労感謝の日",
+    "20141124 振替休日",
+    "20141223 天皇誕生日",
+    "20150101 元日",
+    "20150112 成人の日",
+    "20150211 建国記念の日",
+    "20150321 春分の日",
+    "20150429 昭和の日",
+    "20150503 憲法記念日",
+    "20150504 みどりの日",
+    "20150505 こどもの日",
+    "20150506 振替休日",
+    "20150720 海の日",
+    "20150921 敬老の日",
+    "20150922 国民の休日",
+    "20150923 秋分の日",
+    "20151012 体育の日",
+    "20151103 文化の日",
+    "20151123 勤労感謝の日",
+    "20151223 天皇誕生日",
+    "20160101 元日",
+    "20160111 成人の日",
+    "20160211 建国記念の日",
+    "20160320 春分の日",
+    "20160321 振替休日",
+    "20160429 昭和の日",
+    "20160503 憲法記念日",
+    "20160504 みどりの日",
+    "20160505 こどもの日",
+    "20160718 海の日",
+    "20160811 山の日",
+    "20160919 敬老の日",
+    "20160922 秋分の日",
+    "20161010 体育の日",
+    "20161103 文化の日",
+    "20161123 勤労感謝の日",
+    "20161223 天皇誕生日",
+    "20170101 元日",
+    "20170102 振替休日",
+    "20170109 成人の日",
+    "20170211 建国記念の日",
+    "20170320 春分の日",
+    "20170429 昭和の日",
+    "20170503 憲法記念日",
+    "20170504 みどりの日",
+    "20170505 こどもの日",
+    "20170717 海の日",
+    "20170811 山の日",
+    "20170918 敬老の日",
+    "20170923 秋分の日",
+    "20171009 体育の日",
+    "20171103 文化の日",
+    "20171123 勤労感謝の日",
+    "20171223 天皇誕生日",
+    "20180101 元日",
+    "20180108 成人の日",
+    "20180211 建国記念の日",
+    "20180212 振替休日",
+    "20180321 春分の日",
+    "20180429 昭和の日",
+    "20180430 振替休日",
+    "20180503 憲法記念日",
+    "20180504 みどりの日",
+    "20180505 こどもの日",
+    "20180716 海の日",
+    "20180811 山の日",
+    "20180917 敬老の日",
+    "20180923 秋分の日",
+    "20180924 振替休日",
+    "20181008 体育の日",
+    "20181103 文化の日",
+    "20181123 勤労感謝の日",
+    "20181223 天皇誕生日",
+    "20181224 振替休日",
+    "20190101 元日",
+    "20190114 成人の日",
+    "20190211 建国記念の日",
+    "20190321 春分の日",
+    "20190429 昭和の日",
+    "20190430 国民の休日",
+    "20190501 天皇の即位の日",
+    "20190502 国民の休日",
+    "20190503 憲法記念日",
+    "20190504 みどりの日",
+    "20190505 こどもの日",
+    "20190506 振替休日",
+    "20190715 海の日",
+    "20190811 山の日",
+    "20190812 振替休日",
+    "20190916 敬老の日",
+    "20190923 秋分の日",
+    "20191014 体育の日",
+    "20191022 即位礼正殿の儀が行われる日",
+    "20191103 文化の日",
+    "20191104 振替休日",
+    "20191123 勤労感謝の日",
+    "20200101 元日",
+    "20200113 成人の日",
+    "20200211 建国記念の日",
+    "20200223 天皇誕生日",
+    "20200224 振替休日",
+    "20200320 春分の日",
+    "20200429 昭和の日",
+    "20200503 憲法記念日",
+    "20200504 みどりの日",
+    "20200505 こどもの日",
+    "20200506 振替休日",
+    "20200723 海の日",
+    "20200724 スポーツの日",
+    "20200810 山の日",
+    "20200921 敬老の日",
+    "20200922 秋分の日",
+    "20201103 文化の日",
+    "20201123 勤労感謝の日",
+    "20210101 元日",
+    "20210111 成人の日",
+    "20210211 建国記念の日",
+    "20210223 天皇誕生日",
+    "20210320 春分の日",
+    "20210429 昭和の日",
+    "20210503 憲法記念日",
+    "20210504 みどりの日",
+    "20210505 こどもの日",
+    "20210722 海の日",
+    "20210723 スポーツの日",
+    "20210808 山の日",
+    "20210809 振替休日",
+    "20210920 敬老の日",
+    "20210923 秋分の日",
+    "20211103 文化の日",
+    "20211123 勤労感謝の日",
+    "20220101 元日",
+    "20220110 成人の日",
+    "20220211 建国記念の日",
+    "20220223 天皇誕生日",
+    "20220321 春分の日",
+    "20220429 昭和の日",
+    "20220503 憲法記念日",
+    "20220504 みどりの日",
+    "20220505 こどもの日",
+    "20220718 海の日",
+    "20220811 山の日",
+    "20220919 敬老の日",
+    "20220923 秋分の日",
+    "20221010 スポーツの日",
+    "20221103 文化の日",
+    "20221123 勤労感謝の日",
+    "20230101 元日",
+    "20230102 振替休日",
+    "20230109 成人の日",
+    "20230211 建国記念の日",
+    "20230223 天皇誕生日",
+    "20230321 春分の日",
+    "20230429 昭和の日",
+    "20230503 憲法記念日",
+    "20230504 みどりの日",
+    "20230505 こどもの日",
+    "20230717 海の日",
+    "20230811 山の日",
+    "20230918 敬老の日",
+    "20230923 秋分の日",
+    "20231009 スポーツの日",
+    "20231103 文化の日",
+    "20231123 勤労感謝の日",
+    "20240101 元日",
+    "20240108 成人の日",
+    "20240211 建国記念の日",
+    "20240212 振替休日",
+    "20240223 天皇誕生日",
+    "20240320 春分の日",
+    "20240429 昭和の日",
+    "20240503 憲法記念日",
+    "20240504 みどりの日",
+    "20240505 こどもの日",
+    "20240506 振替休日",
+    "20240715 海の日",
+    "20240811 山の日",
+    "20240812 振替休日",
+    "20240916 敬老の日",
+    "20240922 秋分の日",
+    "20240923 振替休日",
+    "20241014 スポーツの日",
+    "20241103 文化の日",
+    "20241104 振替休日",
+    "20241123 勤労感謝の日",
+    "20250101 元日",
+    "20250113 成人の日",
+    "20250211 建国記念の日",
+    "20250223 天皇誕生日",
+    "20250224 振替休日",
+    "20250320 春分の日",
+    "20250429 昭和の日",
+    "20250503 憲法記念日",
+    "20250504 みどりの日",
+    "20250505 こどもの日",
+    "20250506 振替休日",
+    "20250721 海の日",
+    "20250811 山の日",
+    "20250915 敬老の日",
+    "20250923 秋分の日",
+    "20251013 スポーツの日",
+    "20251103 文化の日",
+    "20251123 勤労感謝の日",
+    "20251124 振替休日",
+    "20260101 元日",
+    "20260112 成人の日",
+    "20260211 建国記念の日",
+    "20260223 天皇誕生日",
+    "20260320 春分の日",
+    "20260429 昭和の日",
+    "20260503 憲法記念日",
+    "20260504 みどりの日",
+    "20260505 こどもの日",
+    "20260506 振替休日",
+    "20260720 海の日",
+    "20260811 山の日",
+    "20260921 敬老の日",
+    "20260922 国民の休日",
+    "20260923 秋分の日",
+    "20261012 スポーツの日",
+    "20261103 文化の日",
+    "20261123 勤労感謝の日",
+    "20270101 元日",
+    "20270111 成人の日",
+    "20270211 建国記念の日",
+    "20270223 天皇誕生日",
+    "20270321 春分の日",
+    "20270322 振替休日",
+    "20270429 昭和の日",
+    "20270503 憲法記念日",
+    "20270504 みどりの日",
+    "20270505 こどもの日",
+    "20270719 海の日",
+    "20270811 山の日",
+    "20270920 敬老の日",
+    "20270923 秋分の日",
+    "20271011 スポーツの日",
+    "20271103 文化の日",
+    "20271123 勤労感謝の日",
+    "20280101 元日",
+    "20280110 成人の日",
+    "20280211 建国記念の日",
+    "20280223 天皇誕生日",
+    "20280320 春分の日",
+    "20280429 昭和の日",
+    "20280503 憲法記念日",
+    "20280504 みどりの日",
+    "20280505 こどもの日",
+    "20280717 海の日",
+    "20280811 山の日",
+    "20280918 敬老の日",
+    "20280922 秋分の日",
+    "20281009 スポーツの日",
+    "20281103 文化の日",
+    "20281123 勤労感謝の日",
+    "20290101 元日",
+    "20290108 成人の日",
+    "20290211 建国記念の日",
+    "20290212 振替休日",
+    "20290223 天皇誕生日",
+    "20290320 春分の日",
+    "20290429 昭和の日",
+    "20290430 振替休日",
+    "20290503 憲法記念日",
+    "20290504 みどりの日",
+    "20290505 こどもの日",
+    "20290716 海の日",
+    "20290811 山の日",
+    "20290917 敬老の日",
+    "20290923 秋分の日",
+    "20290924 振替休日",
+    "20291008 スポーツの日",
+    "20291103 文化の日",
+    "20291123 勤労感謝の日",
+    "20300101 元日",
+    "20300114 成人の日",
+    "20300211 建国記念の日",
+    "20300223 天皇誕生日",
+    "20300320 春分の日",
+    "20300429 昭和の日",
+    "20300503 憲法記念日",
+    "20300504 みどりの日",
+    "20300505 こどもの日",
+    "20300506 振替休日",
+    "20300715 海の日",
+    "20300811 山の日",
+    "20300812 振替休日",
+    "20300916 敬老の日",
+    "20300923 秋分の日",
+    "20301014 スポーツの日",
+    "20301103 文化の日",
+    "20301104 振替休日",
+    "20301123 勤労感謝の日",
+    "20310101 元日",
+    "20310113 成人の日",
+    "20310211 建国記念の日",
+    "20310223 天皇誕生日",
+    "20310224 振替休日",
+    "20310321 春分の日",
+    "20310429 昭和の日",
+    "20310503 憲法記念日",
+    "20310504 みどりの日",
+    "20310505 こどもの日",
+    "20310506 振替休日",
+    "20310721 海の日",
+    "20310811 山の日",
+    "20310915 敬老の日",
+    "20310923 秋分の日",
+    "20311013 スポーツの日",
+    "20311103 文化の日",
+    "20311123 勤労感謝の日",
+    "20311124 振替休日",
+    "20320101 元日",
+    "20320112 成人の日",
+    "20320211 建国記念の日",
+    "20320223 天皇誕生日",
+    "20320320 春分の日",
+    "20320429 昭和の日",
+    "20320503 憲法記念日",
+    "20320504 みどりの日",
+    "20320505 こどもの日",
+    "20320719 海の日",
+    "20320811 山の日",
+    "20320920 敬老の日",
+    "20320921 国民の休日",
+    "20320922 秋分の日",
+    "20321011 スポーツの日",
+    "20321103 文化の日",
+    "20321123 勤労感謝の日",
+    "20330101 元日",
+    "20330110 成人の日",
+    "20330211 建国記念の日",
+    "20330223 天皇誕生日",
+    "20330320 春分の日",
+    "20330321 振替休日",
+    "20330429 昭和の日",
+    "20330503 憲法記念日",
+    "20330504 みどりの日",
+    "20330505 こどもの日",
+    "20330718 海の日",
+    "20330811 山の日",
+    "20330919 敬老の日",
+    "20330923 秋分の日",
+    "20331010 スポーツの日",
+    "20331103 文化の日",
+    "20331123 勤労感謝の日",
+    "20340101 元日",
+    "20340102 振替休日",
+    "20340109 成人の日",
+    "20340211 建国記念の日",
+    "20340223 天皇誕生日",
+    "20340320 春分の日",
+    "20340429 昭和の日",
+    "20340503 憲法記念日",
+    "20340504 みどりの日",
+    "20340505 こどもの日",
+    "20340717 海の日",
+    "20340811 山の日",
+    "20340918 敬老の日",
+    "20340923 秋分の日",
+    "20341009 スポーツの日",
+    "20341103 文化の日",
+    "20341123 勤労感謝の日",
+    "20350101 元日",
+    "20350108 成人の日",
+    "20350211 建国記念の日",
+    "20350212 振替休日",
+    "20350223 天皇誕生日",
+    "20350321 春分の日",
+    "20350429 昭和の日",
+    "20350430 振替休日",
+    "20350503 憲法記念日",
+    "20350504 みどりの日",
+    "20350505 こどもの日",
+    "20350716 海の日",
+    "20350811 山の日",
+    "20350917 敬老の日",
+    "20350923 秋分の日",
+    "20350924 振替休日",
+    "20351008 スポーツの日",
+    "20351103 文化の日",
+    "20351123 勤労感謝の日",
+    "20360101 元日",
+    "20360114 成人の日",
+    "20360211 建国記念の日",
+    "20360223 天皇誕生日",
+    "20360320 春分の日",
+    "20360429 昭和の日",
+    "20360503 憲法記念日",
+    "20360504 みどりの日",
+    "20360505 こどもの日",
+    "20360506 振替休日",
+    "20360721 海の日",
+    "20360811 山の日",
+    "20360915 敬老の日",
+    "20360922 秋分の日",
+    "20361013 スポーツの日",
+    "20361103 文化の日",
+    "20361123 勤労感謝の日",
+    "20361124 振替休日",
+    "20370101 元日",
+    "20370112 成人の日",
+    "20370211 建国記念の日",
+    "20370223 天皇誕生日",
+    "20370320 春分の日",
+    "20370429 昭和の日",
+    "20370503 憲法記念日",
+    "20370504 みどりの日",
+    "20370505 こどもの日",
+    "20370506 振替休日",
+    "20370720 海の日",
+    "20370811 山の日",
+    "20370921 敬老の日",
+    "20370922 国民の休日",
+    "20370923 秋分の日",
+    "20371012 スポーツの日",
+    "20371103 文化の日",
+    "20371123 勤労感謝の日",
+    "20380101 元日",
+    "20380111 成人の日",
+    "20380211 建国記念の日",
+    "20380223 天皇誕生日",
+    "20380320 春分の日",
+    "20380429 昭和の日",
+    "20380503 憲法記念日",
+    "20380504 みどりの日",
+    "20380505 こどもの日",
+    "20380719 海の日",
+    "20380811 山の日",
+    "20380920 敬老の日",
+    "20380923 秋分の日",
+    "20381011 スポーツの日",
+    "20381103 文化の日",
+    "20381123 勤労感謝の日",
+    "20390101 元日",
+    "20390110 成人の日",
+    "20390211 建国記念の日",
+    "20390223 天皇誕生日",
+    "20390321 春分の日",
+    "20390429 昭和の日",
+    "20390503 憲法記念日",
+    "20390504 みどりの日",
+    "20390505 こどもの日",
+    "20390718 海の日",
+    "20390811 山の日",
+    "20390919 敬老の日",
+    "20390923 秋分の日",
+    "20391010 スポーツの日",
+    "20391103 文化の日",
+    "20391123 勤労感謝の日",
+    "20400101 元日",
+    "20400102 振替休日",
+    "20400109 成人の日",
+    "20400211 建国記念の日",
+    "20400223 天皇誕生日",
+    "20400320 春分の日",
+    "20400429 昭和の日",
+    "20400430 振替休日",
+    "20400503 憲法記念日",
+    "20400504 みどりの日",
+    "20400505 こどもの日",
+    "20400716 海の日",
+    "20400811 山の日",
+    "20400917 敬老の日",
+    "20400922 秋分の日",
+    "20401008 スポーツの日",
+    "20401103 文化の日",
+    "20401123 勤労感謝の日",
+    "20410101 元日",
+    "20410114 成人の日",
+    "20410211 建国記念の日",
+    "20410223 天皇誕生日",
+    "20410320 春分の日",
+    "20410429 昭和の日",
+    "20410503 憲法記念日",
+    "20410504 みどりの日",
+    "20410505 こどもの日",
+    "20410506 振替休日",
+    "20410715 海の日",
+    "20410811 山の日",
+    "20410812 振替休日",
+    "20410916 敬老の日",
+    "20410923 秋分の日",
+    "20411014 スポーツの日",
+    "20411103 文化の日",
+    "20411104 振替休日",
+    "20411123 勤労感謝の日",
+    "20420101 元日",
+    "20420113 成人の日",
+    "20420211 建国記念の日",
+    "20420223 天皇誕生日",
+    "20420224 振替休日",
+    "20420320 春分の日",
+    "20420429 昭和の日",
+    "20420503 憲法記念日",
+    "20420504 みどりの日",
+    "20420505 こどもの日",
+    "20420506 振替休日",
+    "20420721 海の日",
+    "20420811 山の日",
+    "20420915 敬老の日",
+    "20420923 秋分の日",
+    "20421013 スポーツの日",
+    "20421103 文化の日",
+    "20421123 勤労感謝の日",
+    "20421124 振替休日",
+    "20430101 元日",
+    "20430112 成人の日",
+    "20430211 建国記念の日",
+    "20430223 天皇誕生日",
+    "20430321 春分の日",
+    "20430429 昭和の日",
+    "20430503 憲法記念日",
+    "20430504 みどりの日",
+    "20430505 こどもの日",
+    "20430506 振替休日",
+    "20430720 海の日",
+    "20430811 山の日",
+    "20430921 敬老の日",
+    "20430922 国民の休日",
+    "20430923 秋分の日",
+    "20431012 スポーツの日",
+    "20431103 文化の日",
+    "20431123 勤労感謝の日",
+    "20440101 元日",
+    "20440111 成人の日",
+    "20440211 建国記念の日",
+    "20440223 天皇誕生日",
+    "20440320 春分の日",
+    "20440321 振替休日",
+    "20440429 昭和の日",
+    "20440503 憲法記念日",
+    "20440504 みどりの日",
+    "20440505 こどもの日",
+    "20440718 海の日",
+    "20440811 山の日",
+    "20440919 敬老の日",
+    "20440922 秋分の日",
+    "20441010 スポーツの日",
+    "20441103 文化の日",
+    "20441123 勤労感謝の日",
+    "20450101 元日",
+    "20450102 振替休日",
+    "20450109 成人の日",
+    "20450211 建国記念の日",
+    "20450223 天皇誕生日",
+    "20450320 春分の日",
+    "20450429 昭和の日",
+    "20450503 憲法記念日",
+    "20450504 みどりの日",
+    "20450505 こどもの日",
+    "20450717 海の日",
+    "20450811 山の日",
+    "20450918 敬老の日",
+    "20450922 秋分の日",
+    "20451009 スポーツの日",
+    "20451103 文化の日",
+    "20451123 勤労感謝の日",
+    "20460101 元日",
+    "20460108 成人の日",
+    "20460211 建国記念の日",
+    "20460212 振替休日",
+    "20460223 天皇誕生日",
+    "20460320 春分の日",
+    "20460429 昭和の日",
+    "20460430 振替休日",
+    "20460503 憲法記念日",
+    "20460504 みどりの日",
+    "20460505 こどもの日",
+    "20460716 海の日",
+    "20460811 山の日",
+    "20460917 敬老の日",
+    "20460923 秋分の日",
+    "20460924 振替休日",
+    "20461008 スポーツの日",
+    "20461103 文化の日",
+    "20461123 勤労感謝の日",
+    "20470101 元日",
+    "20470114 成人の日",
+    "20470211 建国記念の日",
+    "20470223 天皇誕生日",
+    "20470321 春分の日",
+    "20470429 昭和の日",
+    "20470503 憲法記念日",
+    "20470504 みどりの日",
+    "20470505 こどもの日",
+    "20470506 振替休日",
+    "20470715 海の日",
+    "20470811 山の日",
+    "20470812 振替休日",
+    "20470916 敬老の日",
+    "20470923 秋分の日",
+    "20471014 スポーツの日",
+    "20471103 文化の日",
+    "20471104 振替休日",
+    "20471123 勤労感謝の日",
+    "20480101 元日",
+    "20480113 成人の日",
+    "20480211 建国記念の日",
+    "20480223 天皇誕生日",
+    "20480224 振替休日",
+    "20480320 春分の日",
+    "20480429 昭和の日",
+    "20480503 憲法記念日",
+    "20480504 みどりの日",
+    "20480505 こどもの日",
+    "20480506 振替休日",
+    "20480720 海の日",
+    "20480811 山の日",
+    "20480921 敬老の日",
+    "20480922 秋分の日",
+    "20481012 スポーツの日",
+    "20481103 文化の日",
+    "20481123 勤労感謝の日",
+    "20490101 元日",
+    "20490111 成人の日",
+    "20490211 建国記念の日",
+    "20490223 天皇誕生日",
+    "20490320 春分の日",
+    "20490429 昭和の日",
+    "20490503 憲法記念日",
+    "20490504 みどりの日",
+    "20490505 こどもの日",
+    "20490719 海の日",
+    "20490811 山の日",
+    "20490920 敬老の日",
+    "20490921 国民の休日",
+    "20490922 秋分の日",
+    "20491011 スポーツの日",
+    "20491103 文化の日",
+    "20491123 勤労感謝の日",
+    "20500101 元日",
+    "20500110 成人の日",
+    "20500211 建国記念の日",
+    "20500223 天皇誕生日",
+    "20500320 春分の日",
+    "20500321 振替休日",
+    "20500429 昭和の日",
+    "20500503 憲法記念日",
+    "20500504 みどりの日",
+    "20500505 こどもの日",
+    "20500718 海の日",
+    "20500811 山の日",
+    "20500919 敬老の日",
+    "20500923 秋分の日",
+    "20501010 スポーツの日",
+    "20501103 文化の日",
+    "20501123 勤労感謝の日",
+};
+
+#endif
@@ -0,0 +1,114 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include "PCHoliday.h"
+#include "holidays_2000_2050.h"
+
+#define CITIZENS_HOLIDAY "国民の休日"
+#define SUBSTITUTE_HOLIDAY "振替休日"
+
+void setUp()
+{
+    HostState::reset();
+    PCHoliday::setOverrides("");
+}
+
+void tearDown() {}
+
+void test_holidays_from_2000_to_2050()
+{
+    std::vector<String> computed;
+    PCHolidayDate dates[MAX_HOLIDAYS_IN_YEAR];
+    for (int year = 2000; year <= 2050; year++)
+    {
+        int count = PCHoliday::holidaysInYear(year, dates, MAX_HOLIDAYS_IN_YEAR);
+        for (int i = 0; i < count; i++)
+        {
+            char date[12];
+            snprintf(date, sizeof(date), "%04d%02d%02d ", year, dates[i].month, dates[i].day);
+            computed.push_back(String(date) + dates[i].name);
+        }
+    }
+    size_t expectedCount = sizeof(expectedHolidays) / sizeof(expectedHolidays[0]);
+    for (size_t i = 0; i < min(computed.size(), expectedCount); i++)
+    {
+        TEST_ASSERT_EQUAL_STRING(expectedHolidays[i], computed[i].c_str());
+    }
+    TEST_ASSERT_EQUAL(expectedCount, computed.size());
+}
+
+// Days around the enthronement in 2019
+void test_enthronement_days_of_2019()
+{
+    TEST_ASSERT_EQUAL_STRING(CITIZENS_HOLIDAY, PCHoliday::nameOfDay(2019, 4, 30));
+    TEST_ASSERT_EQUAL_STRING("天皇の即位の日", PCHoliday::nameOfDay(2019, 5, 1));
+    TEST_ASSERT_EQUAL_STRING(CITIZENS_HOLIDAY, PCHoliday::nameOfDay(2019, 5, 2));
+    TEST_ASSERT_EQUAL_STRING(SUBSTITUTE_HOLIDAY, PCHoliday::nameOfDay(2019, 5, 6));
+    TEST_ASSERT_EQUAL_STRING("即位礼正殿の儀が行われる日", PCHoliday::nameOfDay(2019, 10, 22));
+    // No Emperor's Birthday in 2019, the new one is on February 23
+    TEST_ASSERT_NULL(PCHoliday::nameOfDay(2019, 12, 23));
+    TEST_ASSERT_EQUAL_STRING("天皇誕生日", PCHoliday::nameOfDay(2018, 12, 23));
+    TEST_ASSERT_EQUAL_STRING("天皇誕生日", PCHoliday::nameOfDay(2020, 2, 23));
+}
+
+// Marine Day, Sports Day and Mountain Day were moved for the Olympics
+void test_olympic_days_of_2020_and_2021()
+{
+    TEST_ASSERT_EQUAL_STRING("海の日", PCHoliday::nameOfDay(2020, 7, 23));
+    TEST_ASSERT_EQUAL_STRING("スポーツの日", PCHoliday::nameOfDay(2020, 7, 24));
+    TEST_ASSERT_EQUAL_STRING("山の日", PCHoliday::nameOfDay(2020, 8, 10));
+    TEST_ASSERT_NULL(PCHoliday::nameOfDay(2020, 7, 20));
+    TEST_ASSERT_NULL(PCHoliday::nameOfDay(2020, 8, 11));
+    TEST_ASSERT_NULL(PCHoliday::nameOfDay(2020, 10, 12));
+
+    TEST_ASSERT_EQUAL_STRING("海の日", PCHoliday::nameOfDay(2021, 7, 22));
+    TEST_ASSERT_EQUAL_STRING("スポーツの日", PCHoliday::nameOfDay(2021, 7, 23));
+    TEST_ASSERT_EQUAL_STRING("山の日", PCHoliday::nameOfDay(2021, 8, 8));
+    TEST_ASSERT_EQUAL_STRING(SUBSTITUTE_HOLIDAY, PCHoliday::nameOfDay(2021, 8, 9));
+    TEST_ASSERT_NULL(PCHoliday::nameOfDay(2021, 7, 19));
+    TEST_ASSERT_NULL(PCHoliday::nameOfDay(2021, 10, 11));
+
+    // Back to the rules from 2022
+    TEST_ASSERT_EQUAL_STRING("海の日", PCHoliday::nameOfDay(2022, 7, 18));
+    TEST_ASSERT_EQUAL_STRING("スポーツの日", PCHoliday::nameOfDay(2022, 10, 10));
+    TEST_ASSERT_EQUAL_STRING("山の日", PCHoliday::nameOfDay(2022, 8, 11));
+}
+
+// A day between Respect for the Aged Day and the autumnal equinox
+void test_citizens_holidays_in_september()
+{
+    TEST_ASSERT_EQUAL_STRING(CITIZENS_HOLIDAY, PCHoliday::nameOfDay(2009, 9, 22));
+    TEST_ASSERT_EQUAL_STRING(CITIZENS_HOLIDAY, PCHoliday::nameOfDay(2015, 9, 22));
+    TEST_ASSERT_EQUAL_STRING(CITIZENS_HOLIDAY, PCHoliday::nameOfDay(2026, 9, 22));
+    TEST_ASSERT_NULL(PCHoliday::nameOfDay(2020, 9, 23));
+}
+
+void test_equinox_days()
+{
+    TEST_ASSERT_EQUAL(20, PCHoliday::vernalEquinoxDay(2000));
+    TEST_ASSERT_EQUAL(21, PCHoliday::vernalEquinoxDay(2023));
+    TEST_ASSERT_EQUAL(20, PCHoliday::vernalEquinoxDay(2024));
+    TEST_ASSERT_EQUAL(23, PCHoliday::autumnalEquinoxDay(2000));
+    TEST_ASSERT_EQUAL(22, PCHoliday::autumnalEquinoxDay(2012));
+    TEST_ASSERT_EQUAL(22, PCHoliday::autumnalEquinoxDay(2024));
+}
+
+void test_overrides_add_and_remove_days()
+{
+    PCHoliday::setOverrides("20300102:Extra day\n20300101:-\n");
+    TEST_ASSERT_EQUAL_STRING("Extra day", PCHoliday::nameOfDay(2030, 1, 2));
+    TEST_ASSERT_NULL(PCHoliday::nameOfDay(2030, 1, 1));
+    TEST_ASSERT_EQUAL_STRING("元日", PCHoliday::nameOfDay(2031, 1, 1));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_holidays_from_2000_to_2050);
+    RUN_TEST(test_enthronement_days_of_2019);
+    RUN_TEST(test_olympic_days_of_2020_and_2021);
+    RUN_TEST(test_citizens_holidays_in_september);
+    RUN_TEST(test_equinox_days);
+    RUN_TEST(test_overrides_add_and_remove_days);
+    return UNITY_END();
+}
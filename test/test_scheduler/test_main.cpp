@@ -0,0 +1,362 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include "PCScheduler.h"
+
+#define SECONDS_IN_DAY 86400
+#define FIRST_WAKE (5 * 60) // the midnight wake of the day before
+#define BATTERY_FLOOR 3500
+
+// Replay of several weeks and its energy model. A wake brings WiFi up and
+// fetches the feeds, a refresh also redraws the e-paper. Charges in mAs.
+#define REPLAY_DAYS 35
+#define WAKE_CHARGE_MAS 450    // about 4.5 s at 100 mA
+#define REFRESH_CHARGE_MAS 300 // about 15 s at 20 mA
+#define SLEEP_CURRENT_UA 15
+#define BATTERY_CAPACITY_MAH 2000
+
+// A day with a morning meeting and a short afternoon call
+static const int eventStarts[] = {9 * 3600, 13 * 3600 + 30 * 60};
+static const int eventEnds[] = {10 * 3600, 14 * 3600};
+
+// Wake times of one simulated day, from the first wake to the first wake
+// after midnight. Feeds change once, at changeSeconds.
+static std::vector<int> replayDay(PCWakePolicy policy, uint32_t intervalMinutes, uint32_t maxBackoffMinutes, int changeSeconds, uint32_t batteryVoltage = 4000)
+{
+    PCScheduler::configure(policy, intervalMinutes, maxBackoffMinutes, BATTERY_FLOOR);
+    PCScheduler::clearBoundaries();
+    for (int i = 0; i < 2; i++)
+    {
+        PCScheduler::addBoundary(eventStarts[i]);
+        PCScheduler::addBoundary(eventEnds[i]);
+    }
+    // The first wake sees the feeds as changed, a new day is always drawn
+    PCScheduler::nextWakeSeconds(tm(), true, batteryVoltage);
+
+    std::vector<int> wakes;
+    int seconds = FIRST_WAKE;
+    int lastWake = 0;
+    while (seconds < SECONDS_IN_DAY)
+    {
+        wakes.push_back(seconds);
+        tm now = {};
+        now.tm_hour = seconds / 3600;
+        now.tm_min = (seconds % 3600) / 60;
+        now.tm_sec = seconds % 60;
+        boolean changed = (wakes.size() == 1) || (changeSeconds > lastWake && changeSeconds <= seconds);
+        lastWake = seconds;
+        seconds += PCScheduler::nextWakeSeconds(now, changed, batteryVoltage);
+    }
+    wakes.push_back(seconds);
+    return wakes;
+}
+
+static boolean wokeAt(const std::vector<int> &wakes, int seconds)
+{
+    return std::find(wakes.begin(), wakes.end(), seconds) != wakes.end();
+}
+
+struct PCReplay
+{
+    int wakes;
+    int refreshes;        // wakes that redraw: a new day or changed feeds
+    int changes;          // changes seen, several between two wakes count once
+    int totalDelay;       // seconds from each change to the wake that saw it
+    int maxDelay;
+    int shortestSleep;
+    int daysDrawn;        // days with a wake before MIDNIGHT_DRAW_SECONDS
+    int boundariesMissed; // event starts and ends without a wake at them
+};
+
+#define MIDNIGHT_DRAW_SECONDS (10 * 60)
+
+// Weekdays have the two events of eventStarts, weekends none
+static boolean isWorkday(int day)
+{
+    return day % 7 < 5;
+}
+
+// Feed changes of the replay in seconds from the start of day 0: up to
+// three a workday during office hours, at most one on a weekend day. The
+// last day has none, so the daily wake sees every change within the replay.
+static std::vector<int> changeSchedule()
+{
+    std::vector<int> changes;
+    uint32_t random = 12345;
+    for (int day = 0; day < REPLAY_DAYS - 1; day++)
+    {
+        random = random * 1103515245 + 12345;
+        int count = (random >> 16) % (isWorkday(day) ? 4 : 2);
+        for (int i = 0; i < count; i++)
+        {
+            random = random * 1103515245 + 12345;
+            changes.push_back(day * SECONDS_IN_DAY + 8 * 3600 + (random >> 16) % (11 * 3600));
+        }
+    }
+    std::sort(changes.begin(), changes.end());
+    return changes;
+}
+
+static PCReplay replay(PCWakePolicy policy, uint32_t intervalMinutes, uint32_t maxBackoffMinutes)
+{
+    PCScheduler::configure(policy, intervalMinutes, maxBackoffMinutes, BATTERY_FLOOR);
+    std::vector<int> changes = changeSchedule();
+    std::vector<int> wakes;
+    PCReplay result = {};
+    result.shortestSleep = SECONDS_IN_DAY;
+    size_t nextChange = 0;
+    int day = -1;
+    int seconds = FIRST_WAKE;
+    while (seconds < REPLAY_DAYS * SECONDS_IN_DAY)
+    {
+        wakes.push_back(seconds);
+        boolean newDay = seconds / SECONDS_IN_DAY != day;
+        if (newDay)
+        {
+            // A new day is parsed, which records its event boundaries
+            day = seconds / SECONDS_IN_DAY;
+            PCScheduler::clearBoundaries();
+            for (int i = 0; isWorkday(day) && i < 2; i++)
+            {
+                PCScheduler::addBoundary(eventStarts[i]);
+                PCScheduler::addBoundary(eventEnds[i]);
+            }
+            if (seconds % SECONDS_IN_DAY < MIDNIGHT_DRAW_SECONDS)
+                result.daysDrawn++;
+        }
+        boolean changed = false;
+        for (; nextChange < changes.size() && changes[nextChange] <= seconds; nextChange++)
+        {
+            int delay = seconds - changes[nextChange];
+            result.totalDelay += delay;
+            result.maxDelay = max(result.maxDelay, delay);
+            result.changes++;
+            changed = true;
+        }
+        result.wakes++;
+        if (newDay || changed)
+            result.refreshes++;
+        tm now = {};
+        now.tm_hour = (seconds % SECONDS_IN_DAY) / 3600;
+        now.tm_min = (seconds % 3600) / 60;
+        now.tm_sec = seconds % 60;
+        int sleep = PCScheduler::nextWakeSeconds(now, newDay || changed, 4000);
+        result.shortestSleep = min(result.shortestSleep, sleep);
+        seconds += sleep;
+    }
+    for (int d = 0; d < REPLAY_DAYS; d++)
+    {
+        for (int i = 0; isWorkday(d) && i < 2; i++)
+        {
+            result.boundariesMissed += !wokeAt(wakes, d * SECONDS_IN_DAY + eventStarts[i]);
+            result.boundariesMissed += !wokeAt(wakes, d * SECONDS_IN_DAY + eventEnds[i]);
+        }
+    }
+    return result;
+}
+
+// Average charge of a day in mAh, sleep current included
+static float chargePerDay(const PCReplay &result)
+{
+    float activeMAs = (float)result.wakes * WAKE_CHARGE_MAS + (float)result.refreshes * REFRESH_CHARGE_MAS;
+    return activeMAs / 3600 / REPLAY_DAYS + SLEEP_CURRENT_UA * 24 / 1000.0f;
+}
+
+static void summarize(const char *policy, const PCReplay &result)
+{
+    char message[160];
+    float perDay = chargePerDay(result);
+    snprintf(message, sizeof(message), "%-8s %5d wakes %4d refreshes %3d changes, delay avg %4d max %4d min, %5.1f mAh/day, %4d days on %d mAh",
+             policy, result.wakes, result.refreshes, result.changes, result.totalDelay / max(result.changes, 1) / 60, result.maxDelay / 60,
+             perDay, (int)(BATTERY_CAPACITY_MAH / perDay), BATTERY_CAPACITY_MAH);
+    TEST_MESSAGE(message);
+}
+
+static void report(const char *policy, const std::vector<int> &wakes)
+{
+    String message = String(policy) + ":";
+    for (int wake : wakes)
+    {
+        char time[12];
+        snprintf(time, sizeof(time), " %02d:%02d", (wake / 3600) % 24, (wake % 3600) / 60);
+        message += time;
+    }
+    TEST_MESSAGE(message.c_str());
+}
+
+// Each policy ends the day with the wake shortly after midnight
+static void assertEndsAfterMidnight(const std::vector<int> &wakes)
+{
+    TEST_ASSERT_EQUAL(SECONDS_IN_DAY + FIRST_WAKE, wakes.back());
+    for (size_t i = 1; i < wakes.size(); i++)
+    {
+        TEST_ASSERT_GREATER_OR_EQUAL(60, wakes[i] - wakes[i - 1]);
+    }
+}
+
+void setUp()
+{
+    HostState::reset();
+}
+
+void tearDown() {}
+
+void test_daily_wakes_once()
+{
+    std::vector<int> wakes = replayDay(WAKE_POLICY_DAILY, 60, 720, 11 * 3600);
+    report("daily", wakes);
+    TEST_ASSERT_EQUAL(2, wakes.size());
+    assertEndsAfterMidnight(wakes);
+    TEST_ASSERT_EQUAL_STRING("daily", PCScheduler::reason().c_str());
+}
+
+void test_interval_wakes_every_interval()
+{
+    std::vector<int> wakes = replayDay(WAKE_POLICY_INTERVAL, 60, 720, 11 * 3600);
+    report("interval", wakes);
+    assertEndsAfterMidnight(wakes);
+    TEST_ASSERT_EQUAL(25, wakes.size());
+    for (size_t i = 1; i + 1 < wakes.size(); i++)
+    {
+        TEST_ASSERT_EQUAL(3600, wakes[i] - wakes[i - 1]);
+    }
+    TEST_ASSERT_EQUAL_STRING("midnight", PCScheduler::reason().c_str());
+}
+
+void test_events_wakes_at_each_boundary()
+{
+    std::vector<int> wakes = replayDay(WAKE_POLICY_EVENTS, 60, 720, 11 * 3600);
+    report("events", wakes);
+    assertEndsAfterMidnight(wakes);
+    TEST_ASSERT_EQUAL(6, wakes.size());
+    for (int i = 0; i < 2; i++)
+    {
+        TEST_ASSERT_TRUE(wokeAt(wakes, eventStarts[i]));
+        TEST_ASSERT_TRUE(wokeAt(wakes, eventEnds[i]));
+    }
+}
+
+void test_adaptive_backs_off_and_keeps_boundaries()
+{
+    std::vector<int> wakes = replayDay(WAKE_POLICY_ADAPTIVE, 15, 240, 11 * 3600);
+    report("adaptive", wakes);
+    assertEndsAfterMidnight(wakes);
+    for (int i = 0; i < 2; i++)
+    {
+        TEST_ASSERT_TRUE(wokeAt(wakes, eventStarts[i]));
+        TEST_ASSERT_TRUE(wokeAt(wakes, eventEnds[i]));
+    }
+    // Unchanged feeds double the sleep up to maxBackoff, which no sleep exceeds
+    TEST_ASSERT_EQUAL(FIRST_WAKE + 15 * 60, wakes[1]);
+    TEST_ASSERT_EQUAL(FIRST_WAKE + 45 * 60, wakes[2]);
+    for (size_t i = 1; i + 1 < wakes.size(); i++)
+    {
+        TEST_ASSERT_LESS_OR_EQUAL(240 * 60, wakes[i] - wakes[i - 1]);
+    }
+    // The change at 11:00 is seen by the first wake after it, the sleep
+    // after that wake starts over at the interval
+    int seen = 0;
+    while (wakes[seen] < 11 * 3600)
+        seen++;
+    TEST_ASSERT_LESS_THAN(wakes.size() - 1, seen);
+    TEST_ASSERT_EQUAL(15 * 60, wakes[seen + 1] - wakes[seen]);
+}
+
+void test_adaptive_wakes_less_than_interval()
+{
+    std::vector<int> adaptive = replayDay(WAKE_POLICY_ADAPTIVE, 15, 240, 11 * 3600);
+    std::vector<int> interval = replayDay(WAKE_POLICY_INTERVAL, 15, 240, 11 * 3600);
+    TEST_ASSERT_LESS_THAN(interval.size() / 4, adaptive.size());
+}
+
+void test_low_battery_keeps_only_midnight()
+{
+    PCWakePolicy policies[] = {WAKE_POLICY_INTERVAL, WAKE_POLICY_EVENTS, WAKE_POLICY_ADAPTIVE};
+    for (PCWakePolicy policy : policies)
+    {
+        std::vector<int> wakes = replayDay(policy, 15, 240, 11 * 3600, BATTERY_FLOOR - 100);
+        TEST_ASSERT_EQUAL(2, wakes.size());
+        assertEndsAfterMidnight(wakes);
+        TEST_ASSERT_EQUAL_STRING("battery 3400mV", PCScheduler::reason().c_str());
+    }
+}
+
+// A failed wake sleeps as an unchanged wake would, and does not move the
+// backoff of the wakes after it
+void test_fallback_wake_keeps_the_backoff()
+{
+    PCScheduler::configure(WAKE_POLICY_ADAPTIVE, 15, 240, BATTERY_FLOOR);
+    PCScheduler::clearBoundaries();
+    tm now = {};
+    now.tm_hour = 8;
+    PCScheduler::nextWakeSeconds(now, true, 4000);
+    TEST_ASSERT_EQUAL(30 * 60, PCScheduler::fallbackWakeSeconds(now, 4000));
+    TEST_ASSERT_EQUAL(30 * 60, PCScheduler::fallbackWakeSeconds(now, 4000));
+    TEST_ASSERT_EQUAL(30 * 60, PCScheduler::nextWakeSeconds(now, false, 4000));
+
+    // Never the minimum sleep: the daily policy and a low battery wait for midnight
+    PCScheduler::configure(WAKE_POLICY_DAILY, 15, 240, BATTERY_FLOOR);
+    TEST_ASSERT_EQUAL(16 * 3600 + 5 * 60, PCScheduler::fallbackWakeSeconds(now, 4000));
+    PCScheduler::configure(WAKE_POLICY_INTERVAL, 15, 240, BATTERY_FLOOR);
+    TEST_ASSERT_EQUAL(16 * 3600 + 5 * 60, PCScheduler::fallbackWakeSeconds(now, BATTERY_FLOOR - 100));
+}
+
+// Five weeks of wakes under each policy, with the charge each one draws.
+// Every policy sees every change and draws every day, they differ in how
+// late a change shows and how much charge that costs.
+void test_replay_weeks_of_changes()
+{
+    PCReplay daily = replay(WAKE_POLICY_DAILY, 60, 720);
+    PCReplay interval = replay(WAKE_POLICY_INTERVAL, 15, 240);
+    PCReplay events = replay(WAKE_POLICY_EVENTS, 15, 240);
+    PCReplay adaptive = replay(WAKE_POLICY_ADAPTIVE, 15, 240);
+    summarize("daily", daily);
+    summarize("interval", interval);
+    summarize("events", events);
+    summarize("adaptive", adaptive);
+
+    int numberOfChanges = changeSchedule().size();
+    PCReplay *results[] = {&daily, &interval, &events, &adaptive};
+    for (PCReplay *result : results)
+    {
+        TEST_ASSERT_EQUAL(numberOfChanges, result->changes);
+        TEST_ASSERT_EQUAL(REPLAY_DAYS, result->daysDrawn);
+        TEST_ASSERT_GREATER_OR_EQUAL(60, result->shortestSleep);
+        TEST_ASSERT_LESS_OR_EQUAL(SECONDS_IN_DAY, result->maxDelay);
+    }
+    TEST_ASSERT_EQUAL(REPLAY_DAYS, daily.wakes);
+    TEST_ASSERT_EQUAL(REPLAY_DAYS, daily.refreshes);
+    TEST_ASSERT_EQUAL(0, events.boundariesMissed);
+    TEST_ASSERT_EQUAL(0, adaptive.boundariesMissed);
+    TEST_ASSERT_LESS_OR_EQUAL(15 * 60, interval.maxDelay);
+
+    // Adaptive wakes at a fraction of the interval cost, and shows changes
+    // hours earlier than the daily wake on average
+    TEST_ASSERT_LESS_THAN(chargePerDay(interval) / 2, chargePerDay(adaptive));
+    TEST_ASSERT_LESS_THAN(daily.totalDelay / 4, adaptive.totalDelay);
+    TEST_ASSERT_LESS_OR_EQUAL(240 * 60, adaptive.maxDelay);
+}
+
+void test_policy_names()
+{
+    TEST_ASSERT_EQUAL(WAKE_POLICY_INTERVAL, PCScheduler::policyFromString("interval"));
+    TEST_ASSERT_EQUAL(WAKE_POLICY_EVENTS, PCScheduler::policyFromString("events"));
+    TEST_ASSERT_EQUAL(WAKE_POLICY_ADAPTIVE, PCScheduler::policyFromString("adaptive"));
+    TEST_ASSERT_EQUAL(WAKE_POLICY_DAILY, PCScheduler::policyFromString("daily"));
+    TEST_ASSERT_EQUAL(WAKE_POLICY_DAILY, PCScheduler::policyFromString(""));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_daily_wakes_once);
+    RUN_TEST(test_interval_wakes_every_interval);
+    RUN_TEST(test_events_wakes_at_each_boundary);
+    RUN_TEST(test_adaptive_backs_off_and_keeps_boundaries);
+    RUN_TEST(test_adaptive_wakes_less_than_interval);
+    RUN_TEST(test_low_battery_keeps_only_midnight);
+    RUN_TEST(test_fallback_wake_keeps_the_backoff);
+    RUN_TEST(test_replay_weeks_of_changes);
+    RUN_TEST(test_policy_names);
+    return UNITY_END();
+}
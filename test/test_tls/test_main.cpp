@@ -0,0 +1,256 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <unity.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include "PCArena.h"
+#include "PCConnection.h"
+#include "PCTLSSessions.h"
+
+#define SERVER_HOST "calendar.test"
+#define ROUNDS 5
+
+// A TLS 1.2 server on 127.0.0.1 with a self-signed certificate for
+// SERVER_HOST. It answers every request of a keep-alive connection with
+// "hello" and issues session tickets, as feed servers do. Each server has
+// a key, certificate and ticket keys of its own, and takes port when given
+// one, as a restarted feed server would.
+class LocalServer
+{
+public:
+    LocalServer(int connections, uint16_t port = 0)
+    {
+        EVP_PKEY *key = EVP_RSA_gen(2048);
+        X509 *certificate = X509_new();
+        X509_set_version(certificate, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+        X509_gmtime_adj(X509_getm_notBefore(certificate), -3600);
+        X509_gmtime_adj(X509_getm_notAfter(certificate), 86400);
+        X509_set_pubkey(certificate, key);
+        X509_NAME *name = X509_get_subject_name(certificate);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *)SERVER_HOST, -1, -1, 0);
+        X509_set_issuer_name(certificate, name);
+        X509_EXTENSION *alternativeName = X509V3_EXT_conf_nid(NULL, NULL, NID_subject_alt_name, "DNS:" SERVER_HOST);
+        X509_add_ext(certificate, alternativeName, -1);
+        X509_EXTENSION_free(alternativeName);
+        X509_sign(certificate, key, EVP_sha256());
+
+        BIO *pem = BIO_new(BIO_s_mem());
+        PEM_write_bio_X509(pem, certificate);
+        char *text;
+        long length = BIO_get_mem_data(pem, &text);
+        rootCA.assign(text, length);
+        BIO_free(pem);
+
+        _context = SSL_CTX_new(TLS_server_method());
+        SSL_CTX_set_max_proto_version(_context, TLS1_2_VERSION);
+        SSL_CTX_use_certificate(_context, certificate);
+        SSL_CTX_use_PrivateKey(_context, key);
+        X509_free(certificate);
+        EVP_PKEY_free(key);
+
+        _socket = socket(AF_INET, SOCK_STREAM, 0);
+        int enable = 1;
+        setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        struct sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+        socklen_t addressLength = sizeof(address);
+        bind(_socket, (struct sockaddr *)&address, sizeof(address));
+        listen(_socket, 4);
+        getsockname(_socket, (struct sockaddr *)&address, &addressLength);
+        this->port = ntohs(address.sin_port);
+        _thread = std::thread(&LocalServer::serve, this, connections);
+    }
+
+    ~LocalServer()
+    {
+        _thread.join();
+        close(_socket);
+        SSL_CTX_free(_context);
+    }
+
+    String url() { return "https://" SERVER_HOST ":" + String(port) + "/feed.ics"; }
+
+    std::string rootCA;
+    uint16_t port;
+
+private:
+    void serve(int connections)
+    {
+        for (int i = 0; i < connections; i++)
+        {
+            int connection = accept(_socket, NULL, NULL);
+            SSL *ssl = SSL_new(_context);
+            SSL_set_fd(ssl, connection);
+            std::string request;
+            char buffer[1024];
+            int received;
+            while (SSL_accept(ssl) == 1 && (received = SSL_read(ssl, buffer, sizeof(buffer))) > 0)
+            {
+                request.append(buffer, received);
+                if (request.find("\r\n\r\n") == std::string::npos)
+                    continue;
+                request.clear();
+                const char *response = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello";
+                SSL_write(ssl, response, strlen(response));
+            }
+            SSL_free(ssl);
+            close(connection);
+        }
+    }
+
+    SSL_CTX *_context;
+    int _socket;
+    std::thread _thread;
+};
+
+void setUp()
+{
+    HostState::reset();
+    WiFi.connected = true;
+    WiFi.hosts[SERVER_HOST] = IPAddress(127, 0, 0, 1);
+    PCConnection::setDNSTTL(3600);
+    PCTLSSessions::clear();
+}
+
+void tearDown()
+{
+    PCConnection::closeAll();
+    PCArena::end();
+}
+
+// Opens the feed of server, reads its body and closes the connection as
+// the end of a wake does, the time of the handshake in microseconds
+static unsigned long fetch(LocalServer &server)
+{
+    unsigned long startMicros = micros();
+    WiFiClient *client = PCConnection::open(server.url(), server.rootCA.c_str());
+    unsigned long handshakeMicros = micros() - startMicros;
+    TEST_ASSERT_NOT_NULL(client);
+    PCHTTPResponse response;
+    TEST_ASSERT_TRUE(PCConnection::get(client, server.url(), response));
+    TEST_ASSERT_EQUAL(HTTP_STATUS_OK, response.statusCode);
+    char body[8] = {};
+    TEST_ASSERT_EQUAL(5, response.contentLength);
+    TEST_ASSERT_EQUAL(5, client->readBytes(body, response.contentLength));
+    TEST_ASSERT_EQUAL_STRING("hello", body);
+    PCConnection::closeAll();
+    return handshakeMicros;
+}
+
+// Each wake forgets its sessions for the full handshakes, then keeps them
+// for the resumed ones
+void test_saved_session_is_resumed()
+{
+    LocalServer server(2 * ROUNDS);
+    int resumed = PCConnection::numberOfResumedHandshakes();
+    unsigned long fullMicros = 0;
+    for (int i = 0; i < ROUNDS; i++)
+    {
+        PCTLSSessions::clear();
+        fullMicros += fetch(server);
+        TEST_ASSERT_FALSE(PCConnection::lastHandshakeWasResumed());
+    }
+    unsigned long resumedMicros = 0;
+    for (int i = 0; i < ROUNDS; i++)
+    {
+        resumedMicros += fetch(server);
+        TEST_ASSERT_TRUE(PCConnection::lastHandshakeWasResumed());
+    }
+    TEST_ASSERT_EQUAL(resumed + ROUNDS, PCConnection::numberOfResumedHandshakes());
+
+    char message[96];
+    snprintf(message, sizeof(message), "handshake on 127.0.0.1: full %lu us, resumed %lu us", fullMicros / ROUNDS,
+             resumedMicros / ROUNDS);
+    TEST_MESSAGE(message);
+}
+
+// A restarted server no longer knows the session, the resumption becomes
+// a full handshake
+void test_unknown_session_falls_back_to_full_handshake()
+{
+    uint16_t port;
+    {
+        LocalServer server(1);
+        port = server.port;
+        fetch(server);
+    }
+    LocalServer server(2, port);
+    fetch(server);
+    TEST_ASSERT_FALSE(PCConnection::lastHandshakeWasResumed());
+    fetch(server);
+    TEST_ASSERT_TRUE(PCConnection::lastHandshakeWasResumed());
+}
+
+// A full handshake that fails verification drops the session. The cached
+// address is looked up again and connected once more, so the server
+// answers two connections.
+void test_failed_handshake_forgets_the_session()
+{
+    uint8_t buffer[TLS_SESSION_MAX_BYTES];
+    std::string rootCA;
+    uint16_t port;
+    {
+        LocalServer server(1);
+        rootCA = server.rootCA;
+        port = server.port;
+        fetch(server);
+    }
+    TEST_ASSERT_GREATER_THAN(0, PCTLSSessions::load(SERVER_HOST, port, buffer, sizeof(buffer)));
+    LocalServer server(2, port);
+    TEST_ASSERT_NULL(PCConnection::open(server.url(), rootCA.c_str()));
+    TEST_ASSERT_EQUAL(0, PCTLSSessions::load(SERVER_HOST, port, buffer, sizeof(buffer)));
+}
+
+void test_sessions_are_kept_per_host_and_port()
+{
+    uint8_t session[] = {1, 2, 3};
+    uint8_t buffer[TLS_SESSION_MAX_BYTES];
+    TEST_ASSERT_TRUE(PCTLSSessions::save("a.example.com", 443, session, sizeof(session)));
+    TEST_ASSERT_EQUAL(0, PCTLSSessions::load("a.example.com", 8443, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL(3, PCTLSSessions::load("A.example.com", 443, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_MEMORY(session, buffer, sizeof(session));
+    // Too large for a slot, or for the buffer of the caller
+    TEST_ASSERT_FALSE(PCTLSSessions::save("b.example.com", 443, buffer, TLS_SESSION_MAX_BYTES + 1));
+    TEST_ASSERT_EQUAL(0, PCTLSSessions::load("a.example.com", 443, buffer, 2));
+
+    PCTLSSessions::forget("a.example.com", 443);
+    TEST_ASSERT_EQUAL(0, PCTLSSessions::load("a.example.com", 443, buffer, sizeof(buffer)));
+}
+
+// A host saving again keeps its slot, a new host takes the oldest one.
+// Sessions are saved with the time in seconds, hence the delays.
+void test_oldest_session_is_replaced()
+{
+    uint8_t session[] = {1};
+    uint8_t buffer[TLS_SESSION_MAX_BYTES];
+    TEST_ASSERT_TRUE(PCTLSSessions::save("a.example.com", 443, session, 1));
+    delay(1100);
+    TEST_ASSERT_TRUE(PCTLSSessions::save("b.example.com", 443, session, 1));
+    delay(1100);
+    TEST_ASSERT_TRUE(PCTLSSessions::save("a.example.com", 443, session, 1));
+    TEST_ASSERT_TRUE(PCTLSSessions::save("c.example.com", 443, session, 1));
+    TEST_ASSERT_EQUAL(1, PCTLSSessions::load("a.example.com", 443, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL(0, PCTLSSessions::load("b.example.com", 443, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL(1, PCTLSSessions::load("c.example.com", 443, buffer, sizeof(buffer)));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_saved_session_is_resumed);
+    RUN_TEST(test_unknown_session_falls_back_to_full_handshake);
+    RUN_TEST(test_failed_handshake_forgets_the_session);
+    RUN_TEST(test_sessions_are_kept_per_host_and_port);
+    RUN_TEST(test_oldest_session_is_replaced);
+    return UNITY_END();
+}
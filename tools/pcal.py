@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+"""Compile iCalendar feeds into the PCAL month payload read by PCCompactReader.
+
+The host does the work every device would repeat: TLS to the calendar
+servers, parsing, recurrence expansion and timezone conversion. Devices fetch
+the result over plain HTTP on the LAN with a feed line such as
+    iCalendarURL:http://192.168.1.10:8080/work.pcal
+
+Usage:
+    pio run -e pcal
+    python3 tools/pcal.py compile --timezone 9 -o work.pcal https://example.com/a.ics b.ics
+    python3 tools/pcal.py serve --timezone 9 --port 8080 work=https://example.com/a.ics,b.ics
+    python3 tools/pcal.py dump work.pcal
+
+Parsing and recurrence expansion are done by the native compiler of
+tools/pcal, built from PCEvent and PCRecurrence, so a payload holds the
+events the device would expand itself. This script downloads the sources,
+runs the compiler and serves or prints its payloads. The layout is
+PCCompactHeader and PCCompactEvent in src/PCCompact.h.
+"""
+
+import argparse
+import http.server
+import os
+import re
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+import urllib.request
+
+MAGIC = 0x4C414350  # "PCAL"
+VERSION = 1
+HEADER = struct.Struct("<IHHiIIHHIII")
+EVENT = struct.Struct("<IIIIIB3x")
+DAY_EVENT = 0x01
+HOLIDAY = 0x02
+
+COMPILER = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), os.pardir, ".pio", "build", "pcal", "program"))
+
+
+def fnv1a(data, value=2166136261):
+    for byte in data:
+        value = ((value ^ byte) * 16777619) & 0xFFFFFFFF
+    return value
+
+
+def fetch_source(source, directory, number):
+    """Local path of a source, URLs are downloaded into directory."""
+    if not re.match(r"https?://", source):
+        return source
+    path = os.path.join(directory, "source%d.ics" % number)
+    with urllib.request.urlopen(source, timeout=60) as response, open(path, "wb") as file:
+        shutil.copyfileobj(response, file)
+    return path
+
+
+def build_payload(sources, holiday_sources, timezone_hours, year, month, compiler=COMPILER):
+    if not os.path.exists(compiler):
+        raise OSError("no compiler at %s, build it with \"pio run -e pcal\"" % compiler)
+    with tempfile.TemporaryDirectory() as directory:
+        command = [compiler, "--timezone", str(timezone_hours), "--month", "%d%02d" % (year, month)]
+        number = 0
+        files = []
+        for source in sources:
+            files.append(fetch_source(source, directory, number))
+            number += 1
+        for source in holiday_sources:
+            command += ["--holidays", fetch_source(source, directory, number)]
+            number += 1
+        output = os.path.join(directory, "payload.pcal")
+        result = subprocess.run(command + ["-o", output] + files, stderr=subprocess.PIPE, text=True)
+        if result.returncode != 0:
+            raise ValueError(result.stderr.strip() or "compiler failed")
+        with open(output, "rb") as file:
+            return file.read()
+
+
+def current_month(timezone_hours):
+    now = time.gmtime(time.time() + timezone_hours * 3600)
+    return now.tm_year, now.tm_mon
+
+
+def read_payload(data):
+    magic, version, event_size, timezone_minutes, month, first_day, number_of_days, _, number_of_events, title_bytes, content_hash = HEADER.unpack_from(data, 0)
+    if magic != MAGIC or version != VERSION or event_size != EVENT.size:
+        raise ValueError("not a PCAL payload")
+    titles = data[HEADER.size:HEADER.size + title_bytes]
+    offset = HEADER.size + title_bytes + (number_of_days + 1) * 4
+    events = []
+    for index in range(number_of_events):
+        start, duration, title, uid_hash, recurrence_id, flags = EVENT.unpack_from(data, offset + index * EVENT.size)
+        name = titles[title:titles.index(b"\0", title)].decode("utf-8", "replace")
+        events.append((start, duration, name, uid_hash, recurrence_id, flags))
+    if fnv1a(data[HEADER.size:]) != content_hash:
+        print("content hash does not match", file=sys.stderr)
+    return month, timezone_minutes, events
+
+
+def dump(arguments):
+    with open(arguments.file, "rb") as file:
+        month, timezone_minutes, events = read_payload(file.read())
+    print("month %d, UTC%+.1f, %d events" % (month, timezone_minutes / 60, len(events)))
+    for start, duration, title, uid_hash, recurrence_id, flags in events:
+        shown = "%Y-%m-%d" if flags & DAY_EVENT else "%Y-%m-%d %H:%M"
+        print("%-16s %6d min %s%s" % (time.strftime(shown, time.gmtime(start)), duration // 60,
+                                     "[holiday] " if flags & HOLIDAY else "", title))
+
+
+def compile_command(arguments):
+    year, month = divmod(arguments.month, 100) if arguments.month else current_month(arguments.timezone)
+    try:
+        payload = build_payload(arguments.sources, arguments.holidays, arguments.timezone, year, month, arguments.compiler)
+    except (OSError, ValueError) as error:
+        sys.exit(str(error))
+    with open(arguments.output, "wb") as file:
+        file.write(payload)
+    print("%s: %d bytes" % (arguments.output, len(payload)), file=sys.stderr)
+
+
+class PayloadCache:
+    """Payloads by name, built again after the refresh interval or a new month."""
+
+    def __init__(self, feeds, holidays, timezone_hours, refresh_minutes, compiler):
+        self.feeds = feeds
+        self.holidays = holidays
+        self.compiler = compiler
+        self.timezone_hours = timezone_hours
+        self.refresh_seconds = refresh_minutes * 60
+        self.payloads = {}
+        self.lock = threading.Lock()
+
+    def get(self, name):
+        if name not in self.feeds:
+            return None
+        with self.lock:
+            year, month = current_month(self.timezone_hours)
+            built = self.payloads.get(name)
+            if built is None or built[1] != (year, month) or time.time() - built[0] >= self.refresh_seconds:
+                try:
+                    payload = build_payload(self.feeds[name], self.holidays, self.timezone_hours, year, month, self.compiler)
+                    built = (time.time(), (year, month), payload)
+                    self.payloads[name] = built
+                except (OSError, ValueError) as error:
+                    # The last payload stays served while a source is down
+                    print("%s: %s" % (name, error), file=sys.stderr)
+                    if built is None:
+                        return None
+            return built[2]
+
+
+def serve(arguments):
+    feeds = {}
+    for item in arguments.feeds:
+        name, _, sources = item.partition("=")
+        feeds[name] = [source for source in sources.split(",") if source]
+    cache = PayloadCache(feeds, arguments.holidays, arguments.timezone, arguments.refresh, arguments.compiler)
+
+    class Handler(http.server.BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"  # keep-alive, as PCConnection asks
+
+        def do_GET(self):
+            name = self.path.lstrip("/")
+            payload = cache.get(name[:-len(".pcal")]) if name.endswith(".pcal") else None
+            if payload is None:
+                self.send_error(404)
+                return
+            self.send_response(200)
+            self.send_header("Content-Type", "application/octet-stream")
+            self.send_header("Content-Length", str(len(payload)))
+            self.end_headers()
+            self.wfile.write(payload)
+
+    server = http.server.ThreadingHTTPServer((arguments.bind, arguments.port), Handler)
+    print("serving %s on port %d" % (", ".join(name + ".pcal" for name in feeds), arguments.port), file=sys.stderr)
+    server.serve_forever()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    compile_parser = commands.add_parser("compile", help="write one payload")
+    compile_parser.add_argument("sources", nargs="+", help="iCalendar URLs or files")
+    compile_parser.add_argument("-o", "--output", required=True)
+    compile_parser.add_argument("--month", type=int, help="YYYYMM, the current month by default")
+    compile_parser.set_defaults(function=compile_command)
+
+    serve_parser = commands.add_parser("serve", help="serve payloads over HTTP")
+    serve_parser.add_argument("feeds", nargs="+", help="NAME=SOURCE[,SOURCE...], served as /NAME.pcal")
+    serve_parser.add_argument("--bind", default="0.0.0.0")
+    serve_parser.add_argument("--port", type=int, default=8080)
+    serve_parser.add_argument("--refresh", type=int, default=15, help="minutes a payload is served before it is built again")
+    serve_parser.set_defaults(function=serve)
+
+    for command in (compile_parser, serve_parser):
+        command.add_argument("--timezone", type=float, default=0.0, help="hours, as timezone in settings.txt")
+        command.add_argument("--holidays", action="append", default=[], help="source whose events are holidays")
+        command.add_argument("--compiler", default=COMPILER, help="the native compiler, built by \"pio run -e pcal\"")
+
+    dump_parser = commands.add_parser("dump", help="print a payload")
+    dump_parser.add_argument("file")
+    dump_parser.set_defaults(function=dump)
+
+    arguments = parser.parse_args()
+    arguments.function(arguments)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,114 @@
+// Host compiler of PCAL month payloads, built with "pio run -e pcal" into
+// .pio/build/pcal/program and run by tools/pcal.py. It parses the feeds
+// with PCEvent and expands recurrences with PCRecurrence, as the device
+// would, on test/support in place of the Arduino core.
+//
+// Usage:
+//   program --timezone 9 --month 202603 [--holidays FILE]... -o OUTPUT FILE...
+// Sources are local iCalendar files, pcal.py downloads URLs first.
+
+#include <Arduino.h>
+#include <SD_MMC.h>
+#include <fstream>
+#include <sstream>
+
+#include "PCArena.h"
+#include "PCCompact.h"
+#include "PCEvent.h"
+
+static void usage()
+{
+    fprintf(stderr, "usage: pcal --timezone HOURS --month YYYYMM [--holidays FILE]... -o OUTPUT FILE...\n");
+}
+
+// The shim's SD card holds each source, so PCEvent reads it as a file: feed
+static boolean loadSource(const char *path, int number, boolean holiday)
+{
+    std::ifstream source(path, std::ios::binary);
+    if (!source)
+    {
+        fprintf(stderr, "%s: cannot be read\n", path);
+        return false;
+    }
+    std::stringstream content;
+    content << source.rdbuf();
+    std::string text = content.str();
+    String cardPath = "/source" + String(number) + ".ics";
+    File file = SD_MMC.open(cardPath, FILE_WRITE, true);
+    file.write((const uint8_t *)text.data(), text.size());
+    file.close();
+    if (!PCEvent::loadICalendarFile("file:" + cardPath, holiday))
+    {
+        fprintf(stderr, "%s: not an iCalendar feed\n", path);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    float timezone = 0;
+    int month = 0;
+    const char *output = NULL;
+    std::vector<const char *> sources;
+    std::vector<const char *> holidays;
+    for (int i = 1; i < argc; i++)
+    {
+        String argument = argv[i];
+        boolean hasValue = i + 1 < argc;
+        if (argument == "--timezone" && hasValue)
+            timezone = atof(argv[++i]);
+        else if (argument == "--month" && hasValue)
+            month = atoi(argv[++i]);
+        else if (argument == "--holidays" && hasValue)
+            holidays.push_back(argv[++i]);
+        else if ((argument == "-o" || argument == "--output") && hasValue)
+            output = argv[++i];
+        else if (argument.startsWith("-"))
+        {
+            usage();
+            return 2;
+        }
+        else
+            sources.push_back(argv[i]);
+    }
+    if (output == NULL || month / 100 < 1970 || month % 100 < 1 || month % 100 > 12 || sources.empty())
+    {
+        usage();
+        return 2;
+    }
+
+    HostState::hasPSRAM = true;
+    PCArena::begin();
+    PCEvent::defaultTimezone = timezone;
+    tm firstDay = {};
+    firstDay.tm_year = month / 100 - 1900;
+    firstDay.tm_mon = month % 100 - 1;
+    firstDay.tm_mday = 1;
+    PCEvent::setTimeinfo(firstDay);
+
+    int number = 0;
+    for (const char *source : sources)
+    {
+        if (!loadSource(source, number++, false))
+            return 1;
+    }
+    for (const char *source : holidays)
+    {
+        if (!loadSource(source, number++, true))
+            return 1;
+    }
+    PCEvent::buildEvents();
+    std::vector<uint8_t> payload = PCCompactWriter::build();
+    PCEvent::releaseEvents();
+    PCArena::end();
+
+    FILE *file = fopen(output, "wb");
+    if (file == NULL || fwrite(payload.data(), 1, payload.size(), file) != payload.size() || fclose(file) != 0)
+    {
+        fprintf(stderr, "%s: cannot be written\n", output);
+        return 1;
+    }
+    fprintf(stderr, "%s: %u bytes\n", output, (unsigned int)payload.size());
+    return 0;
+}
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""Decode the binary log ring written by PCLog (log.bin on the SD card).
+
+Usage:
+    python3 tools/pclog.py log.bin          # text, oldest first
+    python3 tools/pclog.py --csv log.bin    # CSV with raw values
+"""
+
+import argparse
+import csv
+import struct
+import sys
+import time
+
+SECTOR_SIZE = 512
+HEADER = struct.Struct("<IHHIII12x")
+RECORD = struct.Struct("<IIIBBH4i")
+MAGIC = 0x474C4350  # "PCLG"
+
+LEVELS = {1: "ERROR", 2: "INFO", 3: "VERBOSE"}
+
+# Same codes as PCLogCode in src/PCLog.h
+FORMATS = {
+    1: ("boot", "wakeup cause {0}, wakes {1}"),
+    2: ("wifi", "connected {2} in {0} ms, fast {1}"),
+    3: ("feed", "feed {0} loaded {1} in {2} ms"),
+    4: ("build", "{0} events, {1} duplicates, {2} changed feeds, {3} over the per-day limit"),
+    5: ("skip", "drawing skipped, {0} of {1} wakes"),
+    6: ("display", "{0} BUSY waits, {1} ms"),
+    7: ("frame", "stored frame {0}, offline wake {1}"),
+    8: ("arena", "peak {0} of {1} bytes, {2} allocations, {3} bytes overflowed"),
+    9: ("sleep", "sleep {0} s after {1} ms awake"),
+    10: ("settings", "settings not found"),
+    11: ("epd", "e-Paper init failed: {0}"),
+    12: ("memory", "phase {0} over budget: {1} free, {2} block, {3} needed"),
+    13: ("clock", "clock stepped {0} ms, drift {1} ppm, woke {2} ms off, SNTP {3}"),
+    14: ("budget", "phase {0} index {1} out of budget after {2} ms, {3} bytes"),
+    15: ("dropped", "{0} records dropped"),
+    16: ("graph", "tasks took {0} ms for {1} ms of work, critical path {2} ms (tasks {3:#x})"),
+}
+
+
+def read_records(data):
+    magic, version, record_size, capacity, next_index, next_sequence = HEADER.unpack_from(data, 0)
+    if magic != MAGIC or record_size != RECORD.size:
+        raise ValueError("not a PCLog file")
+    records = []
+    for index in range(capacity):
+        offset = SECTOR_SIZE + index * record_size
+        if offset + record_size > len(data):
+            break
+        record = RECORD.unpack_from(data, offset)
+        if record[0] != 0:
+            records.append(record)
+    records.sort(key=lambda record: record[0])
+    return records
+
+
+def format_time(seconds):
+    # Clocks before 2020 were never set
+    if seconds < 1577836800:
+        return "-"
+    return time.strftime("%Y-%m-%d %H:%M:%S", time.gmtime(seconds))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("file")
+    parser.add_argument("--csv", action="store_true", help="write CSV instead of text")
+    arguments = parser.parse_args()
+
+    with open(arguments.file, "rb") as file:
+        records = read_records(file.read())
+
+    if arguments.csv:
+        writer = csv.writer(sys.stdout)
+        writer.writerow(["sequence", "time", "millis", "wake", "level", "code", "value0", "value1", "value2", "value3"])
+        for sequence, seconds, millis, level, code, wake, *values in records:
+            name = FORMATS.get(code, (str(code), ""))[0]
+            writer.writerow([sequence, format_time(seconds), millis, wake, LEVELS.get(level, level), name, *values])
+        return
+
+    for sequence, seconds, millis, level, code, wake, *values in records:
+        name, message = FORMATS.get(code, (str(code), "{0} {1} {2} {3}"))
+        print("%6d %s %8d #%-5d %-7s %-8s %s" % (sequence, format_time(seconds), millis, wake,
+                                                 LEVELS.get(level, level), name, message.format(*values)))
+
+
+if __name__ == "__main__":
+    main()